@@ -0,0 +1,764 @@
+/* archive.c: Storing many users' solution files with shared bodies.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<errno.h>
+#ifdef WIN32
+#include	<io.h>
+#else
+#include	<unistd.h>
+#endif
+#include	"defs.h"
+#include	"err.h"
+#include	"fileio.h"
+#include	"series.h"
+#include	"solution.h"
+#include	"archive.h"
+
+/*
+ * The following is a description of the archive file format. As with
+ * the solution files, numeric values are stored in little-endian
+ * order.
+ *
+ * The header is eight bytes long, and contains the following values:
+ *
+ * HEADER
+ *  0-3   signature bytes (35 33 9B 9A)
+ *   4    format version (currently always one)
+ *  5-7   other options (currently always zero)
+ *
+ * After the header are chunks, in the order that they were added to
+ * the archive. Each chunk begins with the following values:
+ *
+ * PER CHUNK
+ *   0    chunk type (1=solution body, 2=manifest)
+ *  1-4   size of the remainder of the chunk
+ *
+ * A solution body holds one solution, exactly as it appears in a
+ * solution file after the offset field:
+ *
+ * BODY
+ *  0-3   hash value of the level's data (the low 32 bits)
+ *  4-7   hash value of the solution data
+ *  8-xx  solution data
+ *
+ * A manifest holds one user's solution file for one level set, with
+ * each solution replaced by a reference to its body:
+ *
+ * MANIFEST
+ *   0    length of the user's name
+ *  1-xx  the user's name
+ *   ..   length of the level set's name, then the name
+ *   ..   ruleset (1=Lynx, 2=MS)
+ *   ..   other options from the solution file's header (two bytes)
+ *   ..   count of extra header bytes, then the bytes themselves
+ *   ..   count of levels (four bytes), then for each level:
+ *        0-1   level number
+ *        2-5   level password
+ *        6-9   offset of the level's body chunk from the start of
+ *              the archive, or zero if there is no solution
+ *
+ * Chunks are only ever appended to an archive. A body is stored only
+ * once, however many manifests refer to it, and a manifest supersedes
+ * any earlier one for the same user and level set. A chunk that runs past
+ * the end of the file is the remains of an interrupted update, and it
+ * is ignored and overwritten.
+ */
+
+/* The signature bytes of the archive files.
+ */
+#define	ARCSIG		0x9A9B3335UL
+
+/* The version of the format that is written.
+ */
+#define	ARCVERSION	1
+
+/* The chunk types.
+ */
+#define	CHUNK_BODY	1
+#define	CHUNK_MANIFEST	2
+
+/* The size of a chunk's type and size fields, and the offset of the
+ * solution data within a body chunk.
+ */
+#define	CHUNK_HEADSIZE	5
+#define	BODY_DATA	(CHUNK_HEADSIZE + 8)
+
+/* The archive records hash values as 32 bits, but a level's hash
+ * value can be wider on some platforms.
+ */
+#define	archash(h)	((h) & 0xFFFFFFFFUL)
+
+/* One of the solution bodies stored in an archive.
+ */
+typedef	struct archivebody {
+    unsigned long	levelhash;	/* the hash value of the level */
+    unsigned long	datahash;	/* the hash value of the solution */
+    unsigned long	size;		/* the size of the solution data */
+    long		offset;		/* where the body's chunk begins */
+} archivebody;
+
+/* One level's entry in a manifest.
+ */
+typedef	struct manifestentry {
+    unsigned short	number;		/* the level's number */
+    char		passwd[5];	/* the level's password */
+    unsigned long	offset;		/* the body's chunk, or zero */
+} manifestentry;
+
+/* The contents of a manifest.
+ */
+typedef	struct manifest {
+    int			ruleset;	/* the ruleset of the level set */
+    unsigned short	flags;		/* the solution header's options */
+    unsigned char	extrasize;	/* size of extra header bytes */
+    unsigned char	extra[256];	/* extra solution header bytes */
+    unsigned long	count;		/* the number of entries */
+    manifestentry      *entries;	/* the levels */
+} manifest;
+
+/* An open archive.
+ */
+typedef	struct archive {
+    fileinfo		file;		/* the archive file */
+    long		end;		/* the end of the last intact chunk */
+    long		manifest;	/* the manifest being sought, or 0 */
+    int			bodycount;	/* number of bodies in the list */
+    int			bodiesallocated; /* size of the bodies array */
+    archivebody	       *bodies;		/* the bodies in the archive */
+    int			indexsize;	/* size of index (a power of two) */
+    int		       *index;		/* hash table of bodies, or -1 */
+} archive;
+
+/* Calculate the hash value that a solution body is stored under.
+ */
+static unsigned long hashsolution(unsigned char const *data,
+				  unsigned long size)
+{
+    unsigned long	h = 2166136261UL;
+    unsigned long	i;
+
+    for (i = 0 ; i < size ; ++i)
+	h = archash((h ^ data[i]) * 16777619UL);
+    return h;
+}
+
+/*
+ * The index of solution bodies.
+ */
+
+/* Return the slot in the index where the search for a body with the
+ * given hash values starts.
+ */
+static int hashslot(archive const *arc, unsigned long levelhash,
+		    unsigned long datahash)
+{
+    return (int)((levelhash * 31 + datahash) & (arc->indexsize - 1));
+}
+
+/* Recreate the index with room for twice as many bodies as the list
+ * currently holds.
+ */
+static void rebuildindex(archive *arc)
+{
+    int	mask, slot, i;
+
+    arc->indexsize = arc->indexsize ? arc->indexsize : 256;
+    while (arc->indexsize < arc->bodycount * 2)
+	arc->indexsize *= 2;
+    x_alloc(arc->index, arc->indexsize * sizeof *arc->index);
+    for (i = 0 ; i < arc->indexsize ; ++i)
+	arc->index[i] = -1;
+    mask = arc->indexsize - 1;
+    for (i = 0 ; i < arc->bodycount ; ++i) {
+	slot = hashslot(arc, arc->bodies[i].levelhash,
+			arc->bodies[i].datahash);
+	while (arc->index[slot] >= 0)
+	    slot = (slot + 1) & mask;
+	arc->index[slot] = i;
+    }
+}
+
+/* Add a body to the list, and to the index.
+ */
+static void addbody(archive *arc, unsigned long levelhash,
+		    unsigned long datahash, unsigned long size, long offset)
+{
+    archivebody	       *body;
+    int			mask, slot;
+
+    if (arc->bodycount >= arc->bodiesallocated) {
+	arc->bodiesallocated = arc->bodiesallocated
+					? arc->bodiesallocated * 2 : 256;
+	x_alloc(arc->bodies, arc->bodiesallocated * sizeof *arc->bodies);
+    }
+    body = arc->bodies + arc->bodycount;
+    body->levelhash = levelhash;
+    body->datahash = datahash;
+    body->size = size;
+    body->offset = offset;
+    ++arc->bodycount;
+
+    if (arc->bodycount * 2 > arc->indexsize) {
+	rebuildindex(arc);
+	return;
+    }
+    mask = arc->indexsize - 1;
+    slot = hashslot(arc, levelhash, datahash);
+    while (arc->index[slot] >= 0)
+	slot = (slot + 1) & mask;
+    arc->index[slot] = arc->bodycount - 1;
+}
+
+/* Look in the archive for a body holding the given solution data.
+ * The data of each candidate is read and compared, so that bodies
+ * whose hash values merely collide are not confused. The offset of
+ * the body's chunk is returned, or zero if there is no such body, or
+ * -1 if the archive could not be read.
+ */
+static long findbody(archive *arc, unsigned long levelhash,
+		     unsigned long datahash, unsigned char const *data,
+		     unsigned long size)
+{
+    archivebody const  *body;
+    unsigned char      *buf = NULL;
+    long		offset = 0;
+    int			mask, slot;
+
+    if (!arc->bodycount)
+	return 0;
+    mask = arc->indexsize - 1;
+    slot = hashslot(arc, levelhash, datahash);
+    for ( ; arc->index[slot] >= 0 ; slot = (slot + 1) & mask) {
+	body = arc->bodies + arc->index[slot];
+	if (body->levelhash != levelhash || body->datahash != datahash
+					 || body->size != size)
+	    continue;
+	x_alloc(buf, size);
+	if (!fileseek(&arc->file, body->offset + BODY_DATA, SEEK_SET,
+		      "cannot read archive")
+			|| !fileread(&arc->file, buf, size,
+				     "cannot read archive")) {
+	    offset = -1;
+	    break;
+	}
+	if (!memcmp(buf, data, size)) {
+	    offset = body->offset;
+	    break;
+	}
+    }
+    free(buf);
+    return offset;
+}
+
+/*
+ * Reading and writing the archive file.
+ */
+
+/* Read a name stored as a length byte followed by the characters.
+ */
+static int readname(fileinfo *file, char *buf)
+{
+    unsigned char	n;
+
+    if (!filereadint8(file, &n, NULL) || !fileread(file, buf, n, NULL))
+	return FALSE;
+    buf[n] = '\0';
+    return TRUE;
+}
+
+/* Write a name as a length byte followed by the characters.
+ */
+static int writename(fileinfo *file, char const *name)
+{
+    int	n;
+
+    n = strlen(name);
+    return filewriteint8(file, n, NULL) && filewrite(file, name, n, NULL);
+}
+
+/* Free the memory used by the archive, and close its file.
+ */
+static void closearchive(archive *arc)
+{
+    free(arc->bodies);
+    free(arc->index);
+    fileclose(&arc->file, NULL);
+}
+
+/* Open the archive in filename and check its header. If writable is
+ * TRUE, the archive is created if it does not already exist.
+ */
+static int openarchive(archive *arc, char const *filename, int writable)
+{
+    static char const	zeroes[3] = "";
+    unsigned long	sig;
+    unsigned char	version;
+
+    memset(arc, 0, sizeof *arc);
+    clearfileinfo(&arc->file);
+    if (!fileopen(&arc->file, filename, writable ? "r+b" : "rb", NULL)) {
+	if (!writable || errno != ENOENT)
+	    return fileerr(&arc->file, "cannot open archive");
+	if (!fileopen(&arc->file, filename, "w+b", "cannot create archive"))
+	    return FALSE;
+	if (!filewriteint32(&arc->file, ARCSIG, NULL)
+		|| !filewriteint8(&arc->file, ARCVERSION, NULL)
+		|| !filewrite(&arc->file, zeroes, 3, NULL))
+	    return fileerr(&arc->file, "cannot write archive");
+	return TRUE;
+    }
+
+    if (!filereadint32(&arc->file, &sig, "not a valid archive")
+		|| !filereadint8(&arc->file, &version, "not a valid archive")
+		|| !fileskip(&arc->file, 3, "not a valid archive"))
+	return FALSE;
+    if (sig != ARCSIG)
+	return fileerr(&arc->file, "not a valid archive");
+    if (version != ARCVERSION)
+	return fileerr(&arc->file, "archive was written by a different"
+				   " version of the program");
+    return TRUE;
+}
+
+/* Read through the chunks of the archive, finding where the last one
+ * ends and the offset of the latest manifest for the given user and
+ * level set, if user is not NULL. If indexbodies is TRUE, the bodies
+ * are added to the archive's index along the way.
+ */
+static int scanarchive(archive *arc, char const *user, char const *setname,
+		       int indexbodies)
+{
+    char		name[256];
+    unsigned long	size, levelhash, datahash;
+    unsigned char	type;
+    long		pos, fileend;
+
+    if (!fileseek(&arc->file, 0, SEEK_END, "cannot read archive"))
+	return FALSE;
+    fileend = filetell(&arc->file, "cannot read archive");
+    if (fileend < 0)
+	return FALSE;
+
+    for (pos = 8 ; pos < fileend ; pos += CHUNK_HEADSIZE + size) {
+	arc->end = pos;
+	if (!fileseek(&arc->file, pos, SEEK_SET, "cannot read archive"))
+	    return FALSE;
+	if (!filereadint8(&arc->file, &type, NULL)
+			|| !filereadint32(&arc->file, &size, NULL)
+			|| pos + CHUNK_HEADSIZE + size > (unsigned long)fileend)
+	    goto damaged;
+	if (type == CHUNK_BODY) {
+	    if (size <= 8)
+		goto damaged;
+	    if (!indexbodies)
+		continue;
+	    if (!filereadint32(&arc->file, &levelhash, NULL)
+			|| !filereadint32(&arc->file, &datahash, NULL))
+		goto damaged;
+	    addbody(arc, levelhash, datahash, size - 8, pos);
+	} else if (type == CHUNK_MANIFEST) {
+	    if (!user)
+		continue;
+	    if (!readname(&arc->file, name))
+		goto damaged;
+	    if (strcmp(name, user))
+		continue;
+	    if (!readname(&arc->file, name))
+		goto damaged;
+	    if (!strcmp(name, setname))
+		arc->manifest = pos;
+	} else {
+	    goto damaged;
+	}
+    }
+    arc->end = fileend;
+    return TRUE;
+
+  damaged:
+    warn("%s: ignoring damaged data at the end of the archive",
+	 arc->file.name);
+    return TRUE;
+}
+
+/* Cut off any damaged data that scanarchive() found after the last
+ * intact chunk, so that new chunks do not leave it in the middle of
+ * the archive.
+ */
+static int truncatearchive(archive *arc)
+{
+    long	fileend;
+
+    if (!fileseek(&arc->file, 0, SEEK_END, "cannot write archive"))
+	return FALSE;
+    fileend = filetell(&arc->file, "cannot write archive");
+    if (fileend < 0)
+	return FALSE;
+    if (fileend == arc->end)
+	return TRUE;
+    if (fflush(arc->file.fp))
+	return fileerr(&arc->file, "cannot write archive");
+#ifdef WIN32
+    if (_chsize(_fileno(arc->file.fp), arc->end))
+#else
+    if (ftruncate(fileno(arc->file.fp), arc->end))
+#endif
+	return fileerr(&arc->file, "cannot truncate archive");
+    return TRUE;
+}
+
+/* Read the manifest found by scanarchive().
+ */
+static int readmanifest(archive *arc, manifest *m)
+{
+    char		name[256];
+    unsigned char	ruleset;
+    unsigned long	size, i;
+
+    memset(m, 0, sizeof *m);
+    if (!fileseek(&arc->file, arc->manifest + 1, SEEK_SET,
+		  "cannot read archive"))
+	return FALSE;
+    if (!filereadint32(&arc->file, &size, NULL)
+		|| !readname(&arc->file, name) || !readname(&arc->file, name)
+		|| !filereadint8(&arc->file, &ruleset, NULL)
+		|| !filereadint16(&arc->file, &m->flags, NULL)
+		|| !filereadint8(&arc->file, &m->extrasize, NULL)
+		|| !fileread(&arc->file, m->extra, m->extrasize, NULL)
+		|| !filereadint32(&arc->file, &m->count, NULL)
+		|| m->count > size / 10)
+	return fileerr(&arc->file, "invalid manifest in archive");
+    m->ruleset = ruleset;
+    if (!m->count)
+	return TRUE;
+
+    x_alloc(m->entries, m->count * sizeof *m->entries);
+    for (i = 0 ; i < m->count ; ++i) {
+	if (!filereadint16(&arc->file, &m->entries[i].number, NULL)
+		|| !fileread(&arc->file, m->entries[i].passwd, 4, NULL)
+		|| !filereadint32(&arc->file, &m->entries[i].offset, NULL)) {
+	    free(m->entries);
+	    m->entries = NULL;
+	    return fileerr(&arc->file, "invalid manifest in archive");
+	}
+	m->entries[i].passwd[4] = '\0';
+    }
+    return TRUE;
+}
+
+/* Find the given user's manifest for the series, and read it. The
+ * manifest's ruleset must match the series.
+ */
+static int findmanifest(archive *arc, manifest *m, gameseries const *series,
+			char const *user)
+{
+    if (!scanarchive(arc, user, series->name, FALSE))
+	return FALSE;
+    if (!arc->manifest) {
+	errmsg(arc->file.name, "no solutions from %s for %s",
+			       user, series->name);
+	return FALSE;
+    }
+    if (!readmanifest(arc, m))
+	return FALSE;
+    if (m->ruleset != series->ruleset) {
+	free(m->entries);
+	return fileerr(&arc->file, "archived solutions are for a different"
+				   " ruleset than the level set file");
+    }
+    return TRUE;
+}
+
+/* Move to the body chunk at offset, and read the hash value of its
+ * level and the size of its solution data. The file is left at the
+ * start of the solution data.
+ */
+static int readbodyheader(archive *arc, unsigned long offset,
+			  unsigned long *levelhash, unsigned long *size)
+{
+    unsigned long	datahash;
+    unsigned char	type;
+
+    if (!fileseek(&arc->file, offset, SEEK_SET, "cannot read archive"))
+	return FALSE;
+    if (!filereadint8(&arc->file, &type, NULL)
+		|| !filereadint32(&arc->file, size, NULL)
+		|| !filereadint32(&arc->file, levelhash, NULL)
+		|| !filereadint32(&arc->file, &datahash, NULL)
+		|| type != CHUNK_BODY || *size <= 8
+		|| offset + CHUNK_HEADSIZE + *size > (unsigned long)arc->end)
+	return fileerr(&arc->file, "invalid solution body in archive");
+    *size -= 8;
+    return TRUE;
+}
+
+/* Append a chunk holding the given solution data to the archive, and
+ * return where it begins, or -1 if it could not be written.
+ */
+static long writebody(archive *arc, unsigned long levelhash,
+		      unsigned long datahash, unsigned char const *data,
+		      unsigned long size)
+{
+    long	offset;
+
+    offset = arc->end;
+    if (!fileseek(&arc->file, offset, SEEK_SET, "cannot write archive"))
+	return -1;
+    if (!filewriteint8(&arc->file, CHUNK_BODY, NULL)
+		|| !filewriteint32(&arc->file, size + 8, NULL)
+		|| !filewriteint32(&arc->file, levelhash, NULL)
+		|| !filewriteint32(&arc->file, datahash, NULL)
+		|| !filewrite(&arc->file, data, size, NULL)) {
+	fileerr(&arc->file, "cannot write archive");
+	return -1;
+    }
+    arc->end += BODY_DATA + size;
+    addbody(arc, levelhash, datahash, size, offset);
+    return offset;
+}
+
+/* Append a manifest for the series to the archive.
+ */
+static int writemanifest(archive *arc, gameseries const *series,
+			 char const *user, manifestentry const *entries,
+			 unsigned long count)
+{
+    unsigned long	size, i;
+
+    size = 1 + strlen(user) + 1 + strlen(series->name) + 1 + 2
+	 + 1 + series->solheadersize + 4 + count * 10;
+    if (!fileseek(&arc->file, arc->end, SEEK_SET, "cannot write archive"))
+	return FALSE;
+    if (!filewriteint8(&arc->file, CHUNK_MANIFEST, NULL)
+		|| !filewriteint32(&arc->file, size, NULL)
+		|| !writename(&arc->file, user)
+		|| !writename(&arc->file, series->name)
+		|| !filewriteint8(&arc->file, series->ruleset, NULL)
+		|| !filewriteint16(&arc->file, series->solheaderflags, NULL)
+		|| !filewriteint8(&arc->file, series->solheadersize, NULL)
+		|| !filewrite(&arc->file, series->solheader,
+			      series->solheadersize, NULL)
+		|| !filewriteint32(&arc->file, count, NULL))
+	return fileerr(&arc->file, "cannot write archive");
+    for (i = 0 ; i < count ; ++i)
+	if (!filewriteint16(&arc->file, entries[i].number, NULL)
+		|| !filewrite(&arc->file, entries[i].passwd, 4, NULL)
+		|| !filewriteint32(&arc->file, entries[i].offset, NULL))
+	    return fileerr(&arc->file, "cannot write archive");
+    arc->end += CHUNK_HEADSIZE + size;
+    return TRUE;
+}
+
+/*
+ * Exported functions.
+ */
+
+/* Store each of the series' solutions in the archive, unless it is
+ * already there, and then add the manifest listing them.
+ */
+int addtoarchive(char const *filename, gameseries *series, char const *user)
+{
+    archive		arc;
+    manifestentry      *entries = NULL;
+    manifestentry      *entry;
+    gamesetup	       *game;
+    unsigned long	levelhash, datahash, count = 0;
+    long		offset;
+    int			added = 0, f = FALSE, i;
+
+    if (!*user || strlen(user) > 255) {
+	errmsg(user, "invalid user name for the archive");
+	return FALSE;
+    }
+    if (!openarchive(&arc, filename, TRUE)
+			|| !scanarchive(&arc, NULL, NULL, TRUE)
+			|| !truncatearchive(&arc)) {
+	closearchive(&arc);
+	return FALSE;
+    }
+
+    x_alloc(entries, (series->count + 1) * sizeof *entries);
+    for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
+	if (!game->solutionsize && !(game->sgflags & SGF_HASPASSWD))
+	    continue;
+	entry = entries + count;
+	entry->number = game->number;
+	memcpy(entry->passwd, game->passwd, 4);
+	entry->offset = 0;
+	if (game->solutionsize) {
+	    if (!loadsolution(game))
+		goto quit;
+	    levelhash = archash(game->levelhash);
+	    datahash = hashsolution(game->solutiondata, game->solutionsize);
+	    offset = findbody(&arc, levelhash, datahash,
+			      game->solutiondata, game->solutionsize);
+	    if (!offset) {
+		offset = writebody(&arc, levelhash, datahash,
+				   game->solutiondata, game->solutionsize);
+		++added;
+	    }
+	    if (offset < 0)
+		goto quit;
+	    entry->offset = offset;
+	}
+	++count;
+    }
+    if (!writemanifest(&arc, series, user, entries, count))
+	goto quit;
+    if (fflush(arc.file.fp) || ferror(arc.file.fp)) {
+	fileerr(&arc.file, "cannot write archive");
+	goto quit;
+    }
+
+    printf("Levels archived:%9lu\n", count);
+    printf("New solutions:%11d\n", added);
+    f = TRUE;
+
+  quit:
+    free(entries);
+    closearchive(&arc);
+    return f;
+}
+
+/* Write the header of a solution file, and then copy each body that
+ * the manifest refers to into a record of its own.
+ */
+int extractfromarchive(char const *filename, gameseries *series,
+		       char const *user, fileinfo *file)
+{
+    archive		arc;
+    manifest		m;
+    gamesetup		game;
+    unsigned long	levelhash, size, i;
+    int			f = FALSE;
+
+    if (!openarchive(&arc, filename, FALSE) || !findmanifest(&arc, &m, series,
+							     user)) {
+	closearchive(&arc);
+	return FALSE;
+    }
+    series->solheaderflags = m.flags;
+    series->solheadersize = m.extrasize;
+    memcpy(series->solheader, m.extra, m.extrasize);
+    if (!writesolutionfileheader(file, series)) {
+	fileerr(file, "write error");
+	goto quit;
+    }
+
+    for (i = 0 ; i < m.count ; ++i) {
+	memset(&game, 0, sizeof game);
+	game.number = m.entries[i].number;
+	memcpy(game.passwd, m.entries[i].passwd, 4);
+	game.sgflags = SGF_HASPASSWD;
+	if (m.entries[i].offset) {
+	    if (!readbodyheader(&arc, m.entries[i].offset, &levelhash, &size))
+		goto quit;
+	    game.solutiondata = filereadbuf(&arc.file, size,
+					    "cannot read archive");
+	    if (!game.solutiondata)
+		goto quit;
+	    game.solutionsize = size;
+	}
+	f = writesolution(file, &game);
+	free(game.solutiondata);
+	if (!f) {
+	    fileerr(file, "write error");
+	    goto quit;
+	}
+    }
+    f = !fflush(file->fp) && !ferror(file->fp);
+    if (!f)
+	fileerr(file, "write error");
+
+  quit:
+    free(m.entries);
+    closearchive(&arc);
+    return f;
+}
+
+/* Match each level in the manifest with a level in the series, and
+ * point the level at the body in the archive. The archive's file is
+ * handed over to the series, in the same way as readsolutions() does
+ * with a solution file.
+ */
+int loadfromarchive(char const *filename, gameseries *series,
+		    char const *user)
+{
+    archive		arc;
+    manifest		m;
+    fileinfo	       *file;
+    gamesetup	       *game;
+    unsigned char	header[16];
+    unsigned long	levelhash, size, i;
+    int			f = FALSE, n;
+
+    if (!openarchive(&arc, filename, FALSE) || !findmanifest(&arc, &m, series,
+							     user)) {
+	closearchive(&arc);
+	return FALSE;
+    }
+    clearsolutions(series);
+    series->gsflags |= GSF_NOSAVING;
+    series->solheaderflags = m.flags;
+    series->solheadersize = m.extrasize;
+    memcpy(series->solheader, m.extra, m.extrasize);
+
+    file = NULL;
+    x_alloc(file, sizeof *file);
+    *file = arc.file;
+    arc.file.alloc = FALSE;
+
+    for (i = 0 ; i < m.count ; ++i) {
+	n = findlevelinseries(series, m.entries[i].number,
+			      m.entries[i].passwd);
+	if (n < 0) {
+	    warn("%s: level %d is not in the level set", user,
+		 m.entries[i].number);
+	    continue;
+	}
+	game = series->games + n;
+	game->sgflags = SGF_HASPASSWD;
+	if (!m.entries[i].offset)
+	    continue;
+	if (!readbodyheader(&arc, m.entries[i].offset, &levelhash, &size))
+	    goto quit;
+	if (levelhash != archash(game->levelhash)) {
+	    warn("%s: level %d has changed since it was archived", user,
+		 game->number);
+	    continue;
+	}
+	if (size <= 16) {
+	    game->solutiondata = filereadbuf(&arc.file, size,
+					     "cannot read archive");
+	    if (!game->solutiondata)
+		goto quit;
+	    game->solutionsize = size;
+	    continue;
+	}
+	if (!fileread(&arc.file, header, 16, "cannot read archive"))
+	    goto quit;
+	game->besttime = getsolutiontime(header);
+	game->solutionsize = size;
+	game->solutionfile = file;
+	game->solutionoffset = m.entries[i].offset + BODY_DATA;
+    }
+    f = TRUE;
+
+  quit:
+    free(m.entries);
+    arc.file.fp = NULL;
+    closearchive(&arc);
+    for (n = 0 ; n < series->count ; ++n)
+	if (series->games[n].solutionfile == file)
+	    break;
+    if (n == series->count) {
+	fileclose(file, NULL);
+	free(file);
+    }
+    return f;
+}
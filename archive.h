@@ -0,0 +1,43 @@
+/* archive.h: Storing many users' solution files with shared bodies.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef	HEADER_archive_h_
+#define	HEADER_archive_h_
+
+#include	"defs.h"
+
+/* Add the solutions that have been read for the given series to the
+ * archive in filename, as the given user's submission for the level
+ * set. The archive is created if it does not exist. A solution that
+ * is already stored in the archive for the same level, under any
+ * user, is not stored again. The user's previous submission for the
+ * level set, if any, is superseded. The number of solutions added and
+ * the number that had to be stored anew are reported on stdout. FALSE
+ * is returned if an error occurs.
+ */
+extern int addtoarchive(char const *filename, gameseries *series,
+			char const *user);
+
+/* Write the given user's latest submission for the series from the
+ * archive in filename to file, as a standard solution file. Each
+ * solution is copied across as it is read. FALSE is returned if the
+ * archive holds no such submission, or if an error occurs.
+ */
+extern int extractfromarchive(char const *filename, gameseries *series,
+			      char const *user, fileinfo *file);
+
+/* Replace the series' solutions with the given user's latest
+ * submission for it from the archive in filename. The solutions are
+ * left in the archive until they are played back, as with
+ * readsolutions(), and saving is disabled for the series. Solutions
+ * for levels that have changed since they were archived are dropped
+ * with a warning. FALSE is returned if the archive holds no such
+ * submission, or if an error occurs.
+ */
+extern int loadfromarchive(char const *filename, gameseries *series,
+			   char const *user);
+
+#endif
@@ -182,7 +182,10 @@ enum {
  * Structures for defining the games proper.
  */
 
-/* The collection of data maintained for each level.
+/* The collection of data maintained for each level. A solution that
+ * has not yet been read into memory has a nonzero solutionsize but
+ * no solutiondata, and solutionfile and solutionoffset say where to
+ * find it.
  */
 typedef	struct gamesetup {
     int			number;		/* numerical ID of the level */
@@ -193,10 +196,12 @@ typedef	struct gamesetup {
     int			solutionsize;	/* size of the saved solution data */
     unsigned char      *leveldata;	/* the data defining the level */
     unsigned char      *solutiondata;	/* the player's best solution so far */
+    fileinfo	       *solutionfile;	/* file to read solutiondata from */
+    long		solutionoffset;	/* where solutiondata is in said file */
     unsigned long	levelhash;	/* the level data's hash value */
     char const	       *unsolvable;	/* why level is unsolvable, or NULL */
-    char		name[256];	/* name of the level */
-    char		passwd[256];	/* the level's password */
+    char const	       *name;		/* name of the level */
+    char		passwd[16];	/* the level's password */
 } gamesetup;
 
 /* Flags associated with a saved game.
@@ -209,7 +214,7 @@ typedef	struct gamesetup {
  */
 typedef	struct history {
     char		name[256];	/* the set filename minus any path */
-    char		passwd[256];	/* password of the last played level */
+    char		passwd[16];	/* password of the last played level */
     int	   		levelnumber;	/* number of the last played level */
     struct tm		dt;		/* date/time set was last played */
 } history;
@@ -223,6 +228,7 @@ typedef	struct gameseries {
     int			ruleset;	/* the ruleset for the game file */
     int			gsflags;	/* series flags (see below) */
     gamesetup	       *games;		/* the array of levels */
+    struct namepool    *names;		/* storage for the levels' names */
     fileinfo		mapfile;	/* the file containing the levels */
     char	       *mapfilename;	/* the name of said file */
     fileinfo		savefile;	/* the file holding the solutions */
@@ -312,6 +312,53 @@ int expandleveldata(gamestate *state)
     return expandmsdatlevel(state);
 }
 
+/* Build the per-location wiring table. The lists are walked backwards,
+ * so that the first wiring for a location is the one that is kept.
+ */
+void buildwiring(gamestate *state)
+{
+    xyconn const       *xy;
+    cellwiring	       *w;
+    int			i;
+
+    for (i = 0, w = state->wiring ; i < CXGRID * CYGRID ; ++i, ++w)
+	w->trap = w->cloner = w->trapwire = w->nexttrap = w->nextcloner = -1;
+    for (i = state->trapcount - 1 ; i >= 0 ; --i) {
+	xy = state->traps + i;
+	if (xy->from >= 0 && xy->from < CXGRID * CYGRID)
+	    state->wiring[xy->from].trap = xy->to;
+	state->trapwirenext[i] = -1;
+	if (xy->to >= 0 && xy->to < CXGRID * CYGRID) {
+	    state->trapwirenext[i] = state->wiring[xy->to].trapwire;
+	    state->wiring[xy->to].trapwire = i;
+	}
+    }
+    for (i = state->clonercount - 1 ; i >= 0 ; --i) {
+	xy = state->cloners + i;
+	if (xy->from >= 0 && xy->from < CXGRID * CYGRID)
+	    state->wiring[xy->from].cloner = xy->to;
+    }
+}
+
+/* Copy the fields filled in by expandleveldata() from one gamestate
+ * to another.
+ */
+void copyleveldata(gamestate *dest, gamestate const *src)
+{
+    dest->game = src->game;
+    dest->chipsneeded = src->chipsneeded;
+    dest->statusflags |= src->statusflags & SF_BADTILES;
+    dest->trapcount = src->trapcount;
+    dest->clonercount = src->clonercount;
+    dest->crlistcount = src->crlistcount;
+    memcpy(dest->traps, src->traps, src->trapcount * sizeof *src->traps);
+    memcpy(dest->cloners, src->cloners,
+	   src->clonercount * sizeof *src->cloners);
+    memcpy(dest->crlist, src->crlist, src->crlistcount * sizeof *src->crlist);
+    memcpy(dest->hinttext, src->hinttext, sizeof dest->hinttext);
+    memcpy(dest->map, src->map, sizeof dest->map);
+}
+
 /* Return the setup for a small level to display at the completion of
  * a series.
  */
@@ -345,7 +392,8 @@ void getenddisplaysetup(gamestate *state)
     ending.leveldata = endingdata;
     ending.solutionsize = 0;
     ending.solutiondata = NULL;
-    strcpy(ending.name, "CONGRATULATIONS!");
+    ending.solutionfile = NULL;
+    ending.name = "CONGRATULATIONS!";
     ending.passwd[0] = '\0';
 
     state->game = &ending;
@@ -14,6 +14,17 @@
  */
 extern int expandleveldata(gamestate *state);
 
+/* Fill in the wiring table of the gamestate from its trap and cloner
+ * lists. A button wired more than once uses its first wiring, as the
+ * game logic did when it searched the lists. The map-order fields are
+ * left for the game logic to fill in, if it needs them.
+ */
+extern void buildwiring(gamestate *state);
+
+/* Copy the level data expanded into one gamestate into another.
+ */
+extern void copyleveldata(gamestate *dest, gamestate const *src);
+
 /* Return the setup for a small level, created at runtime, that can be
  * displayed at the completion of a series.
  */
@@ -152,6 +152,29 @@ int fileskip(fileinfo *file, int offset, char const *msg)
     return fileerr(file, msg);
 }
 
+/* fseek() with any starting point.
+ */
+int fileseek(fileinfo *file, long offset, int whence, char const *msg)
+{
+    errno = 0;
+    if (!fseek(file->fp, offset, whence))
+	return TRUE;
+    return fileerr(file, msg);
+}
+
+/* ftell().
+ */
+long filetell(fileinfo *file, char const *msg)
+{
+    long	pos;
+
+    errno = 0;
+    pos = ftell(file->fp);
+    if (pos < 0)
+	fileerr(file, msg);
+    return pos;
+}
+
 /* feof().
  */
 int filetestend(fileinfo *file)
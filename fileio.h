@@ -44,6 +44,12 @@ extern void fileclose(fileinfo *file, char const *msg);
  */
 extern int fileskip(fileinfo *file, int offset, char const *msg);
 
+/* fileseek() and filetell() work like fseek() and ftell().
+ */
+extern int fileseek(fileinfo *file, long offset, int whence,
+		    char const *msg);
+extern long filetell(fileinfo *file, char const *msg);
+
 /* filetestend() forces a check for EOF by attempting to read a byte
  * from the file, and ungetting the byte if one is successfully read.
  */
@@ -26,15 +26,28 @@
  * the cell, "+" to align to the right, "." to center the text, and
  * "!" to permit the cell to occupy multiple lines, with word
  * wrapping. At most one cell in a given row can be word-wrapped.
+ *
+ * Instead of holding all of its contents in items, a table can supply
+ * a function that formats the cells of a single row when they are
+ * needed. The function stores pointers to the row's cells in cells,
+ * which has room for TABLE_MAXCOLS entries, and returns the number of
+ * cells stored. The strings remain valid until the next call.
  */
 typedef	struct tablespec {
-    short	rows;		/* number of rows */
+    int		rows;		/* number of rows */
     short	cols;		/* number of columns */
     short	sep;		/* amount of space between columns */
     short	collapse;	/* the column to squeeze if necessary */
     char const  **items;	/* the table's contents */
+    int	      (*getrow)(void const *source, int row, char const **cells);
+				/* formats one row on demand, or NULL */
+    void const *source;		/* the data passed to getrow */
 } tablespec;
 
+/* The largest number of columns in a table that uses getrow.
+ */
+#define	TABLE_MAXCOLS	16
+
 /* The dimensions of a level.
  */
 #define	CXGRID	32
@@ -53,6 +53,11 @@ typedef	struct genericglobals
      */
     void (*eventupdatefunc)(int wait);
 
+    /* Process events as they arrive, until the given number of
+     * milliseconds have passed.
+     */
+    void (*eventwaitfunc)(int ms);
+
     /* A callback function, to be called every time a keyboard key is
      * pressed or released. scancode is an SDL key symbol. down is
      * TRUE if the key was pressed or FALSE if it was released.
@@ -93,6 +98,7 @@ OSHW_EXTERN genericglobals geng;
 /* Some convenience macros for the above functions.
  */
 #define eventupdate		(*geng.eventupdatefunc)
+#define eventwait		(*geng.eventwaitfunc)
 #define	keyeventcallback	(*geng.keyeventcallbackfunc)
 #define	mouseeventcallback	(*geng.mouseeventcallbackfunc)
 #define	windowmappos		(*geng.windowmapposfunc)
@@ -105,6 +111,11 @@ OSHW_EXTERN int _generictimerinitialize(int showhistogram);
 OSHW_EXTERN int _generictileinitialize(void);
 OSHW_EXTERN int _genericinputinitialize(void);
 
+/* Dispatch events as they arrive for the given number of milliseconds,
+ * keeping them for the next call to input().
+ */
+OSHW_EXTERN void _genericeventwait(int ms);
+
 #undef OSHW_EXTERN
 
 #endif
@@ -48,6 +48,12 @@ enum { KS_OFF = 0,		/* key is not currently pressed */
  */
 static char		keystates[TWK_LAST];
 
+/* TRUE if the key states have already been updated for the next
+ * polling cycle, because events were dispatched while waiting for
+ * the timer.
+ */
+static int		keystatesreset = FALSE;
+
 /* The last mouse action.
  */
 static mouseaction	mouseinfo;
@@ -261,6 +267,7 @@ static void restartkeystates(void)
     uint8_t    *keyboard;
     int		count, n;
 
+    keystatesreset = FALSE;
     memset(keystates, KS_OFF, sizeof keystates);
     keyboard = TW_GetKeyState(&count);
     if (count > TWK_LAST)
@@ -375,6 +382,7 @@ int anykey(void)
 {
     int	n;
 
+    keystatesreset = FALSE;
     resetkeystates();
     eventupdate(FALSE);
     for (;;) {
@@ -402,7 +410,9 @@ int input(int wait)
     int			cmd1, cmd, n;
 
     for (;;) {
-	resetkeystates();
+	if (!keystatesreset)
+	    resetkeystates();
+	keystatesreset = FALSE;
 	eventupdate(wait);
 
 	cmd1 = cmd = 0;
@@ -454,6 +464,20 @@ int input(int wait)
     return cmd;
 }
 
+/* Dispatch events as they arrive for the given number of
+ * milliseconds. The key states are updated for the next polling cycle
+ * beforehand, so that the events received during the wait are seen
+ * by the next call to input() just as if they had arrived after it.
+ */
+void _genericeventwait(int ms)
+{
+    if (!keystatesreset) {
+	resetkeystates();
+	keystatesreset = TRUE;
+    }
+    eventwait(ms);
+}
+
 /* Turn joystick behavior mode on or off. In joystick-behavior mode,
  * the arrow keys are always returned from input() if they are down at
  * the time of the polling cycle. Other keys are only returned if they
@@ -532,7 +556,8 @@ tablespec const *keyboardhelp(int which)
 	"1-Ctrl-C", "1-exit the program",
 	"1-Alt-F4", "1-exit the program"
     };
-    static tablespec const keyhelp_ingame = { 11, 2, 4, 1, ingame_items };
+    static tablespec const keyhelp_ingame = { 11, 2, 4, 1, ingame_items,
+					      NULL, NULL };
 
     static char const *twixtgame_items[] = {
 	"1-P", "1-jump to the previous level",
@@ -556,7 +581,7 @@ tablespec const *keyboardhelp(int which)
 	"1-Alt-F4", "1-exit the program"
     };
     static tablespec const keyhelp_twixtgame = { 19, 2, 4, 1,
-						 twixtgame_items };
+						 twixtgame_items, NULL, NULL };
 
     static char const *scorelist_items[] = {
 	"1-up down", "1-move selection",
@@ -567,7 +592,8 @@ tablespec const *keyboardhelp(int which)
 	"1-Ctrl-C", "1-exit the program",
 	"1-Alt-F4", "1-exit the program"
     };
-    static tablespec const keyhelp_scorelist = { 7, 2, 4, 1, scorelist_items };
+    static tablespec const keyhelp_scorelist = { 7, 2, 4, 1, scorelist_items,
+						 NULL, NULL };
 
     static char const *scroll_items[] = {
 	"1-up down", "1-move selection",
@@ -577,7 +603,8 @@ tablespec const *keyboardhelp(int which)
 	"1-Ctrl-C", "1-exit the program",
 	"1-Alt-F4", "1-exit the program"
     };
-    static tablespec const keyhelp_scroll = { 6, 2, 4, 1, scroll_items };
+    static tablespec const keyhelp_scroll = { 6, 2, 4, 1, scroll_items,
+					      NULL, NULL };
 
     static char const *twplusplus_items[] = {
 	"1-Key", "1-Action",
@@ -618,7 +645,8 @@ tablespec const *keyboardhelp(int which)
 	"1-Shift-E", "1-Advance a move"
     };
 
-    static tablespec const keyhelp_twplusplus = { 34, 2, 4, 1, twplusplus_items };
+    static tablespec const keyhelp_twplusplus = { 34, 2, 4, 1,
+						  twplusplus_items, NULL, NULL };
 
     switch (which) {
       case KEYHELP_INGAME:	return &keyhelp_ingame;
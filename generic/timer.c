@@ -66,8 +66,16 @@ int gettickcount(void)
     return (int)utick;
 }
 
-/* Put the program to sleep until the next timer tick. If we've
- * already missed a timer tick, then wait for the next one.
+/* Set the tick counter without otherwise affecting the timer.
+ */
+void settickcount(int tick)
+{
+    utick = tick;
+}
+
+/* Put the program to sleep until the next timer tick, handling any
+ * events that arrive in the meantime. If we've already missed a timer
+ * tick, then wait for the next one.
  */
 int waitfortick(void)
 {
@@ -87,13 +95,25 @@ int waitfortick(void)
     while (ms < 0)
 	ms += mspertick;
 
-    TW_Delay(ms);
+    _genericeventwait(ms);
 
     ++utick;
     nexttickat += mspertick;
     return TRUE;
 }
 
+/* Return how long remains before the next timer tick is due.
+ */
+int ticktimeleft(void)
+{
+    int	ms;
+
+    if (nexttickat <= 0)
+	return 0;
+    ms = nexttickat - TW_GetTicks();
+    return ms > 0 ? ms : 0;
+}
+
 /* Move to the next timer tick without waiting.
  */
 int advancetick(void)
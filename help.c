@@ -19,7 +19,7 @@
 /* Help for command-line options.
  */
 static char const *yowzitch_items[] = {
-    "1-Usage:", "1!tworld [-hvVdlsbtpqrPFa] [-n N] [-DLRS DIR] "
+    "1-Usage:", "1!tworld [-hvVdlsbtpqrPFa] [-n N] [-DELRS DIR] "
 		"[NAME] [SNAME] [LEVEL]",
     "1-   -D", "1!Read data files from DIR instead of the default.",
     "1-   -L", "1!Read level sets from DIR instead of the default.",
@@ -36,6 +36,31 @@ static char const *yowzitch_items[] = {
     "1-   -s", "1!Display scores for the selected data file and exit.",
     "1-   -t", "1!Display times for the selected data file and exit.",
     "1-   -b", "1!Batch-verify solutions for the selected data file and exit.",
+    "1-   --shard I/N", "1!With -b, verify only the Ith of N parts of the"
+		" levels, and write the results to stdout.",
+    "1-   --merge FILE", "1!With -b, apply the results of --shard runs"
+		" instead of verifying (can be repeated).",
+    "1-   --report FMT", "1!With -b, write a record per level to stdout"
+		" as json or csv.",
+    "1-   --trace-write FILE", "1!Write the state after every tick of each"
+		" solution to FILE and exit.",
+    "1-   --trace-check FILE", "1!Compare each solution's playback against"
+		" the trace in FILE and exit.",
+    "1-   --speed-tolerance PCT", "1!With --trace-check, fail if playback is"
+		" more than PCT percent slower than the trace.",
+    "1-   --optimize SECS", "1!Spend up to SECS seconds on each level"
+		" shortening its solution, then save and exit.",
+    "1-   --archive FILE", "1!Use the solution archive in FILE with one of"
+		" the following.",
+    "1-   --archive-add USER", "1!Add the solutions to the archive as"
+		" USER's and exit.",
+    "1-   --archive-extract USER", "1!Write USER's solutions from the"
+		" archive to stdout and exit.",
+    "1-   --archive-verify USER", "1!Batch-verify USER's solutions in the"
+		" archive and exit.",
+    "1-   --serve SOCK", "1!Verify solution files sent to the Unix socket"
+		" SOCK until killed.",
+    "1-   -E", "1!Write every frame of the solution for LEVEL to DIR and exit.",
     "1-   -h", "1!Display this help and exit.",
     "1-   -d", "1!Display default directories and exit.",
     "1-   -v", "1!Display version number and exit.",
@@ -44,7 +69,8 @@ static char const *yowzitch_items[] = {
     "2!LEVEL specifies which level to start at.",
     "2!SNAME specifies an alternate solution file."
 };
-static tablespec const yowzitch_table = { 23, 2, 2, -1, yowzitch_items };
+static tablespec const yowzitch_table = { 36, 2, 2, -1, yowzitch_items,
+					  NULL, NULL };
 tablespec const *yowzitch = &yowzitch_table;
 
 /* Version and license information.
@@ -65,7 +91,8 @@ static char const *vourzhon_items[] = {
     "1+*", "1!Bug reports are appreciated, and can be submitted at "
 	   "https://github.com/zrax/tworld/issues."
 };
-static tablespec const vourzhon_table = { 6, 2, 1, -1, vourzhon_items };
+static tablespec const vourzhon_table = { 6, 2, 1, -1, vourzhon_items,
+					  NULL, NULL };
 tablespec const *vourzhon = &vourzhon_table;
 
 /* Descriptions of the different surfaces of the levels.
@@ -231,7 +258,7 @@ void onlinemainhelp(int topic)
 	"1+\267", "1-About Tile World",
 	"1+\267", "1-Return to the program"
     };
-    static tablespec const table = { 7, 2, 4, 1, items };
+    static tablespec const table = { 7, 2, 4, 1, items, NULL, NULL };
 
     int n;
 
@@ -306,7 +333,8 @@ void onlinecontexthelp(int topic)
 	"1-",
 	"1!Now, press any key to go back to the list of level sets."
     };
-    static tablespec const firsthelp_table = { 9, 1, 0, 1, firsthelp_items };
+    static tablespec const firsthelp_table = { 9, 1, 0, 1, firsthelp_items,
+					       NULL, NULL };
 
     switch (topic) {
       case Help_First:
@@ -15,7 +15,11 @@
 #define	back(dir)	((((dir) << 2) | ((dir) >> 2)) & 15)
 #define	right(dir)	((((dir) << 3) | ((dir) >> 1)) & 15)
 
-/* One game logic engine.
+/* One game logic engine. savestate() copies the game state that the
+ * engine keeps outside of the gamestate struct. Its second argument,
+ * if not NULL, is an earlier copy from the same game, with which the
+ * new copy can share whatever has not changed. restorestate() puts a
+ * copy back, and can only be used during the game it was made in.
  */
 typedef	struct gamelogic gamelogic;
 struct gamelogic {
@@ -25,6 +29,14 @@ struct gamelogic {
     int	      (*advancegame)(gamelogic*); /* advance the game one tick */
     int	      (*endgame)(gamelogic*);	  /* clean up after the game is done */
     void      (*shutdown)(gamelogic*);	  /* turn off the logic engine */
+    void     *(*savestate)(gamelogic*, void const*);
+					  /* copy the private game state */
+    void      (*restorestate)(gamelogic*, void const*);
+					  /* return to a copy made earlier */
+    void      (*freestate)(void*);	  /* discard a copy */
+    void      (*updateview)(gamelogic*);  /* bring the gamestate up to date
+					     before it is read elsewhere,
+					     or NULL if it always is */
 };
 
 /* The available game logic engines.
@@ -38,4 +50,11 @@ extern gamelogic *mslogicstartup(void);
  */
 extern int	pedanticmode;
 
+/* The mouse navigation flag: if true, clicking on the map in the MS
+ * ruleset moves Chip along a shortest path to the spot. The moves are
+ * recorded as ordinary keyboard moves, so that the solution plays back
+ * the same way whether or not the flag is set.
+ */
+extern int	mousenavigation;
+
 #endif
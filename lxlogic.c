@@ -9,7 +9,9 @@
 #include	"defs.h"
 #include	"err.h"
 #include	"state.h"
+#include	"encoding.h"
 #include	"random.h"
+#include	"snapshot.h"
 #include	"logic.h"
 
 /* A number well above the maximum number of creatures that could possibly
@@ -55,8 +57,8 @@ int			pedanticmode = FALSE;
 
 /* Declarations of (indirectly recursive) functions.
  */
-static int canmakemove(creature const *cr, int dir, int flags);
-static int advancecreature(creature *cr, int releasing);
+static int canmakemove(int cr, int dir, int flags);
+static int advancecreature(int cr, int releasing);
 
 /* Used to calculate movement offsets.
  */
@@ -71,8 +73,31 @@ static int		lastrndslidedir = NORTH;
  */
 static int		laststepping = 0;
 
-/* The memory used to hold the list of creatures.
- */
+/* The memory used to hold the list of creatures. Creatures are
+ * referred to by their index in this list. Chip is always at index
+ * zero, and the list is terminated by an entry whose id is Nothing.
+ *
+ * Normally the list is an array of creature structs, which is also
+ * what the display code reads. If LYNX_CREATURE_SOA is defined, each
+ * field is instead kept in an array of its own, so that the per-tick
+ * passes which test one or two fields of every creature walk through
+ * contiguous memory. The list of structs is then only a view of the
+ * field arrays, which is rebuilt when the game state is read from
+ * outside this module (see updateview in logic.h).
+ */
+#ifdef LYNX_CREATURE_SOA
+typedef	struct creaturefields {
+    short		pos[MAX_CREATURES + 1];
+    unsigned char	id[MAX_CREATURES + 1];
+    unsigned char	dir[MAX_CREATURES + 1];
+    signed char		moving[MAX_CREATURES + 1];
+    signed char		frame[MAX_CREATURES + 1];
+    unsigned char	hidden[MAX_CREATURES + 1];
+    unsigned char	state[MAX_CREATURES + 1];
+    unsigned char	tdir[MAX_CREATURES + 1];
+} creaturefields;
+static creaturefields	crfields;
+#endif
 static creature	       *creaturearray = NULL;
 
 /* A pointer to the game state, used so that it doesn't have to be
@@ -89,9 +114,29 @@ static gamestate       *state;
 
 #define	creaturelist()		(state->creatures)
 
-#define	getchip()		(creaturelist())
-#define	chippos()		(getchip()->pos)
-#define	chipisalive()		(getchip()->id == Chip)
+#ifdef LYNX_CREATURE_SOA
+#define	crpos(cr)		(crfields.pos[cr])
+#define	crid(cr)		(crfields.id[cr])
+#define	crdir(cr)		(crfields.dir[cr])
+#define	crmoving(cr)		(crfields.moving[cr])
+#define	crframe(cr)		(crfields.frame[cr])
+#define	crhidden(cr)		(crfields.hidden[cr])
+#define	crstate(cr)		(crfields.state[cr])
+#define	crtdir(cr)		(crfields.tdir[cr])
+#else
+#define	crpos(cr)		(creaturelist()[cr].pos)
+#define	crid(cr)		(creaturelist()[cr].id)
+#define	crdir(cr)		(creaturelist()[cr].dir)
+#define	crmoving(cr)		(creaturelist()[cr].moving)
+#define	crframe(cr)		(creaturelist()[cr].frame)
+#define	crhidden(cr)		(creaturelist()[cr].hidden)
+#define	crstate(cr)		(creaturelist()[cr].state)
+#define	crtdir(cr)		(creaturelist()[cr].tdir)
+#endif
+
+#define	getchip()		0
+#define	chippos()		(crpos(getchip()))
+#define	chipisalive()		(crid(getchip()) == Chip)
 
 #define	mainprng()		(&state->mainprng)
 
@@ -117,6 +162,10 @@ static gamestate       *state;
 #define	clonerlistsize()	(state->clonercount)
 #define	traplist()		(state->traps)
 #define	traplistsize()		(state->trapcount)
+#define	wiringat(pos)		(state->wiring[pos])
+#define	switchwalls()		(state->switchwalls)
+#define	teleportlist()		(state->teleports)
+#define	teleportlistsize()	(state->teleportcount)
 
 #define	getlxstate()		(state->lxstate)
 
@@ -241,12 +290,12 @@ static int getslidedir(int floor, int advance)
 
 /* Alter a creature's direction if they are at an ice wall.
  */
-static void applyicewallturn(creature *cr)
+static void applyicewallturn(int cr)
 {
     int	floor, dir;
 
-    floor = floorat(cr->pos);
-    dir = cr->dir;
+    floor = floorat(crpos(cr));
+    dir = crdir(cr);
     switch (floor) {
       case IceWall_Northeast:
 	dir = dir == SOUTH ? EAST : dir == WEST ? NORTH : dir;
@@ -261,61 +310,66 @@ static void applyicewallturn(creature *cr)
 	dir = dir == NORTH ? EAST : dir == WEST ? SOUTH : dir;
 	break;
     }
-    cr->dir = dir;
+    crdir(cr) = dir;
 }
 
-/* Find the location of a beartrap from one of its buttons.
+/* Find the location of a beartrap from one of its buttons. In
+ * pedantic mode, the button is connected to the next beartrap in map
+ * order, or to nothing if that beartrap is no longer there. (No other
+ * location can become a beartrap during play.)
  */
 static int trapfrombutton(int pos)
 {
-    xyconn     *xy;
-    int		i;
+    int	i;
 
     if (pedanticmode) {
-	i = pos;
-	for (;;) {
-	    ++i;
-	    if (i == CXGRID * CYGRID)
-		i = 0;
-	    if (i == pos)
-		break;
-	    if (floorat(i) == Beartrap)
-		return i;
-	    if (ismarkedbeartrap(i))
-	       return -1;
-	}
-    } else {
-	for (xy = traplist(), i = traplistsize() ; i ; ++xy, --i)
-	    if (xy->from == pos)
-		return xy->to;
+	i = wiringat(pos).nexttrap;
+	return i >= 0 && floorat(i) == Beartrap ? i : -1;
     }
-    return -1;
+    return wiringat(pos).trap;
 }
 
-/* Find the location of a clone machine from one of its buttons.
+/* Find the location of a clone machine from one of its buttons. In
+ * pedantic mode, the button is connected to the next clone machine in
+ * map order that is still there. (No other location can become a
+ * clone machine during play.)
  */
 static int clonerfrombutton(int pos)
 {
-    xyconn     *xy;
-    int		i;
+    int	first, i;
 
     if (pedanticmode) {
-	i = pos;
-	for (;;) {
-	    ++i;
-	    if (i == CXGRID * CYGRID)
-		i = 0;
-	    if (i == pos)
-		break;
-	    if (floorat(i) == CloneMachine)
-		return i;
+	first = i = wiringat(pos).nextcloner;
+	while (i >= 0 && floorat(i) != CloneMachine) {
+	    i = wiringat(i).nextcloner;
+	    if (i == first || i == pos)
+		return -1;
 	}
-    } else {
-	for (xy = clonerlist(), i = clonerlistsize() ; i ; ++xy, --i)
-	    if (xy->from == pos)
-		return xy->to;
+	return i;
+    }
+    return wiringat(pos).cloner;
+}
+
+/* Fill in the map-order fields of the wiring table used in pedantic
+ * mode. Each location gets the nearest beartrap and clone machine that
+ * follow it, wrapping around from the end of the map to the start.
+ */
+static void buildmaporderwiring(void)
+{
+    int	trap = -1, cloner = -1;
+    int	pos, n;
+
+    for (n = 2 * CXGRID * CYGRID - 1 ; n >= 0 ; --n) {
+	pos = n % (CXGRID * CYGRID);
+	if (n < CXGRID * CYGRID) {
+	    wiringat(pos).nexttrap = trap == pos ? -1 : trap;
+	    wiringat(pos).nextcloner = cloner == pos ? -1 : cloner;
+	}
+	if (ismarkedbeartrap(pos))
+	    trap = pos;
+	if (floorat(pos) == CloneMachine)
+	    cloner = pos;
     }
-    return -1;
 }
 
 /* Quell any continuous sound effects coming from what Chip is
@@ -347,46 +401,93 @@ static void resetfloorsounds(int includepushing)
 #define	CS_PUSHED		0x40	/* block was pushed by Chip */
 #define	CS_TELEPORTED		0x80	/* creature was just teleported */
 
-#define	getfdir(cr)	((cr)->state & CS_FDIRMASK)
-#define	setfdir(cr, d)	((cr)->state = ((cr)->state & ~CS_FDIRMASK) \
-				     | ((d) & CS_FDIRMASK))
+#define	getfdir(cr)	(crstate(cr) & CS_FDIRMASK)
+#define	setfdir(cr, d)	(crstate(cr) = (crstate(cr) & ~CS_FDIRMASK) \
+				       | ((d) & CS_FDIRMASK))
+
+/* The value used in place of a creature's index to indicate that
+ * there is no such creature.
+ */
+#define	NOCREATURE		(-1)
+
+/* Make the creature at index to an exact copy of the one at from.
+ */
+static void copycreature(int to, int from)
+{
+#ifdef LYNX_CREATURE_SOA
+    crpos(to) = crpos(from);
+    crid(to) = crid(from);
+    crdir(to) = crdir(from);
+    crmoving(to) = crmoving(from);
+    crframe(to) = crframe(from);
+    crhidden(to) = crhidden(from);
+    crstate(to) = crstate(from);
+    crtdir(to) = crtdir(from);
+#else
+    creaturelist()[to] = creaturelist()[from];
+#endif
+}
+
+#ifdef LYNX_CREATURE_SOA
+
+/* Rebuild the list of creature structs from the field arrays.
+ */
+static void updateview(gamelogic *logic)
+{
+    creature   *cr;
+    int		n;
+
+    setstate(logic);
+    for (n = 0, cr = creaturelist() ; crid(n) ; ++n, ++cr) {
+	cr->pos = crpos(n);
+	cr->id = crid(n);
+	cr->dir = crdir(n);
+	cr->moving = crmoving(n);
+	cr->frame = crframe(n);
+	cr->hidden = crhidden(n);
+	cr->state = crstate(n);
+	cr->tdir = crtdir(n);
+    }
+    cr->pos = -1;
+    cr->id = Nothing;
+    cr->dir = NIL;
+}
+
+#endif
 
 /* Return the creature located at pos. Ignores Chip unless includechip
  * is TRUE. (This is important in the case when Chip and a second
  * creature are currently occupying a single location.)
  */
-static creature *lookupcreature(int pos, int includechip)
+static int lookupcreature(int pos, int includechip)
 {
-    creature   *cr;
+    int	cr;
 
-    cr = creaturelist();
-    if (!includechip)
-	++cr;
-    for ( ; cr->id ; ++cr)
-	if (cr->pos == pos && !cr->hidden && !isanimation(cr->id))
+    for (cr = includechip ? 0 : 1 ; crid(cr) ; ++cr)
+	if (crpos(cr) == pos && !crhidden(cr) && !isanimation(crid(cr)))
 	    return cr;
-    return NULL;
+    return NOCREATURE;
 }
 
 /* Return a fresh creature.
  */
-static creature *newcreature(void)
+static int newcreature(void)
 {
-    creature   *cr;
+    int	cr;
 
-    for (cr = creaturelist() + 1 ; cr->id ; ++cr) {
-	if (cr->hidden)
+    for (cr = 1 ; crid(cr) ; ++cr) {
+	if (crhidden(cr))
 	    return cr;
     }
-    if (cr - creaturelist() >= MAX_CREATURES) {
+    if (cr >= MAX_CREATURES) {
 	warn("Ran out of room in the creatures array!");
-	return NULL;
+	return NOCREATURE;
     }
-    if (pedanticmode && cr - creaturelist() >= PMAX_CREATURES)
-	return NULL;
+    if (pedanticmode && cr >= PMAX_CREATURES)
+	return NOCREATURE;
 
-    cr->hidden = TRUE;
-    cr[1].id = Nothing;
+    crhidden(cr) = TRUE;
+    crid(cr + 1) = Nothing;
     creaturelistend() = cr;
     return cr;
 }
@@ -395,16 +496,16 @@ static creature *newcreature(void)
  */
 static void turntanks(void)
 {
-    creature   *cr;
+    int		cr;
 
-    for (cr = creaturelist() ; cr->id ; ++cr) {
-	if (cr->hidden)
+    for (cr = 0 ; crid(cr) ; ++cr) {
+	if (crhidden(cr))
 	    continue;
-	if (cr->id != Tank)
+	if (crid(cr) != Tank)
 	    continue;
-	if (floorat(cr->pos) == CloneMachine || isice(floorat(cr->pos)))
+	if (floorat(crpos(cr)) == CloneMachine || isice(floorat(crpos(cr))))
 	    continue;
-	cr->state ^= CS_REVERSE;
+	crstate(cr) ^= CS_REVERSE;
     }
 }
 
@@ -412,34 +513,34 @@ static void turntanks(void)
  * given creature. The creature's slot in the creature list is reused
  * by the animation sequence.
  */
-static void removecreature(creature *cr, int animationid)
+static void removecreature(int cr, int animationid)
 {
-    if (cr->id != Chip)
-	removeclaim(cr->pos);
-    if (cr->state & CS_PUSHED)
+    if (crid(cr) != Chip)
+	removeclaim(crpos(cr));
+    if (crstate(cr) & CS_PUSHED)
 	stopsoundeffect(SND_BLOCK_MOVING);
-    cr->id = animationid;
-    cr->frame = ((currenttime() + stepping()) & 1) ? 12 : 11;
-    --cr->frame;
-    cr->hidden = FALSE;
-    cr->state = 0;
-    cr->tdir = NIL;
-    if (cr->moving == 8) {
-	cr->pos -= delta[cr->dir];
-	cr->moving = 0;
-    }
-    markanimated(cr->pos);
+    crid(cr) = animationid;
+    crframe(cr) = ((currenttime() + stepping()) & 1) ? 12 : 11;
+    --crframe(cr);
+    crhidden(cr) = FALSE;
+    crstate(cr) = 0;
+    crtdir(cr) = NIL;
+    if (crmoving(cr) == 8) {
+	crpos(cr) -= delta[crdir(cr)];
+	crmoving(cr) = 0;
+    }
+    markanimated(crpos(cr));
 }
 
 /* End the given animation sequence (thus removing the final vestige
  * of an ex-creature).
  */
-static void removeanimation(creature *cr)
+static void removeanimation(int cr)
 {
-    cr->hidden = TRUE;
-    clearanimated(cr->pos);
+    crhidden(cr) = TRUE;
+    clearanimated(crpos(cr));
     if (cr == creaturelistend()) {
-	cr->id = Nothing;
+	crid(cr) = Nothing;
 	--creaturelistend();
     }
 }
@@ -448,10 +549,10 @@ static void removeanimation(creature *cr)
  */
 static int stopanimationat(int pos)
 {
-    creature   *anim;
+    int		anim;
 
-    for (anim = creaturelist() ; anim->id ; ++anim) {
-	if (!anim->hidden && anim->pos == pos && isanimation(anim->id)) {
+    for (anim = 0 ; crid(anim) ; ++anim) {
+	if (!crhidden(anim) && crpos(anim) == pos && isanimation(crid(anim))) {
 	    removeanimation(anim);
 	    return TRUE;
 	}
@@ -460,11 +561,11 @@ static int stopanimationat(int pos)
 }
 
 /* What happens when Chip dies. reason indicates the cause of death.
- * also is either NULL or points to a creature that dies with Chip.
+ * also is either NOCREATURE or a creature that dies with Chip.
  */
-static void removechip(int reason, creature *also)
+static void removechip(int reason, int also)
 {
-    creature  *chip = getchip();
+    int		chip = getchip();
 
     switch (reason) {
       case CHIP_DROWNED:
@@ -485,7 +586,7 @@ static void removechip(int reason, creature *also)
       case CHIP_COLLIDED:
 	addsoundeffect(SND_CHIP_LOSES);
 	removecreature(chip, Entity_Explosion);
-	if (also && also != chip)
+	if (also >= 0 && also != chip)
 	    removecreature(also, Entity_Explosion);
 	break;
     }
@@ -691,21 +792,21 @@ static struct { unsigned char chip, block, creature; } const movelaws[] = {
  * direction. If flags includes CMM_PUSHBLOCKSNOW, then the indicated
  * movement of the block will be initiated.
  */
-static int canpushblock(creature *block, int dir, int flags)
+static int canpushblock(int block, int dir, int flags)
 {
-    _assert(block && block->id == Block);
-    _assert(floorat(block->pos) != CloneMachine);
+    _assert(block >= 0 && crid(block) == Block);
+    _assert(floorat(crpos(block)) != CloneMachine);
     _assert(dir != NIL);
 
     if (!canmakemove(block, dir, flags)) {
-	if (!block->moving && (flags & (CMM_PUSHBLOCKS | CMM_PUSHBLOCKSNOW)))
-	    block->dir = dir;
+	if (!crmoving(block) && (flags & (CMM_PUSHBLOCKS | CMM_PUSHBLOCKSNOW)))
+	    crdir(block) = dir;
 	return FALSE;
     }
     if (flags & (CMM_PUSHBLOCKS | CMM_PUSHBLOCKSNOW)) {
-	block->dir = dir;
-	block->tdir = dir;
-	block->state |= CS_PUSHED;
+	crdir(block) = dir;
+	crtdir(block) = dir;
+	crstate(block) |= CS_PUSHED;
 	if (flags & CMM_PUSHBLOCKSNOW)
 	    advancecreature(block, FALSE);
     }
@@ -717,16 +818,16 @@ static int canpushblock(creature *block, int dir, int flags)
  * the given direction. Side effects can and will occur from calling
  * this function, as indicated by flags.
  */
-static int canmakemove(creature const *cr, int dir, int flags)
+static int canmakemove(int cr, int dir, int flags)
 {
-    creature   *other;
+    int		other;
     int		floor;
     int		to, y, x;
 
-    _assert(cr);
+    _assert(cr >= 0);
     _assert(dir != NIL);
 
-    floor = floorat(cr->pos);
+    floor = floorat(crpos(cr));
     switch (floor) {
       case Wall_North:         if (dir & NORTH) return FALSE;            break;
       case Wall_West:          if (dir & WEST) return FALSE;             break;
@@ -743,12 +844,12 @@ static int canmakemove(creature const *cr, int dir, int flags)
 	    return FALSE;
 	break;
     }
-    if (isslide(floor) && (cr->id != Chip || !possession(Boots_Slide))
+    if (isslide(floor) && (crid(cr) != Chip || !possession(Boots_Slide))
 		       && getslidedir(floor, FALSE) == back(dir))
 	return FALSE;
 
-    y = cr->pos / CXGRID;
-    x = cr->pos % CXGRID;
+    y = crpos(cr) / CXGRID;
+    x = crpos(cr) % CXGRID;
     y += dir == NORTH ? -1 : dir == SOUTH ? +1 : 0;
     x += dir == WEST ? -1 : dir == EAST ? +1 : 0;
     to = y * CXGRID + x;
@@ -769,7 +870,7 @@ static int canmakemove(creature const *cr, int dir, int flags)
     if (floor == SwitchWall_Open || floor == SwitchWall_Closed)
 	floor ^= togglestate();
 
-    if (cr->id == Chip) {
+    if (crid(cr) == Chip) {
 	if (!(movelaws[floor].chip & dir))
 	    return FALSE;
 	if (floor == Socket && chipsneeded() > 0)
@@ -779,7 +880,7 @@ static int canmakemove(creature const *cr, int dir, int flags)
 	if (ismarkedanimated(to))
 	    return FALSE;
 	other = lookupcreature(to, FALSE);
-	if (other && other->id == Block) {
+	if (other >= 0 && crid(other) == Block) {
 	    if (!canpushblock(other, dir, flags & ~CMM_RELEASING))
 		return FALSE;
 	}
@@ -788,8 +889,8 @@ static int canmakemove(creature const *cr, int dir, int flags)
 		floorat(to) = Wall;
 	    return FALSE;
 	}
-    } else if (cr->id == Block) {
-	if (cr->moving > 0)
+    } else if (crid(cr) == Block) {
+	if (crmoving(cr) > 0)
 	    return FALSE;
 	if (!(movelaws[floor].block & dir))
 	    return FALSE;
@@ -803,7 +904,7 @@ static int canmakemove(creature const *cr, int dir, int flags)
 	    return FALSE;
 	if (islocationclaimed(to))
 	    return FALSE;
-	if (floor == Fire && cr->id != Fireball)
+	if (floor == Fire && crid(cr) != Fireball)
 	    return FALSE;
 	if (flags & CMM_CLEARANIMATIONS)
 	    if (ismarkedanimated(to))
@@ -821,33 +922,33 @@ static int canmakemove(creature const *cr, int dir, int flags)
  * Given a creature, this function enumerates its desired direction
  * of movement and selects the first one that is permitted.
  */
-static void choosecreaturemove(creature *cr)
+static void choosecreaturemove(int cr)
 {
     int		choices[4] = { NIL, NIL, NIL, NIL };
     int		dir, pdir;
     int		floor;
     int		y, x, m, n;
 
-    if (isanimation(cr->id))
+    if (isanimation(crid(cr)))
 	return;
 
-    cr->tdir = NIL;
-    if (cr->id == Block)
+    crtdir(cr) = NIL;
+    if (crid(cr) == Block)
 	return;
     if (getfdir(cr) != NIL)
 	return;
-    floor = floorat(cr->pos);
+    floor = floorat(crpos(cr));
     if (floor == CloneMachine || floor == Beartrap) {
-	cr->tdir = cr->dir;
+	crtdir(cr) = crdir(cr);
 	return;
     }
 
-    dir = cr->dir;
+    dir = crdir(cr);
     pdir = NIL;
 
     _assert(dir != NIL);
 
-    switch (cr->id) {
+    switch (crid(cr)) {
       case Tank:
 	choices[0] = dir;
 	break;
@@ -889,8 +990,8 @@ static void choosecreaturemove(creature *cr)
       case Teeth:
 	if ((currenttime() + stepping()) & 4)
 	    return;
-	y = chippos() / CXGRID - cr->pos / CXGRID;
-	x = chippos() % CXGRID - cr->pos % CXGRID;
+	y = chippos() / CXGRID - crpos(cr) / CXGRID;
+	x = chippos() % CXGRID - crpos(cr) % CXGRID;
 	n = y < 0 ? NORTH : y > 0 ? SOUTH : NIL;
 	if (y < 0)
 	    y = -y;
@@ -911,27 +1012,27 @@ static void choosecreaturemove(creature *cr)
     for (n = 0 ; n < 4 && choices[n] != NIL ; ++n) {
 	if (choices[n] == WALKER_TURN) {
 	    m = lynx_prng() & 3;
-	    choices[n] = cr->dir;
+	    choices[n] = crdir(cr);
 	    while (m--)
 		choices[n] = right(choices[n]);
 	} else if (choices[n] == BLOB_TURN) {
 	    int cw[4] = { NORTH, EAST, SOUTH, WEST };
 	    choices[n] = cw[random4(mainprng())];
 	}
-	cr->tdir = choices[n];
+	crtdir(cr) = choices[n];
 	if (canmakemove(cr, choices[n], CMM_CLEARANIMATIONS))
 	    return;
     }
 
     if (pdir != NIL)
-	cr->tdir = pdir;
+	crtdir(cr) = pdir;
 }
 
 /* Determine the direction of Chip's next move. If discard is TRUE,
  * then Chip is not currently permitted to select a direction of
  * movement, and the player's input should not be retained.
  */
-static void choosechipmove(creature *cr, int discard)
+static void choosechipmove(int cr, int discard)
 {
     int	dir;
     int	f1, f2;
@@ -945,32 +1046,32 @@ static void choosechipmove(creature *cr, int discard)
 	dir = NIL;
 
     if (dir == NIL || discard || chipstuck()) {
-	cr->tdir = NIL;
+	crtdir(cr) = NIL;
 	return;
     }
 
     lastmove() = dir;
-    cr->tdir = dir;
+    crtdir(cr) = dir;
 
-    if (cr->tdir != NIL)
-	dir = cr->tdir;
+    if (crtdir(cr) != NIL)
+	dir = crtdir(cr);
     else if (getfdir(cr) != NIL)
 	dir = getfdir(cr);
     else
 	return;
 
     if (isdiagonal(dir)) {
-	if (cr->dir & dir) {
-	    f1 = canmakemove(cr, cr->dir, CMM_PUSHBLOCKS);
-	    f2 = canmakemove(cr, cr->dir ^ dir, CMM_PUSHBLOCKS);
-	    dir = !f1 && f2 ? dir ^ cr->dir : cr->dir;
+	if (crdir(cr) & dir) {
+	    f1 = canmakemove(cr, crdir(cr), CMM_PUSHBLOCKS);
+	    f2 = canmakemove(cr, crdir(cr) ^ dir, CMM_PUSHBLOCKS);
+	    dir = !f1 && f2 ? dir ^ crdir(cr) : crdir(cr);
 	} else {
 	    if (canmakemove(cr, dir & (EAST | WEST), CMM_PUSHBLOCKS))
 		dir &= EAST | WEST;
 	    else
 		dir &= NORTH | SOUTH;
 	}
-	cr->tdir = dir;
+	crtdir(cr) = dir;
     } else {
 	(void)canmakemove(cr, dir, CMM_PUSHBLOCKS);
     }
@@ -984,34 +1085,34 @@ static void choosechipmove(creature *cr, int discard)
  * creature's fdir field, and TRUE is returned unless the creature can
  * override the forced move.
  */
-static int getforcedmove(creature *cr)
+static int getforcedmove(int cr)
 {
     int	floor;
 
     setfdir(cr, NIL);
 
-    floor = floorat(cr->pos);
+    floor = floorat(crpos(cr));
 
     if (currenttime() == 0)
 	return FALSE;
 
     if (isice(floor)) {
-	if (cr->id == Chip && possession(Boots_Ice))
+	if (crid(cr) == Chip && possession(Boots_Ice))
 	    return FALSE;
-	if (cr->id == Chip && chipstuck())
+	if (crid(cr) == Chip && chipstuck())
 	    return FALSE;
-	if (cr->dir == NIL)
+	if (crdir(cr) == NIL)
 	    return FALSE;
-	setfdir(cr, cr->dir);
+	setfdir(cr, crdir(cr));
 	return TRUE;
     } else if (isslide(floor)) {
-	if (cr->id == Chip && possession(Boots_Slide))
+	if (crid(cr) == Chip && possession(Boots_Slide))
 	    return FALSE;
 	setfdir(cr, getslidedir(floor, TRUE));
-	return !(cr->state & CS_SLIDETOKEN);
-    } else if (cr->state & CS_TELEPORTED) {
-	cr->state &= ~CS_TELEPORTED;
-	setfdir(cr, cr->dir);
+	return !(crstate(cr) & CS_SLIDETOKEN);
+    } else if (crstate(cr) & CS_TELEPORTED) {
+	crstate(cr) &= ~CS_TELEPORTED;
+	setfdir(cr, crdir(cr));
 	return TRUE;
     }
 
@@ -1020,87 +1121,110 @@ static int getforcedmove(creature *cr)
 
 /* Return the move a creature will make on the current tick.
  */
-static int choosemove(creature *cr)
+static int choosemove(int cr)
 {
-    if (cr->id == Chip) {
+    if (crid(cr) == Chip) {
 	choosechipmove(cr, getforcedmove(cr));
-	if (cr->tdir == NIL && getfdir(cr) == NIL)
+	if (crtdir(cr) == NIL && getfdir(cr) == NIL)
 	    resetfloorsounds(FALSE);
     } else {
 	if (getforcedmove(cr))
-	    cr->tdir = NIL;
+	    crtdir(cr) = NIL;
 	else
 	    choosecreaturemove(cr);
     }
 
-    return cr->tdir != NIL || getfdir(cr) != NIL;
+    return crtdir(cr) != NIL || getfdir(cr) != NIL;
 }
 
 /* Update the location that Chip is currently moving into (and reset
- * the pointer to the creature that Chip is colliding with).
+ * the creature that Chip is colliding with).
  */
 static void checkmovingto(void)
 {
-    creature   *cr;
+    int		cr;
     int		dir;
 
     cr = getchip();
-    dir = cr->tdir;
+    dir = crtdir(cr);
     if (dir == NIL || isdiagonal(dir)) {
 	chiptopos() = -1;
-	chiptocr() = NULL;
+	chiptocr() = NOCREATURE;
 	return;
     }
 
-    chiptopos() = cr->pos + delta[dir];
-    chiptocr() = NULL;
+    chiptopos() = crpos(cr) + delta[dir];
+    chiptocr() = NOCREATURE;
 }
 
 /*
  * Special movements.
  */
 
+/* Return the index of the first entry in the teleport list at or
+ * after the given location.
+ */
+static int findteleport(int pos)
+{
+    int	lo, hi, mid;
+
+    lo = 0;
+    hi = teleportlistsize();
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (teleportlist()[mid] < pos)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
 /* Teleport the given creature instantaneously from one teleport tile
- * to another.
+ * to another. The teleports are tried in reverse reading order. Only
+ * the cells marked as teleports are visited, since no other cell can
+ * ever hold one, and the marked cells passed over on the way have
+ * their teleports restored.
  */
-static int teleportcreature(creature *cr)
+static int teleportcreature(int cr)
 {
-    int pos, origpos;
+    int pos, origpos, i;
 
-    _assert(floorat(cr->pos) == Teleport);
+    _assert(floorat(crpos(cr)) == Teleport);
 
-    origpos = pos = cr->pos;
+    origpos = crpos(cr);
+    i = findteleport(origpos);
+    _assert(i < teleportlistsize() && teleportlist()[i] == origpos);
 
     for (;;) {
-	--pos;
-	if (pos < 0)
-	    pos += CXGRID * CYGRID;
+	i = (i ? i : teleportlistsize()) - 1;
+	pos = teleportlist()[i];
 	if (floorat(pos) == Teleport) {
-	    if (cr->id != Chip)
-		removeclaim(cr->pos);
-	    cr->pos = pos;
-	    if (!islocationclaimed(pos) && canmakemove(cr, cr->dir, 0))
+	    if (crid(cr) != Chip)
+		removeclaim(crpos(cr));
+	    crpos(cr) = pos;
+	    if (!islocationclaimed(pos) && canmakemove(cr, crdir(cr), 0))
 		break;
 	    if (pos == origpos) {
-		if (cr->id == Chip)
+		if (crid(cr) == Chip)
 		    chipstuck() = TRUE;
 		else
-		    claimlocation(cr->pos);
+		    claimlocation(crpos(cr));
 		return FALSE;
 	    }
 	}
 	else if (ismarkedteleport(pos)) {
 	    floorat(pos) = Teleport;
 	    if (pos == chippos())
-	        getchip()->hidden = TRUE;
+	        crhidden(getchip()) = TRUE;
 	}
     }
 
-    if (cr->id == Chip)
+    if (crid(cr) == Chip)
 	addsoundeffect(SND_TELEPORTING);
     else
-	claimlocation(cr->pos);
-    cr->state |= CS_TELEPORTED;
+	claimlocation(crpos(cr));
+    crstate(cr) |= CS_TELEPORTED;
     return TRUE;
 }
 
@@ -1109,8 +1233,8 @@ static int teleportcreature(creature *cr)
  */
 static int activatecloner(int pos)
 {
-    creature   *cr;
-    creature   *clone;
+    int		cr;
+    int		clone;
 
     if (pos < 0)
 	return FALSE;
@@ -1125,15 +1249,15 @@ static int activatecloner(int pos)
 	return FALSE;
     }
     cr = lookupcreature(pos, TRUE);
-    if (!cr)
+    if (cr < 0)
 	return FALSE;
     clone = newcreature();
-    if (!clone)
+    if (clone < 0)
 	return advancecreature(cr, TRUE) != 0;
 
-    *clone = *cr;
+    copycreature(clone, cr);
     if (advancecreature(cr, TRUE) <= 0) {
-	clone->hidden = TRUE;
+	crhidden(clone) = TRUE;
 	return FALSE;
     }
     return TRUE;
@@ -1143,7 +1267,7 @@ static int activatecloner(int pos)
  */
 static void springtrap(int pos)
 {
-    creature   *cr;
+    int		cr;
 
     if (pos < 0)
 	return;
@@ -1158,7 +1282,7 @@ static void springtrap(int pos)
 	return;
     }
     cr = lookupcreature(pos, TRUE);
-    if (cr && cr->dir != NIL)
+    if (cr >= 0 && crdir(cr) != NIL)
 	advancecreature(cr, TRUE);
 }
 
@@ -1173,31 +1297,31 @@ static void springtrap(int pos)
  * moving, 0 is returned if the move could not be initiated, and -1 is
  * returned if the creature was killed in the attempt.
  */
-static int startmovement(creature *cr, int releasing)
+static int startmovement(int cr, int releasing)
 {
-    creature   *other;
+    int		other;
     int		dir;
     int		floorfrom;
 
-    _assert(cr->moving <= 0);
+    _assert(crmoving(cr) <= 0);
 
-    if (cr->tdir != NIL)
-	dir = cr->tdir;
+    if (crtdir(cr) != NIL)
+	dir = crtdir(cr);
     else if (getfdir(cr) != NIL)
 	dir = getfdir(cr);
     else
 	return 0;
     _assert(!isdiagonal(dir));
 
-    cr->dir = dir;
-    floorfrom = floorat(cr->pos);
+    crdir(cr) = dir;
+    floorfrom = floorat(crpos(cr));
 
-    if (cr->id == Chip) {
+    if (crid(cr) == Chip) {
 	if (!possession(Boots_Slide)) {
-	    if (isslide(floorfrom) && cr->tdir == NIL)
-		cr->state |= CS_SLIDETOKEN;
+	    if (isslide(floorfrom) && crtdir(cr) == NIL)
+		crstate(cr) |= CS_SLIDETOKEN;
 	    else if (!isice(floorfrom) || possession(Boots_Ice))
-		cr->state &= ~CS_SLIDETOKEN;
+		crstate(cr) &= ~CS_SLIDETOKEN;
 	}
     }
 
@@ -1205,15 +1329,15 @@ static int startmovement(creature *cr, int releasing)
 					| CMM_CLEARANIMATIONS
 					| CMM_STARTMOVEMENT
 					| (releasing ? CMM_RELEASING : 0))) {
-	if (cr->id == Chip) {
+	if (crid(cr) == Chip) {
 	    if (!couldntmove()) {
 		couldntmove() = TRUE;
 		addsoundeffect(SND_CANT_MOVE);
 	    }
 	    chippushing() = TRUE;
 	}
-	if (isice(floorfrom) && (cr->id != Chip || !possession(Boots_Ice))) {
-	    cr->dir = back(dir);
+	if (isice(floorfrom) && (crid(cr) != Chip || !possession(Boots_Ice))) {
+	    crdir(cr) = back(dir);
 	    applyicewallturn(cr);
 	}
 	return 0;
@@ -1227,36 +1351,36 @@ static int startmovement(creature *cr, int releasing)
     if (floorfrom == CloneMachine || floorfrom == Beartrap)
 	_assert(releasing);
 
-    if (cr->id != Chip) {
-	removeclaim(cr->pos);
-	if (cr->id != Block && cr->pos == chiptopos())
+    if (crid(cr) != Chip) {
+	removeclaim(crpos(cr));
+	if (crid(cr) != Block && crpos(cr) == chiptopos())
 	    chiptocr() = cr;
-    } else if (chiptocr() && !chiptocr()->hidden) {
-	chiptocr()->moving = 8;
+    } else if (chiptocr() >= 0 && !crhidden(chiptocr())) {
+	crmoving(chiptocr()) = 8;
 	removechip(CHIP_COLLIDED, chiptocr());
 	return -1;
     }
 
-    cr->pos += delta[dir];
-    if (cr->id != Chip)
-	claimlocation(cr->pos);
+    crpos(cr) += delta[dir];
+    if (crid(cr) != Chip)
+	claimlocation(crpos(cr));
 
-    cr->moving += 8;
+    crmoving(cr) += 8;
 
-    if (cr->id != Chip && cr->pos == chippos() && !getchip()->hidden) {
+    if (crid(cr) != Chip && crpos(cr) == chippos() && !crhidden(getchip())) {
 	removechip(CHIP_COLLIDED, cr);
 	return -1;
     }
-    if (cr->id == Chip) {
+    if (crid(cr) == Chip) {
 	couldntmove() = FALSE;
-	other = lookupcreature(cr->pos, FALSE);
-	if (other) {
+	other = lookupcreature(crpos(cr), FALSE);
+	if (other >= 0) {
 	    removechip(CHIP_COLLIDED, other);
 	    return -1;
 	}
     }
 
-    if (cr->state & CS_PUSHED) {
+    if (crstate(cr) & CS_PUSHED) {
 	chippushing() = TRUE;
 	addsoundeffect(SND_BLOCK_MOVING);
     }
@@ -1266,27 +1390,27 @@ static int startmovement(creature *cr, int releasing)
 
 /* Continue the given creature's move.
  */
-static int continuemovement(creature *cr)
+static int continuemovement(int cr)
 {
     int	floor, speed;
 
-    if (isanimation(cr->id))
+    if (isanimation(crid(cr)))
 	return TRUE;
 
-    _assert(cr->moving > 0);
+    _assert(crmoving(cr) > 0);
 
-    if (cr->id == Chip && chipstuck())
+    if (crid(cr) == Chip && chipstuck())
 	return TRUE;
 
-    speed = cr->id == Blob ? 1 : 2;
-    floor = floorat(cr->pos);
-    if (isslide(floor) && (cr->id != Chip || !possession(Boots_Slide)))
+    speed = crid(cr) == Blob ? 1 : 2;
+    floor = floorat(crpos(cr));
+    if (isslide(floor) && (crid(cr) != Chip || !possession(Boots_Slide)))
 	speed *= 2;
-    else if (isice(floor) && (cr->id != Chip || !possession(Boots_Ice)))
+    else if (isice(floor) && (crid(cr) != Chip || !possession(Boots_Ice)))
 	speed *= 2;
-    cr->moving -= speed;
-    cr->frame = cr->moving / 2;
-    return cr->moving > 0;
+    crmoving(cr) -= speed;
+    crframe(cr) = crmoving(cr) / 2;
+    return crmoving(cr) > 0;
 }
 
 /* Complete the movement of the given creature. Most side effects
@@ -1295,50 +1419,50 @@ static int continuemovement(creature *cr)
  * returns. If stationary is TRUE, we are in pedantic mode and
  * handling creatures starting on top of something.
  */
-static int endmovement(creature *cr, int stationary)
+static int endmovement(int cr, int stationary)
 {
     int	floor;
     int	survived = TRUE;
 
     _assert(!stationary || pedanticmode);
 
-    if (isanimation(cr->id))
+    if (isanimation(crid(cr)))
 	return TRUE;
 
-    _assert(cr->moving <= 0);
+    _assert(crmoving(cr) <= 0);
 
-    floor = floorat(cr->pos);
+    floor = floorat(crpos(cr));
 
-    if (cr->id == Chip && putwall() != -1)
+    if (crid(cr) == Chip && putwall() != -1)
         return TRUE;
 
-    if (cr->id == Chip && !possession(Boots_Ice))
+    if (crid(cr) == Chip && !possession(Boots_Ice))
 	applyicewallturn(cr);
-    if (cr->id != Chip && !stationary)
+    if (crid(cr) != Chip && !stationary)
 	applyicewallturn(cr);
 
-    if (cr->id == Chip) {
+    if (crid(cr) == Chip) {
 	switch (floor) {
 	  case Water:
 	    if (!possession(Boots_Water)) {
-		removechip(CHIP_DROWNED, NULL);
+		removechip(CHIP_DROWNED, NOCREATURE);
 		survived = FALSE;
 	    }
 	    break;
 	  case Fire:
 	    if (stationary) break;
 	    if (!possession(Boots_Fire)) {
-		removechip(CHIP_BURNED, NULL);
+		removechip(CHIP_BURNED, NOCREATURE);
 		survived = FALSE;
 	    }
 	    break;
 	  case Dirt:
 	  case BlueWall_Fake:
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    addsoundeffect(SND_TILE_EMPTIED);
 	    break;
 	  case PopupWall:
-	    floorat(cr->pos) = Wall;
+	    floorat(crpos(cr)) = Wall;
 	    addsoundeffect(SND_WALL_CREATED);
 	    break;
 	  case Door_Red:
@@ -1348,7 +1472,7 @@ static int endmovement(creature *cr, int stationary)
 	    _assert(possession(floor));
 	    if (floor != Door_Green)
 		--possession(floor);
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    addsoundeffect(SND_DOOR_OPENED);
 	    break;
 	  case Key_Red:
@@ -1363,7 +1487,7 @@ static int endmovement(creature *cr, int stationary)
 	  case Boots_Fire:
 	  case Boots_Water:
 	    ++possession(floor);
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    addsoundeffect(SND_ITEM_COLLECTED);
 	    break;
 	  case Burglar:
@@ -1377,43 +1501,43 @@ static int endmovement(creature *cr, int stationary)
 	    if (stationary) break;
 	    if (chipsneeded())
 		--chipsneeded();
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    addsoundeffect(SND_IC_COLLECTED);
 	    break;
 	  case Socket:
 	    _assert(stationary || chipsneeded() == 0);
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    addsoundeffect(SND_SOCKET_OPENED);
 	    break;
 	  case Exit:
-	    cr->hidden = TRUE;
+	    crhidden(cr) = TRUE;
 	    completed() = TRUE;
 	    addsoundeffect(SND_CHIP_WINS);
 	    break;
 	}
-    } else if (cr->id == Block) {
+    } else if (crid(cr) == Block) {
 	switch (floor) {
 	  case Water:
-	    floorat(cr->pos) = Dirt;
+	    floorat(crpos(cr)) = Dirt;
 	    addsoundeffect(SND_WATER_SPLASH);
 	    removecreature(cr, Water_Splash);
 	    survived = FALSE;
 	    break;
 	  case Key_Blue:
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    break;
 	}
     } else {
 	switch (floor) {
 	  case Water:
-	    if (cr->id != Glider) {
+	    if (crid(cr) != Glider) {
 		addsoundeffect(SND_WATER_SPLASH);
 		removecreature(cr, Water_Splash);
 		survived = FALSE;
 	    }
 	    break;
 	  case Key_Blue:
-	    floorat(cr->pos) = Empty;
+	    floorat(crpos(cr)) = Empty;
 	    break;
 	}
     }
@@ -1424,9 +1548,9 @@ static int endmovement(creature *cr, int stationary)
     switch (floor) {
       case Bomb:
 	if (stationary) break;
-	floorat(cr->pos) = Empty;
-	if (cr->id == Chip) {
-	    removechip(CHIP_BOMBED, NULL);
+	floorat(crpos(cr)) = Empty;
+	if (crid(cr) == Chip) {
+	    removechip(CHIP_BOMBED, NOCREATURE);
 	} else {
 	    addsoundeffect(SND_BOMB_EXPLODES);
 	    removecreature(cr, Bomb_Explosion);
@@ -1449,7 +1573,7 @@ static int endmovement(creature *cr, int stationary)
 	break;
       case Button_Red:
 	if (stationary) break;
-	if (activatecloner(clonerfrombutton(cr->pos)))
+	if (activatecloner(clonerfrombutton(crpos(cr))))
 	    addsoundeffect(SND_BUTTON_PUSHED);
 	break;
       case Button_Brown:
@@ -1461,7 +1585,7 @@ static int endmovement(creature *cr, int stationary)
 	/* Intentional fall-through */
       case Dirt:
       case BlueWall_Fake:
-	floorat(cr->pos) = Empty; /* No sound effect */
+	floorat(crpos(cr)) = Empty; /* No sound effect */
 	break;
     }
 
@@ -1478,34 +1602,34 @@ static int endmovement(creature *cr, int stationary)
  * creature tried to move and failed, or -1 if the creature was killed
  * and exists no longer.
  */
-static int advancecreature(creature *cr, int releasing)
+static int advancecreature(int cr, int releasing)
 {
     char	tdir = NIL;
     int		f;
 
-    if (cr->moving <= 0 && !isanimation(cr->id)) {
+    if (crmoving(cr) <= 0 && !isanimation(crid(cr))) {
 	if (releasing) {
-	    _assert(cr->dir != NIL);
-	    tdir = cr->tdir;
-	    cr->tdir = cr->dir;
-	} else if (cr->tdir == NIL && getfdir(cr) == NIL) {
+	    _assert(crdir(cr) != NIL);
+	    tdir = crtdir(cr);
+	    crtdir(cr) = crdir(cr);
+	} else if (crtdir(cr) == NIL && getfdir(cr) == NIL) {
 	    if (pedanticmode && !endmovement(cr, TRUE))
 	        return -1;
 	    return +1;
 	}
 	f = startmovement(cr, releasing);
 	if (f > 0)
-	    cr->hidden = FALSE;
+	    crhidden(cr) = FALSE;
 	if (pedanticmode && f == 0 && !endmovement(cr, TRUE))
 	    return -1;
 	if (f < 0)
 	    return f;
 	if (f == 0) {
 	    if (releasing)
-		cr->tdir = tdir;
+		crtdir(cr) = tdir;
 	    return 0;
 	}
-	cr->tdir = NIL;
+	crtdir(cr) = NIL;
     }
 
     if (!continuemovement(cr)) {
@@ -1526,7 +1650,7 @@ static int advancecreature(creature *cr, int releasing)
  */
 static void dumpmap(void)
 {
-    creature   *cr;
+    int		cr;
     int		y, x;
 
     for (y = 0 ; y < CXGRID * CYGRID ; y += CXGRID) {
@@ -1537,13 +1661,13 @@ static void dumpmap(void)
 	fputc('\n', stderr);
     }
     fputc('\n', stderr);
-    for (cr = creaturelist() ; cr->id ; ++cr)
+    for (cr = 0 ; crid(cr) ; ++cr)
 	fprintf(stderr, "%02X%c%1d (%d %d)%s%s%s\n",
-			cr->id, "-^<?v?\?\?>"[(int)cr->dir],
-			cr->moving, cr->pos % CXGRID, cr->pos / CXGRID,
-			cr->hidden ? " dead" : "",
-			cr->state & CS_SLIDETOKEN ? " slide-token" : "",
-			cr->state & CS_REVERSE ? " reversing" : "");
+			crid(cr), "-^<?v?\?\?>"[(int)crdir(cr)],
+			crmoving(cr), crpos(cr) % CXGRID, crpos(cr) / CXGRID,
+			crhidden(cr) ? " dead" : "",
+			crstate(cr) & CS_SLIDETOKEN ? " slide-token" : "",
+			crstate(cr) & CS_REVERSE ? " reversing" : "");
     fflush(stderr);
 }
 
@@ -1551,7 +1675,7 @@ static void dumpmap(void)
  */
 static void verifymap(void)
 {
-    creature   *cr;
+    int		cr;
     int		pos;
 
     for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
@@ -1565,40 +1689,78 @@ static void verifymap(void)
 		 pos % CXGRID, pos / CXGRID);
     }
 
-    for (cr = creaturelist() ; cr->id ; ++cr) {
-	if (isanimation(state->map[cr->pos].top.id)) {
-	    if (cr->moving > 12)
+    for (cr = 0 ; crid(cr) ; ++cr) {
+	if (isanimation(state->map[crpos(cr)].top.id)) {
+	    if (crmoving(cr) > 12)
 		warn("%d: Too-large animation frame %02X at (%d %d)",
-		     currenttime(), cr->moving,
-		     cr->pos % CXGRID, cr->pos / CXGRID);
+		     currenttime(), crmoving(cr),
+		     crpos(cr) % CXGRID, crpos(cr) / CXGRID);
 	    continue;
 	}
-	if (cr->id < 0x40 || cr->id >= 0x80)
+	if (crid(cr) < 0x40 || crid(cr) >= 0x80)
 	    warn("%d: Undefined creature %d:%d at (%d %d)",
-		 currenttime(), cr - creaturelist(), cr->id,
-		 cr->pos % CXGRID, cr->pos / CXGRID);
-	if (cr->pos < 0 || cr->pos >= CXGRID * CYGRID)
+		 currenttime(), cr, crid(cr),
+		 crpos(cr) % CXGRID, crpos(cr) / CXGRID);
+	if (crpos(cr) < 0 || crpos(cr) >= CXGRID * CYGRID)
 	    warn("%d: Creature %d:%d has left the map: %04X",
-		 currenttime(), cr - creaturelist(), cr->id, cr->pos);
-	if (isanimation(cr->id))
+		 currenttime(), cr, crid(cr), crpos(cr));
+	if (isanimation(crid(cr)))
 	    continue;
-	if (cr->dir > EAST && (cr->dir != NIL || cr->id != Block))
+	if (crdir(cr) > EAST && (crdir(cr) != NIL || crid(cr) != Block))
 	    warn("%d: Creature %d:%d moving in illegal direction (%d)",
-		 currenttime(), cr - creaturelist(), cr->id, cr->dir);
-	if (cr->dir == NIL)
+		 currenttime(), cr, crid(cr), crdir(cr));
+	if (crdir(cr) == NIL)
 	    warn("%d: Creature %d:%d lacks direction",
-		 currenttime(), cr - creaturelist(), cr->id);
-	if (cr->moving > 8)
+		 currenttime(), cr, crid(cr));
+	if (crmoving(cr) > 8)
 	    warn("%d: Creature %d:%d has a moving time of %d",
-		 currenttime(), cr - creaturelist(), cr->id, cr->moving);
-	if (cr->moving < 0)
+		 currenttime(), cr, crid(cr), crmoving(cr));
+	if (crmoving(cr) < 0)
 	    warn("%d: Creature %d:%d has a negative moving time: %d",
-		 currenttime(), cr - creaturelist(), cr->id, cr->moving);
+		 currenttime(), cr, crid(cr), crmoving(cr));
     }
 }
 
 #endif
 
+/* Return the index of the lowest bit that is set in a nonzero word.
+ */
+static int lowestbit(unsigned long bits)
+{
+#ifdef __GNUC__
+    return __builtin_ctzl(bits);
+#else
+    int	n = 0;
+
+    for ( ; !(bits & 0xFF) ; bits >>= 8)
+	n += 8;
+    for ( ; !(bits & 1) ; bits >>= 1)
+	++n;
+    return n;
+#endif
+}
+
+/* Return the first location at or after pos that is set in the
+ * bitplane, or -1 if there is none. Words with no bits set are
+ * skipped whole.
+ */
+static int nextplanebit(unsigned long const *plane, int pos)
+{
+    unsigned long	bits;
+    int			y;
+
+    if (pos >= CXGRID * CYGRID)
+	return -1;
+    y = pos / CXGRID;
+    bits = plane[y] & (~0UL << (pos % CXGRID));
+    while (!bits) {
+	if (++y >= CYGRID)
+	    return -1;
+	bits = plane[y];
+    }
+    return y * CXGRID + lowestbit(bits);
+}
+
 /*
  * Per-tick maintenance functions.
  */
@@ -1607,9 +1769,10 @@ static void verifymap(void)
  */
 static void initialhousekeeping(void)
 {
-    creature   *chip;
-    creature   *cr;
-    int		pos;
+    int			chip;
+    int			cr, end;
+    int			reverse, stop, stopped;
+    int			pos;
 
 #ifndef NDEBUG
     verifymap();
@@ -1621,42 +1784,47 @@ static void initialhousekeeping(void)
     }
 
     chip = getchip();
-    if (chip->id == Pushing_Chip)
-	chip->id = Chip;
+    if (crid(chip) == Pushing_Chip)
+	crid(chip) = Chip;
 
     if (!inendgame()) {
 	if (completed()) {
 	    startendgametimer();
 	    timeoffset() = 1;
 	} else if (timelimit() && currenttime() >= timelimit()) {
-	    removechip(CHIP_OUTOFTIME, NULL);
+	    removechip(CHIP_OUTOFTIME, NOCREATURE);
 	}
     }
 
-    for (cr = creaturelist() ; cr->id ; ++cr) {
-	if (cr != getchip() && cr->hidden)
-	    continue;
-	if (cr->state & CS_REVERSE) {
-	    cr->state &= ~CS_REVERSE;
-	    if (cr->moving <= 0)
-		cr->dir = back(cr->dir);
-	}
-    }
-    for (cr = creaturelist() ; cr->id ; ++cr) {
-	if (cr->state & CS_PUSHED) {
-	    if (cr->hidden || cr->moving <= 0) {
-		stopsoundeffect(SND_BLOCK_MOVING);
-		cr->state &= ~CS_PUSHED;
-	    }
-	}
-    }
+    /* These two passes run over a known number of creatures, and
+     * combine their tests with bitwise operators instead of branches,
+     * so that they can be vectorized when the fields are in separate
+     * arrays.
+     */
+    end = creaturelistend();
+    for (cr = 0 ; cr <= end ; ++cr) {
+	reverse = ((crstate(cr) & CS_REVERSE) != 0)
+				& ((cr == getchip()) | !crhidden(cr));
+	crdir(cr) = reverse & (crmoving(cr) <= 0) ? back(crdir(cr))
+						  : crdir(cr);
+	crstate(cr) &= ~(reverse * CS_REVERSE);
+    }
+    stopped = FALSE;
+    for (cr = 0 ; cr <= end ; ++cr) {
+	stop = ((crstate(cr) & CS_PUSHED) != 0)
+				& ((crhidden(cr) != 0) | (crmoving(cr) <= 0));
+	crstate(cr) &= ~(stop * CS_PUSHED);
+	stopped |= stop;
+    }
+    if (stopped)
+	stopsoundeffect(SND_BLOCK_MOVING);
 
     if (togglestate()) {
-	for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
+	for (pos = nextplanebit(switchwalls(), 0) ; pos >= 0 ;
+	     pos = nextplanebit(switchwalls(), pos + 1))
 	    if (floorat(pos) == SwitchWall_Open
 				|| floorat(pos) == SwitchWall_Closed)
 		floorat(pos) ^= togglestate();
-	}
 	togglestate() = 0;
     }
 
@@ -1693,7 +1861,7 @@ static void initialhousekeeping(void)
 #endif
 
     chiptopos() = -1;
-    chiptocr() = NULL;
+    chiptocr() = NOCREATURE;
 }
 
 /* Actions and checks that occur at the end of every tick.
@@ -1707,31 +1875,31 @@ static void finalhousekeeping(void)
  */
 static void preparedisplay(void)
 {
-    creature   *chip;
+    int		chip;
     int		floor;
 
     chip = getchip();
-    floor = floorat(chip->pos);
-
-    xviewpos() = (chip->pos % CXGRID) * 8 + xviewoffset() * 8;
-    yviewpos() = (chip->pos / CXGRID) * 8 + yviewoffset() * 8;
-    if (chip->moving) {
-	switch (chip->dir) {
-	  case NORTH:	yviewpos() += chip->moving;	break;
-	  case WEST:	xviewpos() += chip->moving;	break;
-	  case SOUTH:	yviewpos() -= chip->moving;	break;
-	  case EAST:	xviewpos() -= chip->moving;	break;
+    floor = floorat(crpos(chip));
+
+    xviewpos() = (crpos(chip) % CXGRID) * 8 + xviewoffset() * 8;
+    yviewpos() = (crpos(chip) / CXGRID) * 8 + yviewoffset() * 8;
+    if (crmoving(chip)) {
+	switch (crdir(chip)) {
+	  case NORTH:	yviewpos() += crmoving(chip);	break;
+	  case WEST:	xviewpos() += crmoving(chip);	break;
+	  case SOUTH:	yviewpos() -= crmoving(chip);	break;
+	  case EAST:	xviewpos() -= crmoving(chip);	break;
 	}
     }
 
-    if (!chip->hidden) {
-	if (floor == HintButton && chip->moving <= 0)
+    if (!crhidden(chip)) {
+	if (floor == HintButton && crmoving(chip) <= 0)
 	    showhint();
 	else
 	    hidehint();
-	if (chip->id == Chip && chippushing())
-	    chip->id = Pushing_Chip;
-	if (chip->moving) {
+	if (crid(chip) == Chip && chippushing())
+	    crid(chip) = Pushing_Chip;
+	if (crmoving(chip)) {
 	    resetfloorsounds(FALSE);
 	    if (floor == Fire && possession(Boots_Fire))
 		addsoundeffect(SND_FIREWALKING);
@@ -1767,22 +1935,22 @@ static void preparedisplay(void)
  */
 static int initgame(gamelogic *logic)
 {
-    creature		crtemp;
-    creature	       *cr;
     mapcell	       *cell;
     xyconn	       *xy;
-    int			pos, num, n;
+    int			cr, pos, num, n;
 
     setstate(logic);
     num = state->game->number;
-    creaturelist() = creaturearray + 1;
-    cr = creaturelist();
+    creaturelist() = creaturearray;
+    cr = 0;
 
     if (pedanticmode)
 	if (state->statusflags & SF_BADTILES)
 	    markinvalid();
 
     n = -1;
+    teleportlistsize() = 0;
+    memset(switchwalls(), 0, sizeof switchwalls());
     for (pos = 0, cell = state->map ; pos < CXGRID * CYGRID ; ++pos, ++cell) {
 	if (cell->top.id == Block_Static)
 	    cell->top.id = crtile(Block, NORTH);
@@ -1807,30 +1975,30 @@ static int initgame(gamelogic *logic)
 	}
 
 	if (iscreature(cell->top.id)) {
-	    cr->pos = pos;
-	    cr->id = creatureid(cell->top.id);
-	    cr->dir = creaturedirid(cell->top.id);
+	    crpos(cr) = pos;
+	    crid(cr) = creatureid(cell->top.id);
+	    crdir(cr) = creaturedirid(cell->top.id);
 	    if (pedanticmode) {
-	        if (cr->id == Block && isice(cell->bot.id))
-		    cr->dir = NIL;
+	        if (crid(cr) == Block && isice(cell->bot.id))
+		    crdir(cr) = NIL;
 	    }
-	    cr->moving = 0;
-	    cr->hidden = FALSE;
-	    if (cr->id == Chip) {
+	    crmoving(cr) = 0;
+	    crhidden(cr) = FALSE;
+	    if (crid(cr) == Chip) {
 		if (n >= 0) {
 		    warn("level %d: multiple Chips on the map!", num);
 		    markinvalid();
 		}
-		n = cr - creaturelist();
-		cr->dir = SOUTH;
-		cr->state = 0;
+		n = cr;
+		crdir(cr) = SOUTH;
+		crstate(cr) = 0;
 	    } else {
-		cr->state = 0;
+		crstate(cr) = 0;
 		claimlocation(pos);
 	    }
 	    setfdir(cr, NIL);
-	    cr->tdir = NIL;
-	    cr->frame = 0;
+	    crtdir(cr) = NIL;
+	    crframe(cr) = 0;
 	    ++cr;
 	    cell->top.id = cell->bot.id;
 	    cell->bot.id = Empty;
@@ -1840,27 +2008,34 @@ static int initgame(gamelogic *logic)
 		markinvalid();
 	if (cell->top.id == Beartrap)
 	   markbeartrap(pos);
-	if (cell->top.id == Teleport)
+	if (cell->top.id == Teleport) {
 	   markteleport(pos);
+	   teleportlist()[teleportlistsize()++] = pos;
+	}
+	if (cell->top.id == SwitchWall_Open
+				|| cell->top.id == SwitchWall_Closed)
+	    setplanebit(switchwalls(), pos);
     }
 
     if (n < 0) {
 	warn("level %d: Chip isn't on the map!", num);
 	markinvalid();
-	n = cr - creaturelist();
-	cr->pos = 0;
-	cr->hidden = TRUE;
+	n = cr;
+	crpos(cr) = 0;
+	crhidden(cr) = TRUE;
 	++cr;
     }
-    cr->pos = -1;
-    cr->id = Nothing;
-    cr->dir = NIL;
+    crpos(cr) = -1;
+    crid(cr) = Nothing;
+    crdir(cr) = NIL;
     creaturelistend() = cr - 1;
     if (n) {
-	cr = creaturelist();
-	crtemp = cr[0];
-	cr[0] = cr[n];
-	cr[n] = crtemp;
+	copycreature(cr, 0);
+	copycreature(0, n);
+	copycreature(n, cr);
+	crpos(cr) = -1;
+	crid(cr) = Nothing;
+	crdir(cr) = NIL;
     }
 
     for (xy = traplist(), n = traplistsize() ; n ; --n, ++xy) {
@@ -1889,6 +2064,9 @@ static int initgame(gamelogic *logic)
 	    xy->from = -1;
 	}
     }
+    buildwiring(state);
+    if (pedanticmode)
+	buildmaporderwiring();
 
     possession(Key_Red) = possession(Key_Blue)
 			= possession(Key_Yellow)
@@ -1905,7 +2083,7 @@ static int initgame(gamelogic *logic)
     mapbreached() = FALSE;
     completed() = FALSE;
     chiptopos() = -1;
-    chiptocr() = NULL;
+    chiptocr() = NOCREATURE;
     putwall() = -1;
     prngvalue1() = 0;
     prngvalue2() = 0;
@@ -1923,64 +2101,64 @@ static int initgame(gamelogic *logic)
  */
 static int advancegame(gamelogic *logic)
 {
-    creature   *cr;
+    int		cr;
 
     setstate(logic);
 
     initialhousekeeping();
 
-    for (cr = creaturelistend() ; cr >= creaturelist() ; --cr) {
+    for (cr = creaturelistend() ; cr >= 0 ; --cr) {
 	setfdir(cr, NIL);
-	cr->tdir = NIL;
-	if (cr != getchip() && cr->hidden)
+	crtdir(cr) = NIL;
+	if (cr != getchip() && crhidden(cr))
 	    continue;
-	if (isanimation(cr->id)) {
-	    --cr->frame;
-	    if (cr->frame < 0)
+	if (isanimation(crid(cr))) {
+	    --crframe(cr);
+	    if (crframe(cr) < 0)
 		removeanimation(cr);
 	    continue;
 	}
 	if (cr == getchip() && inendgame())
 	    continue;
-	if (cr->moving <= 0)
+	if (crmoving(cr) <= 0)
 	    choosemove(cr);
     }
 
     cr = getchip();
-    if (getfdir(cr) == NIL && cr->tdir == NIL)
+    if (getfdir(cr) == NIL && crtdir(cr) == NIL)
 	couldntmove() = FALSE;
     else
 	checkmovingto();
 
-    for (cr = creaturelistend() ; cr >= creaturelist() ; --cr) {
+    for (cr = creaturelistend() ; cr >= 0 ; --cr) {
     	if (cr == getchip() && completed())
 	    continue;
-	if (cr != getchip() && cr->hidden)
+	if (cr != getchip() && crhidden(cr))
 	    continue;
 	if (advancecreature(cr, FALSE) < 0)
 	    continue;
-	cr->tdir = NIL;
+	crtdir(cr) = NIL;
 	setfdir(cr, NIL);
-	if (pedanticmode && floorat(cr->pos) == PopupWall) {
+	if (pedanticmode && floorat(crpos(cr)) == PopupWall) {
 	    if (cr != getchip())
 	        putwall() = chippos();
 	}
-	if (floorat(cr->pos) == Button_Brown && cr->moving <= 0)
-	    springtrap(trapfrombutton(cr->pos));
+	if (floorat(crpos(cr)) == Button_Brown && crmoving(cr) <= 0)
+	    springtrap(trapfrombutton(crpos(cr)));
     }
 
-    for (cr = creaturelistend() ; cr >= creaturelist() ; --cr) {
-	if (cr->hidden)
+    for (cr = creaturelistend() ; cr >= 0 ; --cr) {
+	if (crhidden(cr))
 	    continue;
-	if (cr->moving)
+	if (crmoving(cr))
 	    continue;
-	if (floorat(cr->pos) == Teleport)
+	if (floorat(crpos(cr)) == Teleport)
 	    teleportcreature(cr);
     }
 
     if (putwall() != -1)
     {
-	if (!getchip()->hidden) {
+	if (!crhidden(getchip())) {
 	    if (floorat(chippos()) == Beartrap)
 	        springtrap(chippos());
 	    floorat(putwall()) = Wall;
@@ -2020,6 +2198,67 @@ static void shutdown(gamelogic *logic)
     creaturearray = NULL;
 }
 
+/* A copy of the game state that this module keeps to itself.
+ */
+typedef	struct lxsavedstate {
+    stateregion		creatures;	/* the creature list */
+    int			lastrndslidedir; /* the random slide direction */
+} lxsavedstate;
+
+/* Copy the creature list, up to and including the entry that ends it.
+ * When the fields are kept in separate arrays, the arrays are copied
+ * instead, and the list of structs is left to be rebuilt from them.
+ */
+static void *savestate(gamelogic *logic, void const *base)
+{
+    lxsavedstate const *prev = base;
+    lxsavedstate       *saved;
+#ifndef LYNX_CREATURE_SOA
+    int			n;
+#endif
+
+    (void)logic;
+    saved = malloc(sizeof *saved);
+    if (!saved)
+	memerrexit();
+#ifdef LYNX_CREATURE_SOA
+    savestateregion(&saved->creatures, &crfields, sizeof crfields,
+		    prev ? &prev->creatures : NULL);
+#else
+    for (n = 0 ; n < MAX_CREATURES && creaturearray[n].id ; ++n) ;
+    savestateregion(&saved->creatures, creaturearray,
+		    (n + 1) * sizeof *creaturearray,
+		    prev ? &prev->creatures : NULL);
+#endif
+    saved->lastrndslidedir = lastrndslidedir;
+    return saved;
+}
+
+/* Put the creature list back as it was copied.
+ */
+static void restorestate(gamelogic *logic, void const *data)
+{
+    lxsavedstate const *saved = data;
+
+    (void)logic;
+#ifdef LYNX_CREATURE_SOA
+    restorestateregion(&saved->creatures, &crfields);
+#else
+    restorestateregion(&saved->creatures, creaturearray);
+#endif
+    lastrndslidedir = saved->lastrndslidedir;
+}
+
+/* Discard a copy of the module's game state.
+ */
+static void freestate(void *data)
+{
+    lxsavedstate       *saved = data;
+
+    freestateregion(&saved->creatures);
+    free(saved);
+}
+
 /* The exported function: Initialize and return the module's gamelogic
  * structure.
  */
@@ -2038,6 +2277,14 @@ gamelogic *lynxlogicstartup(void)
     logic.advancegame = advancegame;
     logic.endgame = endgame;
     logic.shutdown = shutdown;
+    logic.savestate = savestate;
+    logic.restorestate = restorestate;
+    logic.freestate = freestate;
+#ifdef LYNX_CREATURE_SOA
+    logic.updateview = updateview;
+#else
+    logic.updateview = NULL;
+#endif
 
     return &logic;
 }
@@ -9,7 +9,9 @@
 #include	"defs.h"
 #include	"err.h"
 #include	"state.h"
+#include	"encoding.h"
 #include	"random.h"
+#include	"snapshot.h"
 #include	"logic.h"
 
 #ifdef NDEBUG
@@ -36,6 +38,11 @@ static int advancecreature(creature *cr, int dir);
  */
 static int		laststepping = 0;
 
+/* Mouse navigation flag. (As with pedanticmode, this module is the
+ * only one that uses it.)
+ */
+int			mousenavigation = FALSE;
+
 /* A pointer to the game state, used so that it doesn't have to be
  * passed to every single function.
  */
@@ -58,6 +65,11 @@ static gamestate       *state;
 #define	clonerlistsize()	(state->clonercount)
 #define	traplist()		(state->traps)
 #define	traplistsize()		(state->trapcount)
+#define	teleportlist()		(state->teleports)
+#define	teleportlistsize()	(state->teleportcount)
+#define	wiringat(pos)		(state->wiring[pos])
+#define	trapwirenext(i)		(state->trapwirenext[i])
+#define	switchwalls()		(state->switchwalls)
 
 #define	timelimit()		(state->timelimit)
 #define	timeoffset()		(state->timeoffset)
@@ -88,11 +100,14 @@ static gamestate       *state;
 #define	lastslipdir()		(getmsstate().lastslipdir)
 #define	xviewoffset()		(getmsstate().xviewoffset)
 #define	yviewoffset()		(getmsstate().yviewoffset)
+#define	buttonsdown()		(getmsstate().buttonsdown)
 
 #define	goalpos()		(getmsstate().goalpos)
 #define	hasgoal()		(goalpos() >= 0)
 #define	cancelgoal()		(goalpos() = -1)
 
+#define	navigating()		(mousenavigation && state->replay < 0)
+
 #define	possession(obj)	(*_possession(obj))
 static short *_possession(int obj)
 {
@@ -146,13 +161,19 @@ struct crpoollump {
     creature	lump[crpoollumpsize];	/* the lump proper */
 };
 
-/* The data associated with a sliding object.
+/* The data associated with a sliding object. The creature is NULL
+ * once the entry has been removed from the list.
  */
 typedef	struct slipper {
     creature   *cr;
     int		dir;
 } slipper;
 
+/* The number of free entries left at the start of the slip list when
+ * it is compacted, so that Chip can be added at the front.
+ */
+#define	SLIPSLACK	16
+
 /* The linked list of creature pools, forming the creature arena.
  */
 static crpoollump      *currentcrpoollump = NULL;
@@ -169,11 +190,24 @@ static creature	      **blocks = NULL;
 static int		blockcount = 0;
 static int		blocksallocated = 0;
 
-/* The list of sliding creatures.
+/* The list of sliding creatures. The list occupies the entries from
+ * slipfirst up to slipend, and slipcount is the number of entries in
+ * that range that are still in use. Each creature on the list holds
+ * the index of its entry, so removed entries are left in place until
+ * the list is compacted, keeping the order of the remaining entries.
+ * slipcursor is the index of the entry last looked up by position,
+ * and slipcursorpos is the number of entries in use before it.
+ * slipduplicates is the number of entries for creatures that were
+ * already on the list.
  */
 static slipper	       *slips = NULL;
+static int		slipfirst = 0;
+static int		slipend = 0;
 static int		slipcount = 0;
 static int		slipsallocated = 0;
+static int		slipcursor = 0;
+static int		slipcursorpos = 0;
+static int		slipduplicates = 0;
 
 /* Mark all entries in the creature arena as unused.
  */
@@ -232,6 +266,7 @@ static creature *allocatecreature(void)
     cr->frame = 0;
     cr->hidden = FALSE;
     cr->moving = 0;
+    cr->slip = -1;
     return cr;
 }
 
@@ -281,30 +316,69 @@ static creature *addtoblocklist(creature *cr)
  */
 static void resetsliplist(void)
 {
+    slipfirst = 0;
+    slipend = 0;
     slipcount = 0;
+    slipcursor = 0;
+    slipcursorpos = 0;
+    slipduplicates = 0;
 }
 
-/* Append the given creature to the end of the slip list.
+/* Move the entries in use on the slip list to the start of the
+ * array, leaving the given number of free entries before them, and
+ * at least one free entry after them.
  */
-static creature *appendtosliplist(creature *cr, int dir)
+static void compactsliplist(int front)
 {
-    int	n;
-
-    for (n = 0 ; n < slipcount ; ++n) {
-	if (slips[n].cr == cr) {
-	    slips[n].dir = dir;
-	    return cr;
-	}
-    }
+    int	cursor = -1;
+    int	i, j;
 
-    if (slipcount >= slipsallocated) {
+    if (front + slipcount >= slipsallocated) {
 	slipsallocated = slipsallocated ? slipsallocated * 2 : 16;
+	while (front + slipcount >= slipsallocated)
+	    slipsallocated *= 2;
 	slips = realloc(slips, slipsallocated * sizeof *slips);
 	if (!slips)
 	    memerrexit();
     }
-    slips[slipcount].cr = cr;
-    slips[slipcount].dir = dir;
+    for (i = slipfirst, j = 0 ; i < slipend ; ++i) {
+	if (!slips[i].cr)
+	    continue;
+	if (cursor < 0 && i >= slipcursor)
+	    cursor = j;
+	slips[j] = slips[i];
+	if (slips[j].cr->slip == i)
+	    slips[j].cr->slip = j;
+	++j;
+    }
+    slipcursor = (cursor < 0 ? j : cursor) + front;
+    if (front) {
+	memmove(slips + front, slips, j * sizeof *slips);
+	for (i = front + j - 1 ; i >= front ; --i)
+	    if (slips[i].cr->slip == i - front)
+		slips[i].cr->slip = i;
+    }
+    slipfirst = front;
+    slipend = front + j;
+}
+
+/* Append the given creature to the end of the slip list.
+ */
+static creature *appendtosliplist(creature *cr, int dir)
+{
+    if (cr->slip >= 0) {
+	slips[cr->slip].dir = dir;
+	return cr;
+    }
+
+    if (slipend >= slipsallocated)
+	compactsliplist(slipfirst ? SLIPSLACK : 0);
+    if (slipend < slipcursor)
+	++slipcursorpos;
+    slips[slipend].cr = cr;
+    slips[slipend].dir = dir;
+    cr->slip = slipend;
+    ++slipend;
     ++slipcount;
     return cr;
 }
@@ -313,24 +387,22 @@ static creature *appendtosliplist(creature *cr, int dir)
  */
 static creature *prependtosliplist(creature *cr, int dir)
 {
-    int	n;
-
-    if (slipcount && slips[0].cr == cr) {
-	slips[0].dir = dir;
+    if (cr->slip >= 0 && cr->slip == slipfirst) {
+	slips[slipfirst].dir = dir;
 	return cr;
     }
 
-    if (slipcount >= slipsallocated) {
-	slipsallocated = slipsallocated ? slipsallocated * 2 : 16;
-	slips = realloc(slips, slipsallocated * sizeof *slips);
-	if (!slips)
-	    memerrexit();
-    }
-    for (n = slipcount ; n ; --n)
-	slips[n] = slips[n - 1];
+    if (slipfirst == 0)
+	compactsliplist(SLIPSLACK);
+    --slipfirst;
+    if (slipfirst < slipcursor)
+	++slipcursorpos;
+    if (cr->slip >= 0)
+	++slipduplicates;
+    slips[slipfirst].cr = cr;
+    slips[slipfirst].dir = dir;
+    cr->slip = slipfirst;
     ++slipcount;
-    slips[0].cr = cr;
-    slips[0].dir = dir;
     return cr;
 }
 
@@ -338,28 +410,58 @@ static creature *prependtosliplist(creature *cr, int dir)
  */
 static int getslipdir(creature *cr)
 {
-    int	n;
-
-    for (n = 0 ; n < slipcount ; ++n)
-	if (slips[n].cr == cr)
-	    return slips[n].dir;
-    return NIL;
+    return cr->slip >= 0 ? slips[cr->slip].dir : NIL;
 }
 
-/* Remove the given creature from the slip list.
+/* Remove the given creature from the slip list. If the creature has
+ * more than one entry, only the first one is removed.
  */
 static void removefromsliplist(creature *cr)
 {
     int	n;
 
-    for (n = 0 ; n < slipcount ; ++n)
-	if (slips[n].cr == cr)
-	    break;
-    if (n == slipcount)
+    n = cr->slip;
+    if (n < 0)
 	return;
+    slips[n].cr = NULL;
+    cr->slip = -1;
     --slipcount;
-    for ( ; n < slipcount ; ++n)
-	slips[n] = slips[n + 1];
+    if (n < slipcursor)
+	--slipcursorpos;
+    if (slipduplicates) {
+	for (++n ; n < slipend ; ++n) {
+	    if (slips[n].cr == cr) {
+		cr->slip = n;
+		--slipduplicates;
+		break;
+	    }
+	}
+    }
+    while (slipfirst < slipend && !slips[slipfirst].cr)
+	++slipfirst;
+    while (slipend > slipfirst && !slips[slipend - 1].cr)
+	--slipend;
+}
+
+/* Return the index of the entry at the given position in the slip
+ * list, counting only the entries in use. The search starts from the
+ * last position looked up, so stepping through the list one position
+ * at a time costs no more than walking the array.
+ */
+static int getslipentry(int pos)
+{
+    while (slipcursorpos > pos) {
+	--slipcursor;
+	if (slips[slipcursor].cr)
+	    --slipcursorpos;
+    }
+    while (slipcursor < slipend
+		&& (slipcursorpos < pos || !slips[slipcursor].cr)) {
+	if (slips[slipcursor].cr)
+	    ++slipcursorpos;
+	++slipcursor;
+    }
+    return slipcursor;
 }
 
 /*
@@ -372,7 +474,6 @@ static void removefromsliplist(creature *cr)
 #define	FS_CLONING		0x02	/* clone machine is activated */
 #define	FS_BROKEN		0x04	/* teleport/toggle wall doesn't work */
 #define	FS_HASMUTANT		0x08	/* beartrap contains mutant block */
-#define	FS_MARKER		0x10	/* marker used during initialization */
 
 /* Translate a slide floor into the direction it points in. In the
  * case of a random slide floor, a new direction is selected.
@@ -406,13 +507,16 @@ static int icewallturn(int floor, int dir)
     return dir;
 }
 
-/* Find the location of a bear trap from one of its buttons.
+/* Find the location of a bear trap from one of its buttons. Only a
+ * button wired from off the map needs the list to be searched.
  */
 static int trapfrombutton(int pos)
 {
     xyconn     *traps;
     int		i;
 
+    if (pos >= 0 && pos < CXGRID * CYGRID)
+	return wiringat(pos).trap;
     traps = traplist();
     for (i = traplistsize() ; i ; ++traps, --i)
 	if (traps->from == pos)
@@ -424,14 +528,7 @@ static int trapfrombutton(int pos)
  */
 static int clonerfrombutton(int pos)
 {
-    xyconn     *cloners;
-    int		i;
-
-    cloners = clonerlist();
-    for (i = clonerlistsize() ; i ; ++cloners, --i)
-	if (cloners->from == pos)
-	    return cloners->to;
-    return -1;
+    return wiringat(pos).cloner;
 }
 
 /* Return the floor tile found at the given location.
@@ -508,25 +605,65 @@ static maptile poptile(int pos)
  */
 static int istrapopen(int pos, int skippos)
 {
-    xyconn     *traps;
+    xyconn     *xy;
     int		i;
 
-    traps = traplist();
-    for (i = traplistsize() ; i ; ++traps, --i)
-	if (traps->to == pos && traps->from != skippos
-			     && istrapbuttondown(traps->from))
+    for (i = wiringat(pos).trapwire ; i >= 0 ; i = trapwirenext(i)) {
+	xy = traplist() + i;
+	if (xy->from != skippos && istrapbuttondown(xy->from))
 	    return TRUE;
+    }
     return FALSE;
 }
 
-/* Flip-flop the state of any toggle walls.
+/* Return the index of the lowest bit that is set in a nonzero word.
+ */
+static int lowestbit(unsigned long bits)
+{
+#ifdef __GNUC__
+    return __builtin_ctzl(bits);
+#else
+    int	n = 0;
+
+    for ( ; !(bits & 0xFF) ; bits >>= 8)
+	n += 8;
+    for ( ; !(bits & 1) ; bits >>= 1)
+	++n;
+    return n;
+#endif
+}
+
+/* Return the first location at or after pos that is set in the
+ * bitplane, or -1 if there is none. Words with no bits set are
+ * skipped whole.
+ */
+static int nextplanebit(unsigned long const *plane, int pos)
+{
+    unsigned long	bits;
+    int			y;
+
+    if (pos >= CXGRID * CYGRID)
+	return -1;
+    y = pos / CXGRID;
+    bits = plane[y] & (~0UL << (pos % CXGRID));
+    while (!bits) {
+	if (++y >= CYGRID)
+	    return -1;
+	bits = plane[y];
+    }
+    return y * CXGRID + lowestbit(bits);
+}
+
+/* Flip-flop the state of any toggle walls. Toggle walls never move,
+ * so only the locations that had one at the start need be checked.
  */
 static void togglewalls(void)
 {
     mapcell    *cell;
     int		pos;
 
-    for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
+    for (pos = nextplanebit(switchwalls(), 0) ; pos >= 0 ;
+	 pos = nextplanebit(switchwalls(), pos + 1)) {
 	cell = cellat(pos);
 	if ((cell->top.id == SwitchWall_Open
 				|| cell->top.id == SwitchWall_Closed)
@@ -755,9 +892,11 @@ static void updatesliplist()
 {
     int	n;
 
-    for (n = slipcount - 1 ; n >= 0 ; --n)
-	if (!(slips[n].cr->state & (CS_SLIP | CS_SLIDE)))
+    for (n = slipend - 1 ; n >= slipfirst ; --n)
+	if (slips[n].cr && !(slips[n].cr->state & (CS_SLIP | CS_SLIDE)))
 	    endfloormovement(slips[n].cr);
+    if (slipend - slipfirst - slipcount > slipcount + SLIPSLACK)
+	compactsliplist(SLIPSLACK);
 }
 
 /*
@@ -1167,6 +1306,185 @@ static void choosecreaturemove(creature *cr)
     cr->tdir = pdir;
 }
 
+/* The distance field used to steer Chip when mouse navigation is
+ * turned on. The low four bits of each entry in links are the
+ * directions in which Chip can leave that cell, and the high four bits
+ * are the directions in which Chip can enter it. dist holds the number
+ * of steps from each cell to the goal, or -1 if there is no path.
+ * cellkeys remembers the floor and top tile that each cell's links
+ * were worked out from, and inventory the items that they depend on,
+ * so that only the links of cells that have changed are recomputed.
+ * The distances are only recomputed when the goal or the links change.
+ */
+static struct {
+    short		goal;
+    short		inventory;
+    unsigned short	cellkeys[CXGRID * CYGRID];
+    unsigned char	links[CXGRID * CYGRID];
+    short		dist[CXGRID * CYGRID];
+} navfield;
+
+/* Return the position next to pos in the given direction, or -1 if
+ * that would be off the map.
+ */
+static int neighbor(int pos, int dir)
+{
+    int	x, y;
+
+    y = pos / CXGRID + (dir == NORTH ? -1 : dir == SOUTH ? +1 : 0);
+    x = pos % CXGRID + (dir == WEST ? -1 : dir == EAST ? +1 : 0);
+    if (y < 0 || y >= CYGRID || x < 0 || x >= CXGRID)
+	return -1;
+    return y * CXGRID + x;
+}
+
+/* Work out which ways Chip can move into and out of a cell, without
+ * any of the side effects of canmakemove(). Cells that would kill or
+ * trap Chip are avoided unless they are the goal itself, and blocks
+ * and hidden walls are treated as walls. Other creatures are ignored,
+ * since they will have moved on by the time Chip gets there.
+ */
+static int navlinks(int pos)
+{
+    int	floor, in, out, id;
+
+    floor = floorat(pos);
+    switch (floor) {
+      case Wall_North:		out = NWSE & ~NORTH;		break;
+      case Wall_West:		out = NWSE & ~WEST;		break;
+      case Wall_South:		out = NWSE & ~SOUTH;		break;
+      case Wall_East:		out = NWSE & ~EAST;		break;
+      case Wall_Southeast:	out = NWSE & ~(SOUTH | EAST);	break;
+      default:			out = NWSE;			break;
+    }
+
+    in = movelaws[floor].chip;
+    if ((floor == Socket && chipsneeded() > 0)
+		|| (isdoor(floor) && !possession(floor))
+		|| floor == Block_Static || floor == HiddenWall_Temp
+		|| floor == BlueWall_Real)
+	in = 0;
+    if (pos != goalpos()
+		&& ((floor == Fire && !possession(Boots_Fire))
+			|| (floor == Water && !possession(Boots_Water))
+			|| floor == Bomb || floor == Beartrap))
+	in = 0;
+    id = cellat(pos)->top.id;
+    if (iscreature(id) && creatureid(id) == Block)
+	in = 0;
+
+    return (in << 4) | out;
+}
+
+/* Return a value that changes whenever Chip gains or loses something
+ * that navlinks() takes into account.
+ */
+static int navinventory(void)
+{
+    int	inventory = 0, n;
+
+    for (n = 0 ; n < 4 ; ++n)
+	if (state->keys[n])
+	    inventory |= 1 << n;
+    if (possession(Boots_Fire))
+	inventory |= 0x10;
+    if (possession(Boots_Water))
+	inventory |= 0x20;
+    if (chipsneeded() > 0)
+	inventory |= 0x40;
+    return inventory;
+}
+
+/* Bring the distance field up to date with the current map and goal.
+ * Only the cells whose floor or top tile has changed get their links
+ * recomputed, unless the goal or Chip's inventory has changed, in
+ * which case every cell does. The search is then run again only if a
+ * link or the goal is different.
+ */
+static void updatenavfield(void)
+{
+    static short	queue[CXGRID * CYGRID];
+    int			head, tail, pos, from, dir, key, links, all;
+    int			changed = FALSE;
+
+    all = navfield.goal != goalpos() || navfield.inventory != navinventory();
+    if (all) {
+	navfield.goal = goalpos();
+	navfield.inventory = navinventory();
+	changed = TRUE;
+    }
+    for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
+	key = (floorat(pos) << 8) | cellat(pos)->top.id;
+	if (!all && navfield.cellkeys[pos] == key)
+	    continue;
+	navfield.cellkeys[pos] = key;
+	links = navlinks(pos);
+	if (navfield.links[pos] != links) {
+	    navfield.links[pos] = links;
+	    changed = TRUE;
+	}
+    }
+    if (!changed)
+	return;
+
+    for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos)
+	navfield.dist[pos] = -1;
+    navfield.dist[goalpos()] = 0;
+    queue[0] = goalpos();
+    for (head = 0, tail = 1 ; head < tail ; ++head) {
+	pos = queue[head];
+	for (dir = NORTH ; dir <= EAST ; dir <<= 1) {
+	    if (!((navfield.links[pos] >> 4) & dir))
+		continue;
+	    from = neighbor(pos, back(dir));
+	    if (from < 0 || navfield.dist[from] >= 0
+			 || !(navfield.links[from] & dir))
+		continue;
+	    navfield.dist[from] = navfield.dist[pos] + 1;
+	    queue[tail++] = from;
+	}
+    }
+}
+
+/* Return TRUE if the distance field allows Chip to step from pos in
+ * the given direction.
+ */
+static int navcanstep(int pos, int dir)
+{
+    int	to;
+
+    to = neighbor(pos, dir);
+    return to >= 0 && (navfield.links[pos] & dir)
+		   && ((navfield.links[to] >> 4) & dir);
+}
+
+/* Select a direction for Chip to move along a shortest path to the
+ * goal position. Among equally short paths, the preferred directions
+ * d1 and d2 are tried first. If there is no path at all, the choice
+ * falls back to the preferred directions.
+ */
+static int chipnavigate(creature const *cr, int d1, int d2)
+{
+    int	dirs[6] = { d1, d2, NORTH, WEST, SOUTH, EAST };
+    int	to, n;
+
+    if (goalpos() < CXGRID * CYGRID) {
+	updatenavfield();
+	if (navfield.dist[cr->pos] > 0) {
+	    for (n = 0 ; n < 6 ; ++n) {
+		if (dirs[n] == NIL || !navcanstep(cr->pos, dirs[n]))
+		    continue;
+		to = neighbor(cr->pos, dirs[n]);
+		if (navfield.dist[to] == navfield.dist[cr->pos] - 1)
+		    return dirs[n];
+	    }
+	}
+    }
+    if (d1 != NIL && d2 != NIL)
+	return navcanstep(cr->pos, d1) ? d1 : d2;
+    return d2 == NIL ? d1 : d2;
+}
+
 /* Select a direction for Chip to move towards the goal position.
  */
 static int chipmovetogoalpos(void)
@@ -1196,7 +1514,9 @@ static int chipmovetogoalpos(void)
 	d1 = d2;
 	d2 = dir;
     }
-    if (d1 != NIL && d2 != NIL)
+    if (navigating())
+	dir = chipnavigate(cr, d1, d2);
+    else if (d1 != NIL && d2 != NIL)
 	dir = canmakemove(cr, d1, 0) ? d1 : d2;
     else
 	dir = d2 == NIL ? d1 : d2;
@@ -1246,7 +1566,8 @@ static void choosechipmove(creature *cr, int discard)
     if (cr->state & CS_HASMOVED) {
 	if (currentinput() != NIL && hasgoal()) {
 	    cancelgoal();
-	    lastmove() = CmdMoveNop;
+	    if (!navigating())
+		lastmove() = CmdMoveNop;
 	}
 	return;
     }
@@ -1261,10 +1582,11 @@ static void choosechipmove(creature *cr, int discard)
 
     if (dir >= CmdAbsMouseMoveFirst && dir <= CmdAbsMouseMoveLast) {
 	goalpos() = dir - CmdAbsMouseMoveFirst;
-	lastmove() = CmdMouseMoveFirst + makemouserelative(goalpos());
+	lastmove() = navigating() ? NIL
+			: CmdMouseMoveFirst + makemouserelative(goalpos());
 	dir = NIL;
     } else if (dir >= CmdMouseMoveFirst && dir <= CmdMouseMoveLast) {
-	lastmove() = dir;
+	lastmove() = navigating() ? NIL : dir;
 	goalpos() = makemouseabsolute(dir - CmdMouseMoveFirst);
 	dir = NIL;
     } else {
@@ -1273,19 +1595,47 @@ static void choosechipmove(creature *cr, int discard)
 	lastmove() = dir;
     }
 
-    if (dir == NIL && hasgoal() && (currenttime() & 3) == 2)
+    if (dir == NIL && hasgoal() && (currenttime() & 3) == 2) {
 	dir = chipmovetogoalpos();
+	if (navigating()) {
+	    if ((cr->state & CS_SLIDE) && dir == cr->dir)
+		dir = NIL;
+	    lastmove() = dir;
+	}
+    }
 
     cr->tdir = dir;
 }
 
+/* Return the index of the first entry in the teleport list at or
+ * after the given location.
+ */
+static int findteleport(int pos)
+{
+    int	lo, hi, mid;
+
+    lo = 0;
+    hi = teleportlistsize();
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (teleportlist()[mid] < pos)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
 /* Teleport the given creature instantaneously from the teleport tile
- * at start to another teleport tile (if possible).
+ * at start to another teleport tile (if possible). The teleports are
+ * tried in reverse reading order, starting with the one before start.
+ * Only the cells on the teleport list are visited, since no other
+ * cell can ever hold a teleport.
  */
 static int teleportcreature(creature *cr, int start)
 {
     maptile    *tile;
-    int		dest, origpos, f;
+    int		dest, origpos, f, i, n;
 
     _assert(!cr->hidden);
     if (cr->dir == NIL) {
@@ -1295,12 +1645,11 @@ static int teleportcreature(creature *cr, int start)
     }
 
     origpos = cr->pos;
-    dest = start;
+    i = findteleport(start);
 
-    for (;;) {
-	--dest;
-	if (dest < 0)
-	    dest += CXGRID * CYGRID;
+    for (n = teleportlistsize() ; n ; --n) {
+	i = (i ? i : teleportlistsize()) - 1;
+	dest = teleportlist()[i];
 	if (dest == start)
 	    break;
 	tile = &cellat(dest)->top;
@@ -1313,10 +1662,10 @@ static int teleportcreature(creature *cr, int start)
 						      | CMM_TELEPORTPUSH);
 	cr->pos = origpos;
 	if (f)
-	    break;
+	    return dest;
     }
 
-    return dest;
+    return start;
 }
 
 /* Determine the move(s) a creature will make on the current tick.
@@ -1396,25 +1745,40 @@ static void springtrap(int buttonpos)
     }
 }
 
-/* Mark all buttons everywhere as having been handled.
+/* Mark a button press at the given location as deferred.
+ */
+static void deferbuttonpress(int pos, maptile *tile)
+{
+    tile->state |= FS_BUTTONDOWN;
+    setplanebit(buttonsdown(), pos);
+}
+
+/* Mark all buttons everywhere as having been handled. Only the
+ * locations in the bitplane of deferred presses can have any.
  */
 static void resetbuttons(void)
 {
     int	pos;
 
-    for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
+    for (pos = nextplanebit(buttonsdown(), 0) ; pos >= 0 ;
+	 pos = nextplanebit(buttonsdown(), pos + 1)) {
 	cellat(pos)->top.state &= ~FS_BUTTONDOWN;
 	cellat(pos)->bot.state &= ~FS_BUTTONDOWN;
     }
+    memset(buttonsdown(), 0, sizeof buttonsdown());
 }
 
-/* Apply the effects of all deferred button presses, if any.
+/* Apply the effects of all deferred button presses, if any. The
+ * bitplane is read afresh at each step, so that presses made while
+ * handling an earlier button are seen just as a scan of the map would
+ * see them.
  */
 static void handlebuttons(void)
 {
     int	pos, id;
 
-    for (pos = 0 ; pos < CXGRID * CYGRID ; ++pos) {
+    for (pos = nextplanebit(buttonsdown(), 0) ; pos >= 0 ;
+	 pos = nextplanebit(buttonsdown(), pos + 1)) {
 	if (cellat(pos)->top.state & FS_BUTTONDOWN) {
 	    cellat(pos)->top.state &= ~FS_BUTTONDOWN;
 	    id = cellat(pos)->top.id;
@@ -1422,8 +1786,12 @@ static void handlebuttons(void)
 	    cellat(pos)->bot.state &= ~FS_BUTTONDOWN;
 	    id = cellat(pos)->bot.id;
 	} else {
+	    clearplanebit(buttonsdown(), pos);
 	    continue;
 	}
+	if (!((cellat(pos)->top.state | cellat(pos)->bot.state)
+							& FS_BUTTONDOWN))
+	    clearplanebit(buttonsdown(), pos);
 	switch (id) {
 	  case Button_Blue:
 	    addsoundeffect(SND_BUTTON_PUSHED);
@@ -1661,27 +2029,27 @@ static void endmovement(creature *cr, int dir)
     switch (floor) {
       case Button_Blue:
 	if (cr->state & CS_DEFERPUSH)
-	    tile->state |= FS_BUTTONDOWN;
+	    deferbuttonpress(newpos, tile);
 	else
 	    turntanks(cr);
 	addsoundeffect(SND_BUTTON_PUSHED);
 	break;
       case Button_Green:
 	if (cr->state & CS_DEFERPUSH)
-	    tile->state |= FS_BUTTONDOWN;
+	    deferbuttonpress(newpos, tile);
 	else
 	    togglewalls();
 	break;
       case Button_Red:
 	if (cr->state & CS_DEFERPUSH)
-	    tile->state |= FS_BUTTONDOWN;
+	    deferbuttonpress(newpos, tile);
 	else
 	    activatecloner(newpos);
 	addsoundeffect(SND_BUTTON_PUSHED);
 	break;
       case Button_Brown:
 	if (cr->state & CS_DEFERPUSH)
-	    tile->state |= FS_BUTTONDOWN;
+	    deferbuttonpress(newpos, tile);
 	else
 	    springtrap(newpos);
 	addsoundeffect(SND_BUTTON_PUSHED);
@@ -1697,12 +2065,8 @@ static void endmovement(creature *cr, int dir)
 	if (istrapopen(newpos, oldpos))
 	    cr->state |= CS_RELEASED;
     } else if (cellat(newpos)->bot.id == Beartrap) {
-	for (i = 0 ; i < traplistsize() ; ++i) {
-	    if (traplist()[i].to == newpos) {
-		cr->state |= CS_RELEASED;
-		break;
-	    }
-	}
+	if (wiringat(newpos).trapwire >= 0)
+	    cr->state |= CS_RELEASED;
     }
 
     if (cr->id == Chip) {
@@ -1794,6 +2158,7 @@ static int checkforending(void)
  */
 static void floormovements(void)
 {
+    slipper    *slip;
     creature   *cr;
     int		floor, slipdir;
     int		savedcount, n, advance;
@@ -1801,12 +2166,13 @@ static void floormovements(void)
     advance = 0;
     for (n = 0 ; n < slipcount ; ) {
 	savedcount = slipcount;
-	cr = slips[n].cr;
-	if (!(slips[n].cr->state & (CS_SLIP | CS_SLIDE))) {
+	slip = slips + getslipentry(n);
+	cr = slip->cr;
+	if (!(cr->state & (CS_SLIP | CS_SLIDE))) {
 	    ++n;
 	    continue;
 	}
-	slipdir = slips[n].dir;
+	slipdir = slip->dir;
 	if (slipdir == NIL) {
 	    ++n;
 	    continue;
@@ -1877,7 +2243,7 @@ static void createclones(void)
 static void dumpmap(void)
 {
     creature   *cr;
-    int		y, x;
+    int		y, x, n;
 
     for (y = 0 ; y < CXGRID * CYGRID ; y += CXGRID) {
 	for (x = 0 ; x < CXGRID ; ++x)
@@ -1894,11 +2260,11 @@ static void dumpmap(void)
 	fprintf(stderr, "%02X%c (%d %d)",
 			cr->id, "-^<?v?\?\?>"[(int)cr->dir],
 			cr->pos % CXGRID, cr->pos / CXGRID);
-	for (x = 0 ; x < slipcount ; ++x) {
-	    if (cr == slips[x].cr) {
-		fprintf(stderr, " [%d]", x + 1);
-		break;
-	    }
+	if (cr->slip >= 0) {
+	    for (x = slipfirst, n = 1 ; x < cr->slip ; ++x)
+		if (slips[x].cr)
+		    ++n;
+	    fprintf(stderr, " [%d]", n);
 	}
 	fprintf(stderr, "%s%s%s%s%s%s%s%s%s",
 			cr->hidden ? " hidden" : "",
@@ -1910,8 +2276,8 @@ static void dumpmap(void)
 			cr->state & CS_SLIDE ? " sliding" : "",
 			cr->state & CS_DEFERPUSH ? " deferred-push" : "",
 			cr->state & CS_MUTANT ? " mutant" : "");
-	if (x < slipcount)
-	    fprintf(stderr, " %c", "-^<?v?\?\?>"[(int)slips[x].dir]);
+	if (cr->slip >= 0)
+	    fprintf(stderr, " %c", "-^<?v?\?\?>"[(int)slips[cr->slip].dir]);
 	fputc('\n', stderr);
     }
     for (y = 0 ; y < blockcount ; ++y) {
@@ -1919,11 +2285,11 @@ static void dumpmap(void)
 	fprintf(stderr, "block %d: (%d %d) %c", y,
 			cr->pos % CXGRID, cr->pos / CXGRID,
 			"-^<?v?\?\?>"[(int)cr->dir]);
-	for (x = 0 ; x < slipcount ; ++x) {
-	    if (cr == slips[x].cr) {
-		fprintf(stderr, " [%d]", x + 1);
-		break;
-	    }
+	if (cr->slip >= 0) {
+	    for (x = slipfirst, n = 1 ; x < cr->slip ; ++x)
+		if (slips[x].cr)
+		    ++n;
+	    fprintf(stderr, " [%d]", n);
 	}
 	fprintf(stderr, "%s%s%s%s%s%s%s%s%s",
 			cr->hidden ? " hidden" : "",
@@ -1935,8 +2301,8 @@ static void dumpmap(void)
 			cr->state & CS_SLIDE ? " sliding" : "",
 			cr->state & CS_DEFERPUSH ? " deferred-push" : "",
 			cr->state & CS_MUTANT ? " mutant" : "");
-	if (x < slipcount)
-	    fprintf(stderr, " %c", "-^<?v?\?\?>"[(int)slips[x].dir]);
+	if (cr->slip >= 0)
+	    fprintf(stderr, " %c", "-^<?v?\?\?>"[(int)slips[cr->slip].dir]);
 	fputc('\n', stderr);
     }
 }
@@ -2068,6 +2434,7 @@ static int initgame(gamelogic *logic)
     xyconn	       *xy;
     creature	       *cr;
     creature	       *chip;
+    bitplane		chips, listed;
     int			pos, num, n;
 
     setstate(logic);
@@ -2075,12 +2442,25 @@ static int initgame(gamelogic *logic)
     state->statusflags &= ~SF_BADTILES;
     state->statusflags |= SF_NOANIMATION;
 
+    teleportlistsize() = 0;
+    memset(switchwalls(), 0, sizeof switchwalls());
+    memset(buttonsdown(), 0, sizeof buttonsdown());
+    memset(chips, 0, sizeof chips);
+    memset(listed, 0, sizeof listed);
     for (pos = 0, cell = state->map ; pos < CXGRID * CYGRID ; ++pos, ++cell) {
 	if (isfloor(cell->top.id) || creatureid(cell->top.id) == Chip
 				  || creatureid(cell->top.id) == Block)
 	    if (cell->bot.id == Teleport || cell->bot.id == SwitchWall_Open
 					 || cell->bot.id == SwitchWall_Closed)
 		cell->bot.state |= FS_BROKEN;
+	if (cell->top.id == Teleport || cell->bot.id == Teleport)
+	    teleportlist()[teleportlistsize()++] = pos;
+	if (cell->top.id == SwitchWall_Open || cell->top.id == SwitchWall_Closed
+			|| cell->bot.id == SwitchWall_Open
+			|| cell->bot.id == SwitchWall_Closed)
+	    setplanebit(switchwalls(), pos);
+	if (iscreature(cell->top.id) && creatureid(cell->top.id) == Chip)
+	    setplanebit(chips, pos);
     }
 
     chip = allocatecreature();
@@ -2113,21 +2493,20 @@ static int initgame(gamelogic *logic)
 		chip->dir = creaturedirid(cell->bot.id);
 	    }
 	}
-	cell->top.state |= FS_MARKER;
+	setplanebit(listed, pos);
     }
-    for (pos = 0, cell = state->map ; pos < CXGRID * CYGRID ; ++pos, ++cell) {
-	if (cell->top.state & FS_MARKER) {
-	    cell->top.state &= ~FS_MARKER;
-	} else if (iscreature(cell->top.id)
-				&& creatureid(cell->top.id) == Chip) {
-	    chip->pos = pos;
-	    chip->dir = creaturedirid(cell->bot.id);
-	}
+    for (n = 0 ; n < CYGRID ; ++n)
+	chips[n] &= ~listed[n];
+    for (pos = nextplanebit(chips, 0) ; pos >= 0 ;
+	 pos = nextplanebit(chips, pos + 1)) {
+	chip->pos = pos;
+	chip->dir = creaturedirid(cellat(pos)->bot.id);
     }
 
     dummycrlist.id = 0;
     state->creatures = &dummycrlist;
     state->initrndslidedir = NORTH;
+    buildwiring(state);
 
     possession(Key_Red) = possession(Key_Blue)
 			= possession(Key_Yellow)
@@ -2149,6 +2528,8 @@ static int initgame(gamelogic *logic)
     lastslipdir() = NIL;
     stepping() = laststepping;
     cancelgoal();
+    navfield.goal = -1;
+    navfield.inventory = -1;
     xviewoffset() = 0;
     yviewoffset() = 0;
 
@@ -2246,12 +2627,152 @@ static void shutdown(gamelogic *logic)
     blocksallocated = 0;
     free(slips);
     slips = NULL;
-    slipcount = 0;
+    resetsliplist();
     slipsallocated = 0;
 
     freecreaturepool();
 }
 
+/* A copy of the game state that this module keeps to itself. The
+ * lists hold pointers into the creature pool, which stays allocated
+ * until shutdown, so the pointers are still good once the pool's
+ * contents have been put back in place.
+ */
+typedef	struct mssavedstate {
+    crpoollump	       *lump;		/* the current lump of the pool */
+    int			lumpfree;	/* its number of unused creatures */
+    int			lumpcount;	/* number of lumps in use */
+    stateregion	       *pool;		/* the contents of each lump */
+    stateregion		creatures;	/* the list of active creatures */
+    stateregion		blocks;		/* the list of "active" blocks */
+    stateregion		slips;		/* the slip list */
+    int			slipfirst;	/* the slip list's bookkeeping */
+    int			slipend;
+    int			slipcount;
+    int			slipcursor;
+    int			slipcursorpos;
+    int			slipduplicates;
+} mssavedstate;
+
+/* Copy the creature pool and the lists. The lumps of the pool are
+ * numbered from the first, so each is compared with the same lump in
+ * the earlier copy. The slip list's cursor can be left past the end
+ * of the list, and steps back over the entries in between, so they
+ * are copied as well.
+ */
+static void *savestate(gamelogic *logic, void const *base)
+{
+    mssavedstate const *prev = base;
+    mssavedstate       *saved;
+    crpoollump	       *lump;
+    int			n;
+
+    (void)logic;
+    saved = malloc(sizeof *saved);
+    if (!saved)
+	memerrexit();
+    saved->lump = currentcrpoollump;
+    saved->lumpfree = currentcrpoollump ? currentcrpoollump->count : 0;
+    saved->lumpcount = 0;
+    for (lump = currentcrpoollump ; lump ; lump = lump->prev)
+	++saved->lumpcount;
+    saved->pool = NULL;
+    if (saved->lumpcount) {
+	saved->pool = malloc(saved->lumpcount * sizeof *saved->pool);
+	if (!saved->pool)
+	    memerrexit();
+    }
+    n = saved->lumpcount;
+    for (lump = currentcrpoollump ; lump ; lump = lump->prev) {
+	--n;
+	savestateregion(saved->pool + n, lump->lump, sizeof lump->lump,
+			prev && n < prev->lumpcount ? prev->pool + n : NULL);
+    }
+
+    savestateregion(&saved->creatures, creatures,
+		    creaturecount * sizeof *creatures,
+		    prev ? &prev->creatures : NULL);
+    savestateregion(&saved->blocks, blocks, blockcount * sizeof *blocks,
+		    prev ? &prev->blocks : NULL);
+    n = slipcursor > slipend ? slipcursor : slipend;
+    savestateregion(&saved->slips, slips, n * sizeof *slips,
+		    prev ? &prev->slips : NULL);
+    saved->slipfirst = slipfirst;
+    saved->slipend = slipend;
+    saved->slipcount = slipcount;
+    saved->slipcursor = slipcursor;
+    saved->slipcursorpos = slipcursorpos;
+    saved->slipduplicates = slipduplicates;
+    return saved;
+}
+
+/* Put the creature pool and the lists back as they were copied. Any
+ * lumps allocated since then are left to be reused.
+ */
+static void restorestate(gamelogic *logic, void const *data)
+{
+    mssavedstate const *saved = data;
+    crpoollump	       *lump;
+    int			n;
+
+    (void)logic;
+    currentcrpoollump = saved->lump;
+    if (currentcrpoollump)
+	currentcrpoollump->count = saved->lumpfree;
+    n = saved->lumpcount;
+    for (lump = currentcrpoollump ; lump ; lump = lump->prev)
+	restorestateregion(saved->pool + --n, lump->lump);
+
+    creaturecount = saved->creatures.size / sizeof *creatures;
+    if (creaturecount > creaturesallocated) {
+	creaturesallocated = creaturecount;
+	creatures = realloc(creatures, creaturesallocated * sizeof *creatures);
+	if (!creatures)
+	    memerrexit();
+    }
+    restorestateregion(&saved->creatures, creatures);
+
+    blockcount = saved->blocks.size / sizeof *blocks;
+    if (blockcount > blocksallocated) {
+	blocksallocated = blockcount;
+	blocks = realloc(blocks, blocksallocated * sizeof *blocks);
+	if (!blocks)
+	    memerrexit();
+    }
+    restorestateregion(&saved->blocks, blocks);
+
+    n = saved->slips.size / sizeof *slips;
+    if (n > slipsallocated) {
+	slipsallocated = n;
+	slips = realloc(slips, slipsallocated * sizeof *slips);
+	if (!slips)
+	    memerrexit();
+    }
+    restorestateregion(&saved->slips, slips);
+    slipfirst = saved->slipfirst;
+    slipend = saved->slipend;
+    slipcount = saved->slipcount;
+    slipcursor = saved->slipcursor;
+    slipcursorpos = saved->slipcursorpos;
+    slipduplicates = saved->slipduplicates;
+}
+
+/* Discard a copy of the module's game state.
+ */
+static void freestate(void *data)
+{
+    mssavedstate       *saved = data;
+    int			n;
+
+    for (n = 0 ; n < saved->lumpcount ; ++n)
+	freestateregion(saved->pool + n);
+    free(saved->pool);
+    freestateregion(&saved->creatures);
+    freestateregion(&saved->blocks);
+    freestateregion(&saved->slips);
+    free(saved);
+}
+
 /* The exported function: Initialize and return the module's gamelogic
  * structure.
  */
@@ -2264,6 +2785,10 @@ gamelogic *mslogicstartup(void)
     logic.advancegame = advancegame;
     logic.endgame = endgame;
     logic.shutdown = shutdown;
+    logic.savestate = savestate;
+    logic.restorestate = restorestate;
+    logic.freestate = freestate;
+    logic.updateview = NULL;
 
     return &logic;
 }
@@ -0,0 +1,208 @@
+/* optimize.c: Shortening stored solutions by local search.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#include	<stdio.h>
+#include	<string.h>
+#include	<time.h>
+#include	"defs.h"
+#include	"play.h"
+#include	"solution.h"
+#include	"optimize.h"
+
+/* The state of the search for a faster solution to one level.
+ */
+typedef	struct search {
+    gamesetup	       *game;		/* the level being solved */
+    int			ruleset;	/* the ruleset in use */
+    solutioninfo	best;		/* the fastest solution found so far */
+    int			besttime;	/* the length of best in ticks */
+    solutioninfo	trial;		/* the variant being tried */
+    clock_t		deadline;	/* when to stop searching */
+} search;
+
+/* Make the trial solution a copy of the best one.
+ */
+static void resettrial(search *s)
+{
+    copymovelist(&s->trial.moves, &s->best.moves);
+    s->trial.rndseed = s->best.rndseed;
+    s->trial.flags = s->best.flags;
+    s->trial.rndslidedir = s->best.rndslidedir;
+    s->trial.stepping = s->best.stepping;
+}
+
+/* Play back the trial solution, and make it the best one if it is
+ * faster. TRUE is returned if it was.
+ */
+static int trysolution(search *s)
+{
+    solutioninfo	temp;
+    int			n;
+
+    n = timesolution(s->game, s->ruleset, &s->trial, s->besttime);
+    if (n < 0)
+	return FALSE;
+    temp = s->best;
+    s->best = s->trial;
+    s->trial = temp;
+    s->besttime = n;
+    return TRUE;
+}
+
+/* Remove count moves from the list, starting at index.
+ */
+static void dropmoves(actlist *list, int index, int count)
+{
+    memmove(list->list + index, list->list + index + count,
+	    (list->count - index - count) * sizeof *list->list);
+    list->count -= count;
+}
+
+/* Make every move from index onwards happen delta ticks earlier.
+ */
+static void shiftmoves(actlist *list, int index, int delta)
+{
+    int	i;
+
+    for (i = index ; i < list->count ; ++i)
+	list->list[i].when -= delta;
+}
+
+/* Try the other initial states that a solution can start from, with
+ * the same moves. TRUE is returned if any of them is faster.
+ */
+static int trystartstates(search *s)
+{
+    static int const	dirs[] = { NORTH, EAST, SOUTH, WEST };
+    int			stepping, steppingcount, dircount, i, j;
+
+    steppingcount = s->ruleset == Ruleset_Lynx ? 8 : 2;
+    dircount = s->ruleset == Ruleset_Lynx ? 4 : 1;
+    for (i = 0 ; i < steppingcount ; ++i) {
+	stepping = s->ruleset == Ruleset_Lynx ? i : i * 4;
+	for (j = 0 ; j < dircount ; ++j) {
+	    if (stepping == s->best.stepping
+			&& (dircount == 1 || dirs[j] == s->best.rndslidedir))
+		continue;
+	    resettrial(s);
+	    s->trial.stepping = stepping;
+	    if (dircount > 1)
+		s->trial.rndslidedir = dirs[j];
+	    if (trysolution(s))
+		return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+/* Try each of the small changes that can be made at the move with the
+ * given index. TRUE is returned if any of them is faster.
+ */
+static int trymove(search *s, int index)
+{
+    action const       *moves = s->best.moves.list;
+    int			idle;
+
+    idle = moves[index].when - (index ? moves[index - 1].when : -1) - 1;
+    if (idle > 0) {
+	resettrial(s);
+	shiftmoves(&s->trial.moves, index, idle);
+	if (trysolution(s))
+	    return TRUE;
+	if (idle > 1) {
+	    resettrial(s);
+	    shiftmoves(&s->trial.moves, index, 1);
+	    if (trysolution(s))
+		return TRUE;
+	}
+    }
+    if (s->best.moves.count > 1) {
+	resettrial(s);
+	dropmoves(&s->trial.moves, index, 1);
+	if (trysolution(s))
+	    return TRUE;
+    }
+    if (index + 1 < s->best.moves.count && s->best.moves.count > 2) {
+	resettrial(s);
+	dropmoves(&s->trial.moves, index, 2);
+	if (trysolution(s))
+	    return TRUE;
+    }
+    return FALSE;
+}
+
+/* Make one pass over the solution, keeping every change that makes it
+ * faster. FALSE is returned if nothing was improved, or if the time
+ * ran out.
+ */
+static int searchpass(search *s)
+{
+    int	improved = FALSE;
+    int	i;
+
+    if (trystartstates(s))
+	improved = TRUE;
+    for (i = 0 ; i < s->best.moves.count ; ++i) {
+	for (;;) {
+	    if (clock() >= s->deadline)
+		return FALSE;
+	    if (i >= s->best.moves.count || !trymove(s, i))
+		break;
+	    improved = TRUE;
+	}
+    }
+    return improved;
+}
+
+/* Search for a faster solution to each level in turn, and save the
+ * ones that are found.
+ */
+int optimizesolutions(gameseries *series, int seconds)
+{
+    search	s;
+    int		shortened = 0, saved = 0;
+    int		starttime, i;
+
+    batchmode = TRUE;
+    memset(&s, 0, sizeof s);
+    s.ruleset = series->ruleset;
+    for (i = 0 ; i < series->count ; ++i) {
+	s.game = series->games + i;
+	if (!hassolution(s.game))
+	    continue;
+	if (!expandsolution(&s.best, s.game) || !s.best.moves.count)
+	    continue;
+	s.besttime = timesolution(s.game, s.ruleset, &s.best,
+				  MAXIMUM_TICK_COUNT);
+	if (s.besttime < 0) {
+	    printf("Level %d: solution is not valid; skipped\n",
+		   s.game->number);
+	    continue;
+	}
+	starttime = s.besttime;
+	s.deadline = clock() + (clock_t)seconds * CLOCKS_PER_SEC;
+	while (searchpass(&s)) ;
+	if (s.besttime >= starttime)
+	    continue;
+
+	s.game->besttime = s.besttime;
+	s.game->sgflags &= ~SGF_REPLACEABLE;
+	if (!contractsolution(&s.best, s.game))
+	    continue;
+	printf("Level %d: %d -> %d ticks\n",
+	       s.game->number, starttime, s.besttime);
+	saved += starttime - s.besttime;
+	++shortened;
+    }
+    destroymovelist(&s.best.moves);
+    destroymovelist(&s.trial.moves);
+
+    printf("Solutions shortened:%5d\n", shortened);
+    printf("Ticks saved:%13d\n", saved);
+    if (shortened && !savesolutions(series))
+	return -1;
+    return shortened;
+}
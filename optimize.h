@@ -0,0 +1,24 @@
+/* optimize.h: Shortening stored solutions by local search.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef	HEADER_optimize_h_
+#define	HEADER_optimize_h_
+
+#include	"defs.h"
+
+/* Try to make every solution in the series faster, spending at most
+ * the given number of seconds of processor time on each level. The
+ * moves of each solution are altered a little at a time, by removing
+ * idle ticks and dropping moves, and by trying the other initial
+ * stepping and random slide directions, and any variant that still
+ * completes the level in fewer ticks is kept. Each shortened solution
+ * is reported on stdout, and the improved solutions are saved. The
+ * return value is the number of solutions that were shortened, or -1
+ * if they could not be saved.
+ */
+extern int optimizesolutions(gameseries *series, int seconds);
+
+#endif
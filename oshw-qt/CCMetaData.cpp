@@ -5,20 +5,73 @@
 #include "CCMetaData.h"
 
 #include <QFile>
-#include <QDomDocument>
-#include <QDomElement>
+#include <QXmlStreamReader>
 
 
 namespace CCX
 {
 
 
+// The state of a single pass through the XML of a .ccx file, or of a
+// part of one. Besides the reader itself, it keeps track of where each
+// token starts, so that the locations of elements can be recorded as
+// byte offsets into the data
+struct Scan
+{
+	QXmlStreamReader xml;
+	const QByteArray& data;
+	bool bUtf8;
+	qint64 nTokenStart;
+	qint64 nChar, nByte;
+
+	Scan(const QByteArray& _data)
+		: xml(_data), data(_data), bUtf8(true), nTokenStart(0), nChar(0), nByte(0)
+	{
+		if (data.startsWith("\xEF\xBB\xBF"))
+			nByte = 3;
+	}
+
+	QXmlStreamReader::TokenType ReadNext()
+	{
+		nTokenStart = xml.characterOffset();
+		return xml.readNext();
+	}
+
+	qint64 ByteOffset(qint64 nTarget);
+};
+
+
+// Translate a character offset, as reported by the reader, into a byte
+// offset. Offsets are always requested in increasing order, so the
+// data is only walked through once
+qint64 Scan::ByteOffset(qint64 nTarget)
+{
+	while (nChar < nTarget && nByte < data.size())
+	{
+		unsigned char c = data[int(nByte)];
+		if (!bUtf8 || c < 0xC0)
+			nByte += 1;
+		else if (c < 0xE0)
+			nByte += 2;
+		else if (c < 0xF0)
+			nByte += 3;
+		else
+		{
+			nByte += 4;
+			++nChar;	// a surrogate pair
+		}
+		++nChar;
+	}
+	return nByte;
+}
+
+
 template <typename T>
-static bool ReadElmAttr(const QDomElement& elm, const QString& sAttr, T (*pf)(const QString&), T& rValue)
+static bool ReadElmAttr(const QXmlStreamAttributes& attrs, const QString& sAttr, T (*pf)(const QString&), T& rValue)
 {
-	if (!elm.hasAttribute(sAttr))
+	if (!attrs.hasAttribute(sAttr))
 		return false;
-	rValue = (*pf)(elm.attribute(sAttr));
+	rValue = (*pf)(attrs.value(sAttr).toString());
 	return true;
 }
 
@@ -65,73 +118,152 @@ static TextFormat ParseFormat(const QString& s)
 }
 
 
-void RulesetCompatibility::ReadXML(const QDomElement& elm)
+void RulesetCompatibility::ReadXML(const QXmlStreamAttributes& attrs)
 {
-	ReadElmAttr(elm, QStringLiteral("ms"),       &ParseCompat, eMS);
-	ReadElmAttr(elm, QStringLiteral("lynx"),     &ParseCompat, eLynx);
-	ReadElmAttr(elm, QStringLiteral("pedantic"), &ParseCompat, ePedantic);
+	ReadElmAttr(attrs, QStringLiteral("ms"),       &ParseCompat, eMS);
+	ReadElmAttr(attrs, QStringLiteral("lynx"),     &ParseCompat, eLynx);
+	ReadElmAttr(attrs, QStringLiteral("pedantic"), &ParseCompat, ePedantic);
 }
 
 
-void PageProperties::ReadXML(const QDomElement& elm)
+void PageProperties::ReadXML(const QXmlStreamAttributes& attrs)
 {
-	ReadElmAttr(elm, QStringLiteral("format"),  &ParseFormat, eFormat);
-	ReadElmAttr(elm, QStringLiteral("align"),   &ParseHAlign, align);
-	ReadElmAttr(elm, QStringLiteral("valign"),  &ParseVAlign, valign);
-	ReadElmAttr(elm, QStringLiteral("color"),   &ParseColor , color);
-	ReadElmAttr(elm, QStringLiteral("bgcolor"), &ParseColor , bgcolor);
+	ReadElmAttr(attrs, QStringLiteral("format"),  &ParseFormat, eFormat);
+	ReadElmAttr(attrs, QStringLiteral("align"),   &ParseHAlign, align);
+	ReadElmAttr(attrs, QStringLiteral("valign"),  &ParseVAlign, valign);
+	ReadElmAttr(attrs, QStringLiteral("color"),   &ParseColor , color);
+	ReadElmAttr(attrs, QStringLiteral("bgcolor"), &ParseColor , bgcolor);
 }
 
 
-void Page::ReadXML(const QDomElement& elm, const Levelset& levelset)
+void Page::ReadXML(Scan& scan, const Levelset& levelset)
 {
-	sText = elm.text();
-
 	pageProps = levelset.pageProps;
-	pageProps.ReadXML(elm);
+	pageProps.ReadXML(scan.xml.attributes());
+
+	sText = scan.xml.readElementText(QXmlStreamReader::IncludeChildElements);
 }
 
 
-void Text::ReadXML(const QDomElement& elm, const Levelset& levelset)
+// Read up to the end of a prologue or epilogue element, counting its
+// pages, and keeping them if bLoad is set
+void Text::ReadXML(Scan& scan, const Levelset& levelset, bool bLoad)
 {
 	vecPages.clear();
-	QDomNodeList lstElmPages = elm.elementsByTagName(QStringLiteral("page"));
-	for (int i = 0; i < int(lstElmPages.length()); ++i)
+	nPages = 0;
+	bLoaded = bLoad;
+
+	int nDepth = 0;
+	while (!scan.xml.atEnd())
+	{
+		QXmlStreamReader::TokenType t = scan.ReadNext();
+		if (t == QXmlStreamReader::EndElement)
+		{
+			if (nDepth == 0)
+				break;
+			--nDepth;
+		}
+		else if (t == QXmlStreamReader::StartElement)
+		{
+			if (scan.xml.name() != QStringLiteral("page"))
+			{
+				++nDepth;
+				continue;
+			}
+			++nPages;
+			if (bLoad)
+			{
+				Page page;
+				page.ReadXML(scan, levelset);
+				vecPages.push_back(page);
+			}
+			else
+			{
+				scan.xml.skipCurrentElement();
+			}
+		}
+	}
+}
+
+
+// Note where a prologue or epilogue lies in the file, so that its pages
+// can be read later. If the location cannot be pinned down, the pages
+// are read right away instead
+static void ScanText(Scan& scan, Text& txt, const Levelset& levelset)
+{
+	qint64 nStart = scan.ByteOffset(scan.nTokenStart);
+	QByteArray sTag = '<' + scan.xml.qualifiedName().toString().toUtf8();
+	if (scan.data.mid(int(nStart), sTag.size()) != sTag)
 	{
-		QDomElement elmPage = lstElmPages.item(i).toElement();
-		Page page;
-		page.ReadXML(elmPage, levelset);
-		vecPages.push_back(page);
+		txt.ReadXML(scan, levelset, true);
+		return;
 	}
+
+	txt.ReadXML(scan, levelset, false);
+	qint64 nEnd = scan.ByteOffset(scan.xml.characterOffset());
+	if (scan.xml.hasError() || nEnd <= nStart || scan.data[int(nEnd - 1)] != '>')
+	{
+		txt.nPages = 0;
+		txt.bLoaded = true;
+		return;
+	}
+	txt.nOffset = nStart;
+	txt.nSize = nEnd - nStart;
 }
 
 
-void Level::ReadXML(const QDomElement& elm, const Levelset& levelset)
+void Level::ReadXML(Scan& scan, const Levelset& levelset)
 {
+	QXmlStreamAttributes attrs = scan.xml.attributes();
+
 	sAuthor = levelset.sAuthor;
-	ReadElmAttr(elm, QStringLiteral("author"), &ParseString, sAuthor);
+	ReadElmAttr(attrs, QStringLiteral("author"), &ParseString, sAuthor);
 	
 	ruleCompat = levelset.ruleCompat;
-	ruleCompat.ReadXML(elm);
-	
-	QDomNodeList lstElm;
-	lstElm = elm.elementsByTagName(QStringLiteral("prologue"));
-	if (lstElm.length() != 0)
-		txtPrologue.ReadXML(lstElm.item(0).toElement(), levelset);
-	lstElm = elm.elementsByTagName(QStringLiteral("epilogue"));
-	if (lstElm.length() != 0)
-		txtEpilogue.ReadXML(lstElm.item(0).toElement(), levelset);
+	ruleCompat.ReadXML(attrs);
+
+	bool bPrologue = false, bEpilogue = false;
+	int nDepth = 0;
+	while (!scan.xml.atEnd())
+	{
+		QXmlStreamReader::TokenType t = scan.ReadNext();
+		if (t == QXmlStreamReader::EndElement)
+		{
+			if (nDepth == 0)
+				break;
+			--nDepth;
+		}
+		else if (t == QXmlStreamReader::StartElement)
+		{
+			if (!bPrologue && scan.xml.name() == QStringLiteral("prologue"))
+			{
+				ScanText(scan, txtPrologue, levelset);
+				bPrologue = true;
+			}
+			else if (!bEpilogue && scan.xml.name() == QStringLiteral("epilogue"))
+			{
+				ScanText(scan, txtEpilogue, levelset);
+				bEpilogue = true;
+			}
+			else
+			{
+				++nDepth;
+			}
+		}
+	}
 }
 
 
-void Levelset::ReadXML(const QDomElement& elm)
+void Levelset::ReadXML(Scan& scan)
 {
-	ReadElmAttr(elm, QStringLiteral("description"), &ParseString, sDescription);
-	ReadElmAttr(elm, QStringLiteral("copyright"),   &ParseString, sCopyright);
-	ReadElmAttr(elm, QStringLiteral("author"),      &ParseString, sAuthor);
+	QXmlStreamAttributes attrs = scan.xml.attributes();
 
-	ruleCompat.ReadXML(elm);
-	pageProps.ReadXML(elm);
+	ReadElmAttr(attrs, QStringLiteral("description"), &ParseString, sDescription);
+	ReadElmAttr(attrs, QStringLiteral("copyright"),   &ParseString, sCopyright);
+	ReadElmAttr(attrs, QStringLiteral("author"),      &ParseString, sAuthor);
+
+	ruleCompat.ReadXML(attrs);
+	pageProps.ReadXML(attrs);
 	
 	for (int i = 0; i < int(vecLevels.size()); ++i)
 	{
@@ -140,26 +272,37 @@ void Levelset::ReadXML(const QDomElement& elm)
 		rLevel.ruleCompat = ruleCompat;
 	}
 
-	// vecLevels.clear();
-	QDomNodeList lstElmLevels = elm.elementsByTagName(QStringLiteral("level"));
-	for (int i = 0; i < int(lstElmLevels.length()); ++i)
-	{
-		QDomElement elmLevel = lstElmLevels.item(i).toElement();
-		int nNumber = 0;
-		if (!ReadElmAttr(elmLevel, QStringLiteral("number"), &ParseInt, nNumber))
-			continue;
-		if ( ! (nNumber >= 1  &&  nNumber < int(vecLevels.size())) )
-			continue;
-		Level& rLevel = vecLevels[nNumber];
-		rLevel.ReadXML(elmLevel, *this);
-	}
-	
-	QDomNodeList lstElmStyle = elm.elementsByTagName(QStringLiteral("style"));
-	if (lstElmStyle.length() != 0)
+	int nDepth = 0;
+	while (!scan.xml.atEnd())
 	{
-		QDomElement elmStyle = lstElmStyle.item(0).toElement();
-		if (elmStyle.parentNode() == elm)
-			sStyleSheet = elmStyle.text();
+		QXmlStreamReader::TokenType t = scan.ReadNext();
+		if (t == QXmlStreamReader::EndElement)
+		{
+			if (nDepth == 0)
+				break;
+			--nDepth;
+		}
+		else if (t == QXmlStreamReader::StartElement)
+		{
+			if (scan.xml.name() == QStringLiteral("level"))
+			{
+				int nNumber = 0;
+				if (ReadElmAttr(scan.xml.attributes(), QStringLiteral("number"), &ParseInt, nNumber)
+					&& nNumber >= 1  &&  nNumber < int(vecLevels.size()))
+					vecLevels[nNumber].ReadXML(scan, *this);
+				else
+					scan.xml.skipCurrentElement();
+			}
+			else if (nDepth == 0 && sStyleSheet.isEmpty()
+				&& scan.xml.name() == QStringLiteral("style"))
+			{
+				sStyleSheet = scan.xml.readElementText(QXmlStreamReader::IncludeChildElements);
+			}
+			else
+			{
+				++nDepth;
+			}
+		}
 	}
 }
 
@@ -173,22 +316,63 @@ bool Levelset::ReadFile(const QString& sFilePath, int nLevels)
 	QFile file(sFilePath);
 	if (!file.exists())
 		return true;
-	if (!file.open(QIODevice::ReadOnly|QIODevice::Text))
+	if (!file.open(QIODevice::ReadOnly))
 		return false;
+	// The data is only held for the duration of the scan
+	QByteArray data = file.readAll();
+	file.close();
 	
-	QDomDocument doc;
-	if (!doc.setContent(&file))
+	Scan scan(data);
+	while (scan.ReadNext() != QXmlStreamReader::StartElement)
+	{
+		if (scan.xml.atEnd())
+			return false;
+	}
+	if (scan.xml.name() != QStringLiteral("levelset"))
 		return false;
+
+	QString sEncoding = scan.xml.documentEncoding().toString();
+	if (!sEncoding.isEmpty())
+	{
+		scan.bUtf8 = (sEncoding.compare(QLatin1String("utf-8"), Qt::CaseInsensitive) == 0
+			|| sEncoding.compare(QLatin1String("utf8"), Qt::CaseInsensitive) == 0);
+		baXmlDecl = "<?xml version=\"1.0\" encoding=\"" + sEncoding.toLatin1() + "\"?>";
+	}
+	this->sFilePath = sFilePath;
 		
-	QDomElement elmRoot = doc.documentElement();
-	if (elmRoot.tagName() != QStringLiteral("levelset"))
+	ReadXML(scan);
+	
+	if (scan.xml.hasError())
+	{
+		Clear();
+		vecLevels.resize(1+nLevels);
 		return false;
-		
-	ReadXML(elmRoot);
+	}
+	
+	return true;
+}
+
+
+// Read the pages of a prologue or epilogue, if that has not been done
+void Levelset::LoadText(Text& txt) const
+{
+	if (txt.bLoaded)
+		return;
+	txt.bLoaded = true;
 	
+	QFile file(sFilePath);
+	if (!file.open(QIODevice::ReadOnly) || !file.seek(txt.nOffset))
+		return;
+	QByteArray data = baXmlDecl + file.read(txt.nSize);
 	file.close();
 	
-	return true;
+	Scan scan(data);
+	while (scan.ReadNext() != QXmlStreamReader::StartElement)
+	{
+		if (scan.xml.atEnd())
+			return;
+	}
+	txt.ReadXML(scan, *this, true);
 }
 
 
@@ -8,18 +8,20 @@
 
 #include <Qt>
 #include <QString>
+#include <QByteArray>
 #include <QColor>
 
-#include <QDomElement>
-
 #include <vector>
 
+class QXmlStreamAttributes;
+
 
 namespace CCX
 {
 
 
 struct Levelset;
+struct Scan;
 
 enum Compatibility
 {
@@ -35,7 +37,7 @@ struct RulesetCompatibility
 	RulesetCompatibility()
 		: eMS(COMPAT_UNKNOWN), eLynx(COMPAT_UNKNOWN), ePedantic(COMPAT_UNKNOWN) {}
 		
-	void ReadXML(const QDomElement& elm);
+	void ReadXML(const QXmlStreamAttributes& attrs);
 };
 
 enum TextFormat
@@ -57,7 +59,7 @@ struct PageProperties
 		color(Qt::white), bgcolor(Qt::black)
 		{}
 	
-	void ReadXML(const QDomElement& elm);
+	void ReadXML(const QXmlStreamAttributes& attrs);
 };
 
 struct Page
@@ -65,19 +67,25 @@ struct Page
 	QString sText;
 	PageProperties pageProps;
 	
-	void ReadXML(const QDomElement& elm, const Levelset& levelset);
+	void ReadXML(Scan& scan, const Levelset& levelset);
 };
 
+// The pages of a prologue or epilogue are only read from the file when
+// they are about to be shown; until then just their number and their
+// location in the file are known
 struct Text
 {
 	std::vector<Page> vecPages;
+	int nPages;
+	qint64 nOffset, nSize;
+	bool bLoaded;
 	
 	bool bSeen;
 	
 	Text()
-		: bSeen(false) {}
+		: nPages(0), nOffset(0), nSize(0), bLoaded(true), bSeen(false) {}
 
-	void ReadXML(const QDomElement& elm, const Levelset& levelset);
+	void ReadXML(Scan& scan, const Levelset& levelset, bool bLoad);
 };
 
 struct Level
@@ -86,7 +94,7 @@ struct Level
 	RulesetCompatibility ruleCompat;
 	Text txtPrologue, txtEpilogue;
 
-	void ReadXML(const QDomElement& elm, const Levelset& levelset);
+	void ReadXML(Scan& scan, const Levelset& levelset);
 };
 
 struct Levelset
@@ -100,8 +108,12 @@ struct Levelset
 
 	std::vector<Level> vecLevels;
 
-	void ReadXML(const QDomElement& elm);
+	QString sFilePath;
+	QByteArray baXmlDecl;
+
+	void ReadXML(Scan& scan);
 	bool ReadFile(const QString& sFilePath, int nLevels);
+	void LoadText(Text& txt) const;
 	void Clear();
 };
 
@@ -13,6 +13,8 @@
 #include "../oshw.h"
 
 #include <QClipboard>
+#include <QEventLoop>
+#include <QTimer>
 
 #include <cstring>
 #include <cstdlib>
@@ -55,6 +57,16 @@ static void _eventupdate(int wait)
 	QApplication::processEvents(wait ? QEventLoop::WaitForMoreEvents : QEventLoop::AllEvents);
 }
 
+/* Process events as they arrive, until the given number of
+ * milliseconds have passed.
+ */
+static void _eventwait(int ms)
+{
+	QEventLoop loop;
+	QTimer::singleShot(ms, Qt::PreciseTimer, &loop, &QEventLoop::quit);
+	loop.exec();
+}
+
 
 /* Initialize the OS/hardware interface. This function must be called
  * before any others in the oshw library. If silence is TRUE, the
@@ -77,6 +89,7 @@ bool TileWorldApp::Initialize(bool bSilence, int nSoundBufSize,
                               bool bShowHistogram, bool bFullScreen)
 {
     geng.eventupdatefunc = _eventupdate;
+    geng.eventwaitfunc = _eventwait;
 
 	m_bSilence = bSilence;
 	m_bShowHistogram = bShowHistogram;
@@ -165,6 +178,8 @@ int main(int argc, char *argv[])
 		const char* szArg = argv[i];
 		if (strlen(szArg) == 2  &&  szArg[0] == '-'  &&  strchr("lstbhdvV", szArg[1]) != nullptr)
 			return tworld(argc, argv);
+		if (strcmp(szArg, "-E") == 0)
+			qputenv("QT_QPA_PLATFORM", "offscreen");	// Exporting frames renders to memory only
 	}
 	
 	TileWorldApp app(argc, argv);
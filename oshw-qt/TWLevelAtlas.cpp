@@ -0,0 +1,215 @@
+/* Copyright (C) 2026 by the Tile World developers,
+ * under the GNU General Public License. No warranty. See COPYING for details.
+ */
+
+#include "TWLevelAtlas.h"
+
+#include "oshwbind.h"
+
+#include "../generic/generic.h"
+
+#include "../state.h"
+#include "../encoding.h"
+#include "../solution.h"
+#include "../err.h"
+
+#include <QDir>
+#include <QHash>
+#include <QPainter>
+#include <QRunnable>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <memory>
+#include <cstring>
+
+
+// Paints the map of one level into its slot in the atlas. The level
+//  has already been decoded into tile ids, so this touches nothing but
+//  its own rectangle of pixels and may run on any thread.
+
+class TWThumbRenderer : public QRunnable
+{
+public:
+	TWThumbRenderer(uchar* pBits, int nBytesPerLine, const QRect& rect,
+			const unsigned char* pCells, const QRgb* pPalette)
+		: m_pBits(pBits), m_nBytesPerLine(nBytesPerLine), m_rect(rect),
+		  m_pPalette(pPalette)
+	{
+		std::memcpy(m_cells, pCells, sizeof m_cells);
+	}
+
+	void run() override
+	{
+		for (int y = 0; y < CYGRID * TWLevelAtlas::CELL_SIZE; ++y)
+		{
+			QRgb* pLine = reinterpret_cast<QRgb*>(m_pBits + (m_rect.top() + y) * m_nBytesPerLine)
+				+ m_rect.left();
+			const unsigned char* pRow = m_cells + (y / TWLevelAtlas::CELL_SIZE) * CXGRID;
+			for (int x = 0; x < CXGRID * TWLevelAtlas::CELL_SIZE; ++x)
+				pLine[x] = m_pPalette[pRow[x / TWLevelAtlas::CELL_SIZE]];
+		}
+	}
+
+private:
+	uchar* m_pBits;
+	int m_nBytesPerLine;
+	QRect m_rect;
+	const QRgb* m_pPalette;
+	unsigned char m_cells[CXGRID * CYGRID];
+};
+
+
+QRect TWLevelAtlas::SlotRect(int nGame)
+{
+	return QRect((nGame % COLUMNS) * THUMB_SIZE, (nGame / COLUMNS) * THUMB_SIZE,
+		THUMB_SIZE, THUMB_SIZE);
+}
+
+// Reduce every tile that appears in a map to the average color of its
+//  image in the current tileset. Only the ids flagged in pPalette are
+//  computed, since some ids have no image of their own.
+void TWLevelAtlas::MakePalette(QRgb* pPalette)
+{
+	Qt_Surface* pTile = static_cast<Qt_Surface*>(TW_NewSurface(geng.wtile, geng.htile, false));
+
+	for (int id = 0; id < 0x80; ++id)
+	{
+		if (!pPalette[id])
+			continue;
+
+		drawfulltileid(pTile, 0, 0, id);
+		const QImage& image = pTile->GetImage();
+		unsigned long r = 0, g = 0, b = 0, n = 0;
+		for (int y = 0; y < image.height(); ++y)
+		{
+			for (int x = 0; x < image.width(); ++x, ++n)
+			{
+				QRgb c = image.pixel(x, y);
+				r += qRed(c);
+				g += qGreen(c);
+				b += qBlue(c);
+			}
+		}
+		pPalette[id] = n ? qRgb(r/n, g/n, b/n) : qRgb(0, 0, 0);
+	}
+
+	TW_FreeSurface(pTile);
+}
+
+void TWLevelAtlas::Build(const gameseries* pSeries)
+{
+	QString sSeries = QString::fromLocal8Bit(pSeries->filebase);
+	QString sCacheFile;
+	if (savedir && *savedir)
+		sCacheFile = QDir(QString::fromLocal8Bit(savedir)).filePath(sSeries + QStringLiteral(".thumbs.png"));
+
+	// Start from whatever was rendered before, in memory or on disk
+	if (sSeries != m_sSeries)
+	{
+		m_sSeries = sSeries;
+		m_image = QImage();
+		m_vecHashes.clear();
+		if (!sCacheFile.isEmpty() && m_image.load(sCacheFile)
+				&& m_image.width() == COLUMNS * THUMB_SIZE)
+		{
+			m_image = m_image.convertToFormat(QImage::Format_RGB32);
+			const QStringList hashes = m_image.text(QStringLiteral("levelhashes"))
+				.split(QLatin1Char(' '));
+			for (const QString& s : hashes)
+			{
+				if (!s.isEmpty())
+					m_vecHashes.push_back(s.toULong(nullptr, 16));
+			}
+		}
+	}
+
+	QHash<unsigned long, int> cached;
+	for (int i = 0; i < int(m_vecHashes.size()); ++i)
+	{
+		if (m_vecHashes[i] && SlotRect(i).bottom() < m_image.height())
+			cached.insert(m_vecHashes[i], i);
+	}
+
+	int nGames = pSeries->count;
+	int nRows = (nGames + COLUMNS - 1) / COLUMNS;
+	QImage image(COLUMNS * THUMB_SIZE, qMax(nRows, 1) * THUMB_SIZE, QImage::Format_RGB32);
+	image.fill(Qt::black);
+	std::vector<unsigned long> vecHashes(nGames, 0);
+
+	// Reuse the slots of unchanged levels, and decode the rest. Decoding
+	//  stays on this thread, as the level reader is not reentrant.
+	std::vector<int> vecStale;
+	std::vector<unsigned char> vecCells;
+	QRgb palette[0x80] = {};
+	{
+		QPainter painter(&image);
+		std::unique_ptr<gamestate> pState(new gamestate);
+		for (int i = 0; i < nGames; ++i)
+		{
+			gamesetup* pGame = pSeries->games + i;
+			if (!pGame->leveldata)
+				continue;
+
+			auto it = cached.constFind(pGame->levelhash);
+			if (it != cached.constEnd())
+			{
+				painter.drawImage(SlotRect(i), m_image, SlotRect(it.value()));
+				vecHashes[i] = pGame->levelhash;
+				continue;
+			}
+
+			std::memset(pState.get(), 0, sizeof *pState);
+			pState->game = pGame;
+			pState->ruleset = pSeries->ruleset;
+			if (!expandleveldata(pState.get()))
+				continue;
+
+			vecStale.push_back(i);
+			for (int pos = 0; pos < CXGRID * CYGRID; ++pos)
+			{
+				unsigned char id = pState->map[pos].top.id;
+				vecCells.push_back(id);
+				palette[id] = 1;
+			}
+			vecHashes[i] = pGame->levelhash;
+		}
+	}
+
+	if (!vecStale.empty())
+	{
+		MakePalette(palette);
+
+		// Fetch the pixels once here, so that no thread triggers a detach
+		uchar* pBits = image.bits();
+		int nBytesPerLine = image.bytesPerLine();
+
+		QThreadPool pool;
+		for (size_t n = 0; n < vecStale.size(); ++n)
+		{
+			pool.start(new TWThumbRenderer(pBits, nBytesPerLine, SlotRect(vecStale[n]),
+				&vecCells[n * CXGRID * CYGRID], palette));
+		}
+		pool.waitForDone();
+	}
+
+	m_image = image;
+	m_vecHashes.swap(vecHashes);
+
+	if (!vecStale.empty() && !sCacheFile.isEmpty() && !readonly)
+	{
+		QStringList hashes;
+		for (unsigned long h : m_vecHashes)
+			hashes << QString::number(h, 16);
+		m_image.setText(QStringLiteral("levelhashes"), hashes.join(QLatin1Char(' ')));
+		if (!m_image.save(sCacheFile, "PNG"))
+			warn("could not write level thumbnails to %s", sCacheFile.toLocal8Bit().constData());
+	}
+}
+
+QPixmap TWLevelAtlas::GetThumbnail(int nGame) const
+{
+	if (nGame < 0 || nGame >= int(m_vecHashes.size()) || !m_vecHashes[nGame])
+		return QPixmap();
+	return QPixmap::fromImage(m_image.copy(SlotRect(nGame)));
+}
@@ -0,0 +1,48 @@
+/* Copyright (C) 2026 by the Tile World developers,
+ * under the GNU General Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef TWLEVELATLAS_H
+#define TWLEVELATLAS_H
+
+
+#include "../gen.h"
+#include "../defs.h"
+
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QString>
+#include <QRgb>
+
+#include <vector>
+
+
+// Miniature maps of all the levels in a series, packed into one image.
+//  The atlas is cached on disk together with the hash of each level's
+//  data, so only new or changed levels ever need to be rendered again.
+
+class TWLevelAtlas
+{
+public:
+	enum
+	{
+		CELL_SIZE = 2,
+		THUMB_SIZE = CXGRID * CELL_SIZE,
+		COLUMNS = 16
+	};
+
+	void Build(const gameseries* pSeries);
+	QPixmap GetThumbnail(int nGame) const;
+
+private:
+	QString m_sSeries;
+	QImage m_image;
+	std::vector<unsigned long> m_vecHashes;
+
+	static QRect SlotRect(int nGame);
+	static void MakePalette(QRgb* pPalette);
+};
+
+
+#endif
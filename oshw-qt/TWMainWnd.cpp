@@ -37,6 +37,7 @@ extern int pedanticmode;
 
 #include <QAbstractTableModel>
 #include <QSortFilterProxyModel>
+#include <QHeaderView>
 
 #include <QStyle>
 #include <QStyledItemDelegate>
@@ -53,6 +54,12 @@ extern int pedanticmode;
 #include <QString>
 #include <QTextStream>
 
+#include <QThread>
+#include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QImage>
+
 #include <vector>
 
 #include <cstring>
@@ -85,6 +92,7 @@ class TWTableModel : public QAbstractTableModel
 public:
 	TWTableModel(QObject* pParent = nullptr);
 	void SetTableSpec(const tablespec* pSpec);
+	void SetDecorations(const std::vector<QPixmap>& vecDecorations, int nCol);
 	
 	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
 	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -101,7 +109,17 @@ protected:
 	
 	int m_nRows, m_nCols;
 	std::vector<ItemInfo> m_vecItems;
+	std::vector<QPixmap> m_vecDecorations;
+	int m_nDecorationCol;
+
+	// For tables that format their rows on demand, only the most
+	// recently requested row is kept
+	tablespec m_spec;
+	mutable int m_nCachedRow;
+	mutable std::vector<ItemInfo> m_vecRowItems;
 	
+	static void AddItems(std::vector<ItemInfo>& vecItems, const char* const* pp, int nCols);
+	const ItemInfo& GetItem(int row, int col) const;
 	QVariant GetData(int row, int col, int role) const;
 };
 
@@ -109,25 +127,19 @@ protected:
 TWTableModel::TWTableModel(QObject* pParent)
 	:
 	QAbstractTableModel(pParent),
-	m_nRows(0), m_nCols(0)
+	m_nRows(0), m_nCols(0),
+	m_nDecorationCol(-1),
+	m_spec(),
+	m_nCachedRow(-1)
 {
 }
 
-void TWTableModel::SetTableSpec(const tablespec* pSpec)
+// Parse the cells of one or more rows, adding one item per column
+void TWTableModel::AddItems(std::vector<ItemInfo>& vecItems, const char* const* pp, int nCols)
 {
-	beginResetModel();
-
-	m_nRows = pSpec->rows;
-	m_nCols = pSpec->cols;
-	int n = m_nRows * m_nCols;
-	
-	m_vecItems.clear();
-	m_vecItems.reserve(n);
-	
 	ItemInfo dummyItemInfo;
 	
-	const char* const * pp = pSpec->items;
-	for (int i = 0; i < n; ++pp)
+	for (int i = 0; i < nCols; ++pp)
 	{
 		const char* p = *pp;
 		ItemInfo ii;
@@ -141,20 +153,62 @@ void TWTableModel::SetTableSpec(const tablespec* pSpec)
 		Qt::Alignment ha = (c=='+' ? Qt::AlignRight : c=='.' ? Qt::AlignHCenter : Qt::AlignLeft);
 		ii.align = (ha | Qt::AlignVCenter);
 		
-		m_vecItems.push_back(ii);
+		vecItems.push_back(ii);
 
 		int d = p[0] - '0';
 		for (int j = 1; j < d; ++j)
 		{
-			m_vecItems.push_back(dummyItemInfo);
+			vecItems.push_back(dummyItemInfo);
 		}
 
 		i += d;
 	}
+}
+
+void TWTableModel::SetTableSpec(const tablespec* pSpec)
+{
+	beginResetModel();
+
+	m_nRows = pSpec->rows;
+	m_nCols = pSpec->cols;
+	m_spec = *pSpec;
+	m_nCachedRow = -1;
+	
+	m_vecItems.clear();
+	if (!pSpec->getrow)
+	{
+		m_vecItems.reserve(m_nRows * m_nCols);
+		AddItems(m_vecItems, pSpec->items, m_nRows * m_nCols);
+	}
 	
 	endResetModel();
 }
 
+const TWTableModel::ItemInfo& TWTableModel::GetItem(int row, int col) const
+{
+	if (!m_spec.getrow)
+		return m_vecItems[row*m_nCols + col];
+
+	if (row != m_nCachedRow)
+	{
+		const char* cells[TABLE_MAXCOLS];
+		(*m_spec.getrow)(m_spec.source, row, cells);
+		m_vecRowItems.clear();
+		AddItems(m_vecRowItems, cells, m_nCols);
+		m_nCachedRow = row;
+	}
+	return m_vecRowItems[col];
+}
+
+// Show a picture alongside the text of each data row in the given column
+void TWTableModel::SetDecorations(const std::vector<QPixmap>& vecDecorations, int nCol)
+{
+	beginResetModel();
+	m_vecDecorations = vecDecorations;
+	m_nDecorationCol = nCol;
+	endResetModel();
+}
+
 int TWTableModel::rowCount(const QModelIndex& parent) const
 {
 	return m_nRows-1;
@@ -167,8 +221,7 @@ int TWTableModel::columnCount(const QModelIndex& parent) const
 
 QVariant TWTableModel::GetData(int row, int col, int role) const
 {
-	int i = row*m_nCols + col;
-	const ItemInfo& ii = m_vecItems[i];
+	const ItemInfo& ii = GetItem(row, col);
 	
 	switch (role)
 	{
@@ -178,6 +231,12 @@ QVariant TWTableModel::GetData(int row, int col, int role) const
 		case Qt::TextAlignmentRole:
 			return int(ii.align);
 		
+		case Qt::DecorationRole:
+			if (col == m_nDecorationCol && row >= 1 && row <= int(m_vecDecorations.size())
+				&& !m_vecDecorations[row-1].isNull())
+				return m_vecDecorations[row-1];
+			return QVariant();
+		
 		default:
 			return QVariant();
 	}
@@ -204,6 +263,9 @@ TileWorldMainWnd::TileWorldMainWnd(QWidget* pParent, Qt::WindowFlags flags)
 	m_bWindowClosed(false),
 	m_pSurface(),
 	m_pInvSurface(),
+	m_pPreviewSurface(),
+	m_seekPreviews(),
+	m_pLblSeekPreview(),
 	m_nKeyState(),
 	m_shortMessages(),
 	m_bKbdRepeatEnabled(true),
@@ -216,7 +278,12 @@ TileWorldMainWnd::TileWorldMainWnd(QWidget* pParent, Qt::WindowFlags flags)
 	m_nTimeLeft(TIME_NIL),
 	m_bTimedLevel(false),
 	m_bReplay(false),
-	m_pSortFilterProxyModel()
+	m_pSortFilterProxyModel(),
+	m_pListSeries(),
+	m_pListLevels(),
+	m_nListLevels(0),
+	m_frameSlots(2 * QThread::idealThreadCount()),
+	m_nFrameErrors(0)
 {
 	setupUi(this);
 	m_bSetupUi = true;
@@ -242,6 +309,10 @@ TileWorldMainWnd::TileWorldMainWnd(QWidget* pParent, Qt::WindowFlags flags)
 	m_pTblList->setItemDelegate(new TWStyledItemDelegate(m_pTblList));
 	
 	m_pTextBrowser->setSearchPaths(QStringList{ QString::fromLocal8Bit(seriesdatdir) });
+
+	m_pLblSeekPreview = new QLabel(this, Qt::ToolTip);
+	m_pLblSeekPreview->setFrameShape(QFrame::Box);
+	m_pSldSeek->setMouseTracking(true);
 	
 	g_pApp->installEventFilter(this);
 
@@ -253,6 +324,8 @@ TileWorldMainWnd::TileWorldMainWnd(QWidget* pParent, Qt::WindowFlags flags)
 	connect(m_pSldSpeed, &QSlider::valueChanged, this, &TileWorldMainWnd::OnSpeedValueChanged);
 	connect(m_pSldSpeed, &QSlider::sliderReleased, this, &TileWorldMainWnd::OnSpeedSliderReleased);
 	connect(m_pSldSeek, &QSlider::valueChanged, this, &TileWorldMainWnd::OnSeekPosChanged);
+	connect(m_pSldSeek, &QSlider::sliderMoved, this, &TileWorldMainWnd::OnSeekSliderMoved);
+	connect(m_pSldSeek, &QSlider::sliderReleased, this, &TileWorldMainWnd::HideSeekPreview);
 	connect(m_pBtnTextNext, &QToolButton::clicked, this, &TileWorldMainWnd::OnTextNext);
 	connect(m_pBtnTextPrev, &QToolButton::clicked, this, &TileWorldMainWnd::OnTextPrev);
 	connect(m_pBtnTextReturn, &QToolButton::clicked, this, &TileWorldMainWnd::OnTextReturn);
@@ -268,6 +341,7 @@ TileWorldMainWnd::TileWorldMainWnd(QWidget* pParent, Qt::WindowFlags flags)
 
 	action_displayCCX->setChecked(getintsetting("displayccx"));
 	action_forceShowTimer->setChecked(getintsetting("forceshowtimer") > 0);
+	action_mouseNavigation->setChecked(getintsetting("mousenavigation") > 0);
 	if (getintsetting("selectedruleset") == Ruleset_Lynx)
 		m_pRadioLynx->setChecked(true);
 	else
@@ -282,6 +356,7 @@ TileWorldMainWnd::~TileWorldMainWnd()
 {
 	g_pApp->removeEventFilter(this);
 
+	TW_FreeSurface(m_pPreviewSurface);
 	TW_FreeSurface(m_pInvSurface);
 	TW_FreeSurface(m_pSurface);
 }
@@ -458,6 +533,25 @@ bool TileWorldMainWnd::HandleEvent(QObject* pObject, QEvent* pEvent)
 		}
 		break;
 		
+		case QEvent::MouseMove:
+		{
+			if (pObject != m_pSldSeek || m_pSldSeek->isSliderDown())
+				return false;
+			QMouseEvent* pMouseEvent = static_cast<QMouseEvent*>(pEvent);
+			ShowSeekPreview(QStyle::sliderValueFromPosition(m_pSldSeek->minimum(),
+				m_pSldSeek->maximum(), pMouseEvent->x(), m_pSldSeek->width()));
+			return false;
+		}
+		break;
+
+		case QEvent::Leave:
+		{
+			if (pObject == m_pSldSeek && !m_pSldSeek->isSliderDown())
+				HideSeekPreview();
+			return false;
+		}
+		break;
+		
 		case QEvent::Wheel:
 		{
 			if (pObject != m_pGameWidget)
@@ -549,10 +643,13 @@ bool TileWorldMainWnd::CreateGameDisplay()
 {
 	TW_FreeSurface(m_pSurface);
 	TW_FreeSurface(m_pInvSurface);
+	TW_FreeSurface(m_pPreviewSurface);
+	ClearSeekPreviews();
 	
 	int w = NXTILES*geng.wtile, h = NYTILES*geng.htile;
 	m_pSurface = static_cast<Qt_Surface*>(TW_NewSurface(w, h, false));
 	m_pInvSurface = static_cast<Qt_Surface*>(TW_NewSurface(4*geng.wtile, 2*geng.htile, false));
+	m_pPreviewSurface = static_cast<Qt_Surface*>(TW_NewSurface(w, h, false));
 
 	m_pGameWidget->setPixmap(m_pSurface->GetPixmap());
 	m_pObjectsWidget->setPixmap(m_pInvSurface->GetPixmap());
@@ -663,8 +760,8 @@ bool TileWorldMainWnd::DisplayGame(const gamestate* pState, int nTimeLeft, int n
 		action_GoTo->setEnabled(true);
 		CCX::Level const & currLevel
 		    (m_ccxLevelset.vecLevels[m_nLevelNum]);
-		bool hasPrologue(!currLevel.txtPrologue.vecPages.empty());
-		bool hasEpilogue(!currLevel.txtEpilogue.vecPages.empty());
+		bool hasPrologue(currLevel.txtPrologue.nPages != 0);
+		bool hasEpilogue(currLevel.txtEpilogue.nPages != 0);
 		action_Prologue->setEnabled(hasPrologue);
 		action_Epilogue->setEnabled(hasEpilogue && bHasSolution);
 
@@ -798,6 +895,66 @@ bool TileWorldMainWnd::DisplayGame(const gamestate* pState, int nTimeLeft, int n
 	return true;
 }
 
+
+/* Writes a captured frame to disk on one of the pool threads. Only a
+ * few frames are allowed to wait for a thread at a time, so that the
+ * rendering cannot run arbitrarily far ahead of the encoding.
+ */
+class TWFrameWriter : public QRunnable
+{
+public:
+	TWFrameWriter(const QImage& image, const QString& sFile,
+			QSemaphore* pSlots, QAtomicInt* pnErrors)
+		: m_image(image), m_sFile(sFile), m_pSlots(pSlots), m_pnErrors(pnErrors) {}
+
+	void run() override
+	{
+		if (!m_image.save(m_sFile, "PNG"))
+			m_pnErrors->ref();
+		m_pSlots->release();
+	}
+
+private:
+	QImage m_image;
+	QString m_sFile;
+	QSemaphore* m_pSlots;
+	QAtomicInt* m_pnErrors;
+};
+
+
+/* Write an image of the game display to a PNG file.
+ */
+int saveframe(char const *path)
+{
+	return g_pMainWnd->SaveFrame(path);
+}
+
+bool TileWorldMainWnd::SaveFrame(const char* szPath)
+{
+	QImage image = m_pGamePage->grab().toImage();
+	if (image.isNull())
+		return false;
+
+	m_frameSlots.acquire();
+	QThreadPool::globalInstance()->start(new TWFrameWriter(image,
+		QString::fromLocal8Bit(szPath) + QStringLiteral(".png"),
+		&m_frameSlots, &m_nFrameErrors));
+	return true;
+}
+
+/* Wait for the frames passed to saveframe() to be written.
+ */
+int finishframes(void)
+{
+	return g_pMainWnd->FinishFrames();
+}
+
+bool TileWorldMainWnd::FinishFrames()
+{
+	QThreadPool::globalInstance()->waitForDone();
+	return m_nFrameErrors.fetchAndStoreRelaxed(0) == 0;
+}
+
 void TileWorldMainWnd::CheckForProblems(const gamestate* pState)
 {
 	QString s;
@@ -957,17 +1114,84 @@ void TileWorldMainWnd::OnSeekPosChanged(int nValue)
 	PulseKey(TWC_SEEK);
 }
 
+void TileWorldMainWnd::OnSeekSliderMoved(int nValue)
+{
+	ShowSeekPreview(nValue);
+}
+
+
+void TileWorldMainWnd::ClearSeekPreviews()
+{
+	m_seekPreviews.clear();
+	HideSeekPreview();
+}
+
+/* Store a preview of the game state for seeking.
+ */
+int addseekpreview(struct gamestate const *state, int seconds)
+{
+	return g_pMainWnd->AddSeekPreview(state, seconds);
+}
+
+bool TileWorldMainWnd::AddSeekPreview(const gamestate* pState, int nSeconds)
+{
+	if (m_pPreviewSurface == nullptr)
+		return false;
+
+	// Render into a surface of our own, leaving the visible map view
+	//  (and the mouse mapping that goes with it) untouched
+	TW_Surface* pScreen = geng.screen;
+	int nViewOrigin = geng.mapvieworigin;
+	geng.screen = m_pPreviewSurface;
+	displaymapview(pState, m_disploc);
+	geng.screen = pScreen;
+	geng.mapvieworigin = nViewOrigin;
+
+	QPixmap pixmap = m_pPreviewSurface->GetPixmap().scaled(m_disploc.w / 2, m_disploc.h / 2,
+		Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	if (nSeconds == 0)	// the start of a new playback
+		m_seekPreviews.clear();
+	while (m_seekPreviews.size() <= nSeconds)
+		m_seekPreviews.push_back(pixmap);
+	return true;
+}
+
+void TileWorldMainWnd::ShowSeekPreview(int nSeconds)
+{
+	if (!m_bReplay || m_seekPreviews.isEmpty())
+	{
+		HideSeekPreview();
+		return;
+	}
+
+	nSeconds = qBound(0, nSeconds, int(m_seekPreviews.size())-1);
+	m_pLblSeekPreview->setPixmap(m_seekPreviews[nSeconds]);
+	m_pLblSeekPreview->adjustSize();
+
+	int x = QStyle::sliderPositionFromValue(m_pSldSeek->minimum(), m_pSldSeek->maximum(),
+		nSeconds, m_pSldSeek->width());
+	QSize size = m_pLblSeekPreview->size();
+	m_pLblSeekPreview->move(m_pSldSeek->mapToGlobal(QPoint(x - size.width()/2, -size.height())));
+	m_pLblSeekPreview->show();
+}
+
+void TileWorldMainWnd::HideSeekPreview()
+{
+	m_pLblSeekPreview->hide();
+}
+
 
 /* Display a short message appropriate to the end of a level's game
  * play. If the level was completed successfully, completed is TRUE,
  * and the other three arguments define the base score and time bonus
  * for the level, and the user's total score for the series; these
- * scores will be displayed to the user.
+ * scores will be displayed to the user. prefetch, if not NULL, is
+ * called once the message is showing.
  */
 int displayendmessage(int basescore, int timescore, long totalscore,
-			     int completed)
+			     int completed, int (*prefetch)(void))
 {
-	return g_pMainWnd->DisplayEndMessage(basescore, timescore, totalscore, completed);
+	return g_pMainWnd->DisplayEndMessage(basescore, timescore, totalscore, completed, prefetch);
 }
 
 void TileWorldMainWnd::ReleaseAllKeys()
@@ -986,15 +1210,19 @@ void TileWorldMainWnd::ReleaseAllKeys()
 	}
 } 
 
-int TileWorldMainWnd::DisplayEndMessage(int nBaseScore, int nTimeScore, long lTotalScore, int nCompleted)
+int TileWorldMainWnd::DisplayEndMessage(int nBaseScore, int nTimeScore, long lTotalScore, int nCompleted, int (*pfnPrefetch)())
 {
-	if (nCompleted == 0)
-		return CmdNone;
-		
-	if (nCompleted == -2)	// abandoned
+	if (nCompleted == 0 || nCompleted == -2)	// nothing to show, or abandoned
+	{
+		if (pfnPrefetch)
+			PrefetchExtensions((*pfnPrefetch)());
 		return CmdNone;
+	}
 		
 	QMessageBox msgBox(this);
+	// Ready the next level once the event loop is showing the message
+	if (pfnPrefetch)
+		QTimer::singleShot(0, &msgBox, [this, pfnPrefetch]() { PrefetchExtensions((*pfnPrefetch)()); });
 	
 	if (nCompleted > 0)	// Success
 	{
@@ -1194,6 +1422,20 @@ int displaylist(char const *title, tablespec const *table, int *index,
 	return g_pMainWnd->DisplayList(title, table, index, listtype, inputcallback);
 }
 
+/* Identify the levels in the next list of scores.
+ */
+void setlistlevels(gameseries const *series, int const *levellist, int count)
+{
+	g_pMainWnd->SetListLevels(series, levellist, count);
+}
+
+void TileWorldMainWnd::SetListLevels(const gameseries* pSeries, const int* pLevelList, int nCount)
+{
+	m_pListSeries = pSeries;
+	m_pListLevels = pLevelList;
+	m_nListLevels = nCount;
+}
+
 int TileWorldMainWnd::DisplayList(const char* szTitle, const tablespec* pTableSpec, int* pnIndex,
 		DisplayListType eListType, int (*pfnInputCallback)(int*))
 {
@@ -1203,6 +1445,17 @@ int TileWorldMainWnd::DisplayList(const char* szTitle, const tablespec* pTableSp
   {
 	TWTableModel model;
 	model.SetTableSpec(pTableSpec);
+	if (eListType == LIST_SCORES && m_pListSeries != nullptr)
+	{
+		m_levelAtlas.Build(m_pListSeries);
+		std::vector<QPixmap> vecThumbs(m_nListLevels);
+		for (int i = 0; i < m_nListLevels; ++i)
+			vecThumbs[i] = m_levelAtlas.GetThumbnail(m_pListLevels[i]);
+		model.SetDecorations(vecThumbs, 1);
+	}
+	m_pListSeries = nullptr;
+	m_pListLevels = nullptr;
+	m_nListLevels = 0;
 	QSortFilterProxyModel proxyModel;
 	m_pSortFilterProxyModel = &proxyModel;
 	proxyModel.setFilterCaseSensitivity(Qt::CaseInsensitive);
@@ -1213,7 +1466,16 @@ int TileWorldMainWnd::DisplayList(const char* szTitle, const tablespec* pTableSp
 	QModelIndex index = proxyModel.mapFromSource(model.index(*pnIndex, 0));
 	m_pTblList->setCurrentIndex(index);
 	m_pTblList->resizeColumnsToContents();
-	m_pTblList->resizeRowsToContents();
+	// Sizing every row would format every row of a table that does
+	// so on demand, and such rows are all alike anyway
+	if (pTableSpec->getrow)
+	{
+		int h = m_pTblList->sizeHintForRow(0);
+		if (h > 0)
+			m_pTblList->verticalHeader()->setDefaultSectionSize(h);
+	}
+	else
+		m_pTblList->resizeRowsToContents();
 	m_pTxtFind->clear();
 	SetCurrentPage(PAGE_TABLE);
 	m_pTblList->setFocus();
@@ -1456,14 +1718,24 @@ void TileWorldMainWnd::ReadExtensions(gameseries* pSeries)
 	}
 }
 
+void TileWorldMainWnd::PrefetchExtensions(int nLevelNum)
+{
+	if (nLevelNum < 1 || nLevelNum >= int(m_ccxLevelset.vecLevels.size()))
+		return;
+	m_ccxLevelset.LoadText(m_ccxLevelset.vecLevels[nLevelNum].txtPrologue);
+}
+
 
 void TileWorldMainWnd::Narrate(CCX::Text CCX::Level::*pmTxt, bool bForce)
 {
 	CCX::Text& rText = m_ccxLevelset.vecLevels[m_nLevelNum].*pmTxt;
 	if ((rText.bSeen || !action_displayCCX->isChecked()) && !bForce)
 		return;
+	if (QGuiApplication::platformName() == QLatin1String("offscreen"))
+		return;	// Nobody is there to page through the text
 	rText.bSeen = true;
 
+	m_ccxLevelset.LoadText(rText);
 	if (rText.vecPages.empty())
 		return;
 	int n = rText.vecPages.size();
@@ -1585,6 +1857,12 @@ void TileWorldMainWnd::OnMenuActionTriggered(QAction* pAction)
 	    return;
 	}
 
+	if (pAction == action_mouseNavigation)
+	{
+		setmousenavigation(pAction->isChecked() ? TRUE : FALSE);
+		return;
+	}
+
 	if (pAction == action_About)
 	{
 		ShowAbout();
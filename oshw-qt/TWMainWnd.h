@@ -9,6 +9,7 @@
 #include "ui_TWMainWnd.h"
 
 #include "CCMetaData.h"
+#include "TWLevelAtlas.h"
 
 #include "../generic/generic.h"
 
@@ -21,6 +22,8 @@
 #include <QMainWindow>
 
 #include <QLocale>
+#include <QSemaphore>
+#include <QAtomicInt>
 
 class QSortFilterProxyModel;
 
@@ -46,12 +49,17 @@ public:
 	bool SetKeyboardRepeat(bool bEnable);
 	uint8_t* GetKeyState(int* pnNumKeys);
 	int GetReplaySecondsToSkip() const;
+	void ClearSeekPreviews();
+	bool AddSeekPreview(const gamestate* pState, int nSeconds);
+	void SetListLevels(const gameseries* pSeries, const int* pLevelList, int nCount);
 	
 	bool CreateGameDisplay();
 	void ClearDisplay();
 	bool DisplayGame(const gamestate* pState, int nTimeLeft, int nBestTime, bool showinitgamestate);
+	bool SaveFrame(const char* szPath);
+	bool FinishFrames();
 	bool SetDisplayMsg(const char* szMsg, int nMSecs, int nBoldMSecs);
-	int DisplayEndMessage(int nBaseScore, int nTimeScore, long lTotalScore, int nCompleted);
+	int DisplayEndMessage(int nBaseScore, int nTimeScore, long lTotalScore, int nCompleted, int (*pfnPrefetch)());
 	int DisplayList(const char* szTitle, const tablespec* pTableSpec, int* pnIndex,
 			DisplayListType eListType, int (*pfnInputCallback)(int*));
 	int DisplayInputPrompt(const char* szPrompt, char* pInput, int nMaxLen,
@@ -60,6 +68,7 @@ public:
 	void SetSubtitle(const char* szSubtitle);
 	
 	void ReadExtensions(gameseries* pSeries);
+	void PrefetchExtensions(int nLevelNum);
 	void Narrate(CCX::Text CCX::Level::*pmTxt, bool bForce = false);
 	
 	void ShowAbout();
@@ -73,6 +82,7 @@ private slots:
 	void OnSpeedValueChanged(int nValue);
 	void OnSpeedSliderReleased();	
 	void OnSeekPosChanged(int nValue);
+	void OnSeekSliderMoved(int nValue);
 	void OnTextNext();
 	void OnTextPrev();
 	void OnTextReturn();
@@ -85,6 +95,8 @@ private:
 	void CheckForProblems(const gamestate* pState);
 	void DisplayMapView(const gamestate* pState);
 	void DisplayShutter();
+	void ShowSeekPreview(int nSeconds);
+	void HideSeekPreview();
 	void SetSpeed(int nValue);
 	void ReleaseAllKeys();
 	void PulseKey(int nTWKey);
@@ -98,8 +110,12 @@ private:
 	
 	Qt_Surface* m_pSurface;
 	Qt_Surface* m_pInvSurface;
+	Qt_Surface* m_pPreviewSurface;
 	TW_Rect m_disploc;
 	
+	QVector<QPixmap> m_seekPreviews;
+	QLabel* m_pLblSeekPreview;
+	
 	uint8_t m_nKeyState[TWK_LAST];
 
 	struct MessageData{ QString sMsg; uint32_t nMsgUntil, nMsgBoldUntil; };
@@ -120,9 +136,17 @@ private:
 	QSortFilterProxyModel* m_pSortFilterProxyModel;
 	QLocale m_locale;
 	
+	const gameseries* m_pListSeries;
+	const int* m_pListLevels;
+	int m_nListLevels;
+	TWLevelAtlas m_levelAtlas;
+	
 	CCX::Levelset m_ccxLevelset;
 	
 	QString m_sTextToCopy;
+	
+	QSemaphore m_frameSlots;
+	QAtomicInt m_nFrameErrors;
 };
 
 
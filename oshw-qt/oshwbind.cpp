@@ -7,8 +7,7 @@
 #include	"../generic/generic.h"
 #include	"../gen.h"
 
-#include <QBitmap>
-#include <QPainter>
+#include <string.h>
 
 #include <chrono>
 #include <thread>
@@ -21,40 +20,55 @@ Qt_Surface::Qt_Surface()
 	bytesPerPixel = 0;
 	pitch = 0;
 	pixels = nullptr;
+	m_bOpaque = true;
 	m_bColorKeySet = false;
 	m_nColorKey = 0;
 }
 
-void Qt_Surface::Init(const QPaintDevice& dev)
-{
-	w = dev.width();
-	h = dev.height();
-	bytesPerPixel = dev.depth() / 8;
-	pitch = 0;
-	pixels = nullptr;
-}
-
 void Qt_Surface::InitImage()
 {
+	w = m_image.width();
+	h = m_image.height();
 	bytesPerPixel = m_image.depth() / 8;
 	pitch = m_image.bytesPerLine();
 	pixels = m_image.bits();
 }
 
+void Qt_Surface::Modified()
+{
+	m_pixmap = QPixmap();
+	pixels = m_image.bits();
+}
+
+void Qt_Surface::CheckOpaque()
+{
+	m_bOpaque = true;
+	for (int y = 0; y < h && m_bOpaque; ++y)
+	{
+		const QRgb* p = reinterpret_cast<const QRgb*>(m_image.constScanLine(y));
+		for (int x = 0; x < w; ++x)
+		{
+			if (qAlpha(p[x]) != 255)
+			{
+				m_bOpaque = false;
+				break;
+			}
+		}
+	}
+}
+
 
 void Qt_Surface::SetPixmap(const QPixmap& pixmap)
 {
-	m_pixmap = pixmap;
-	m_image = QImage();
-	Init(m_pixmap);
+	SetImage(pixmap.toImage());
 }
 
 void Qt_Surface::SetImage(const QImage& image)
 {
-	m_image = image;
+	m_image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
 	m_pixmap = QPixmap();
-	Init(m_image);
 	InitImage();
+	CheckOpaque();
 }
 
 
@@ -69,45 +83,57 @@ const QPixmap& Qt_Surface::GetPixmap()
 
 const QImage& Qt_Surface::GetImage()
 {
-	if (m_image.isNull())
-		m_image = m_pixmap.toImage();
-	InitImage();
 	return m_image;
 }
 
 
 void Qt_Surface::Lock()
 {
-	(void)GetImage();
-	m_pixmap = QPixmap();
+	Modified();
 }
 
 void Qt_Surface::Unlock()
 {
-	// NOTHING
+	CheckOpaque();
 }
 
 
 void Qt_Surface::FillRect(const TW_Rect* pDstRect, uint32_t nColor)
 {
-	(void)GetPixmap();
-	// TODO?: don't force image -> pixmap?
 	// TODO?: for 8-bit?
-	if (!pDstRect)
+	QRect rect(0, 0, w, h);
+	if (pDstRect)
+		rect &= QRect(*pDstRect);
+	if (rect.isEmpty())
+		return;
+
+	// A surface without an alpha channel stays opaque, as with SDL
+	QRgb color = m_bOpaque ? (nColor | 0xFF000000) : qPremultiply(nColor);
+	Modified();
+	for (int y = rect.top(); y <= rect.bottom(); ++y)
 	{
-		m_pixmap.fill(nColor);
+		QRgb* p = reinterpret_cast<QRgb*>(m_image.scanLine(y)) + rect.left();
+		for (int x = 0; x < rect.width(); ++x)
+			p[x] = color;
 	}
-	else
-	{
-		QPainter painter(&m_pixmap);
-		painter.fillRect(*pDstRect, QColor(nColor));
-	}
-	
-	m_image = QImage();
-	pixels = nullptr;
+	if (qAlpha(color) != 255)
+		m_bOpaque = false;
+	else if (rect == QRect(0, 0, w, h))
+		m_bOpaque = true;
 }
 
 
+// Composite a premultiplied source pixel over a destination pixel
+static inline QRgb BlendPixel(QRgb s, QRgb d)
+{
+	uint32_t a = 255 - qAlpha(s);
+	uint32_t rb = (d & 0x00FF00FF) * a;
+	rb = ((rb + ((rb >> 8) & 0x00FF00FF) + 0x00800080) >> 8) & 0x00FF00FF;
+	uint32_t ag = ((d >> 8) & 0x00FF00FF) * a;
+	ag = (ag + ((ag >> 8) & 0x00FF00FF) + 0x00800080) & 0xFF00FF00;
+	return s + (rb | ag);
+}
+
 void Qt_Surface::BlitSurface(Qt_Surface* pSrc, const TW_Rect* pSrcRect,
 						     Qt_Surface* pDst, const TW_Rect* pDstRect)
 {
@@ -122,34 +148,59 @@ void Qt_Surface::BlitSurface(Qt_Surface* pSrc, const TW_Rect* pSrcRect,
 	else if (pDstRect && !pSrcRect)
 		{srcRect.w = dstRect.w; srcRect.h = dstRect.h;}
 
-	// TODO?: don't force image -> pixmap?
-
-	(void)pDst->GetPixmap();
-	pDst->m_image = QImage();
-	pDst->pixels = nullptr;
-
-	QPixmap srcPix;
+	// Clip the copied area to both surfaces
+	int sx = srcRect.x, sy = srcRect.y;
+	int dx = dstRect.x, dy = dstRect.y;
+	int cx = srcRect.w, cy = srcRect.h;
+	if (sx < 0) {dx -= sx; cx += sx; sx = 0;}
+	if (sy < 0) {dy -= sy; cy += sy; sy = 0;}
+	if (dx < 0) {sx -= dx; cx += dx; dx = 0;}
+	if (dy < 0) {sy -= dy; cy += dy; dy = 0;}
+	cx = qMin(cx, qMin(pSrc->w - sx, pDst->w - dx));
+	cy = qMin(cy, qMin(pSrc->h - sy, pDst->h - dy));
+	if (cx <= 0 || cy <= 0)
+		return;
+
+	pDst->Modified();
+	const QImage& srcImage = pSrc->m_image;
+	QImage& dstImage = pDst->m_image;
 	if (pSrc->IsColorKeySet())
 	{
-		QImage image = pSrc->GetImage().copy(srcRect);
-		QImage imgMask = image.createMaskFromColor(pSrc->GetColorKey());
-		
-		srcPix = QPixmap::fromImage(image);
-		QBitmap bmpMask = QBitmap::fromImage(imgMask);
-		srcPix.setMask(bmpMask);
-		
-		srcRect.x = srcRect.y = 0;
-		
-		pDst->m_pixmap = srcPix;	// @#$
-		return;	// @#$
+		QRgb key = qPremultiply(pSrc->GetColorKey() | 0xFF000000);
+		for (int y = 0; y < cy; ++y)
+		{
+			const QRgb* s = reinterpret_cast<const QRgb*>(srcImage.constScanLine(sy + y)) + sx;
+			QRgb* d = reinterpret_cast<QRgb*>(dstImage.scanLine(dy + y)) + dx;
+			for (int x = 0; x < cx; ++x)
+			{
+				if (s[x] != key)
+					d[x] = s[x];
+			}
+		}
+		pDst->CheckOpaque();
+	}
+	else if (pSrc->m_bOpaque)
+	{
+		for (int y = 0; y < cy; ++y)
+			memcpy(dstImage.scanLine(dy + y) + dx * 4,
+			       srcImage.constScanLine(sy + y) + sx * 4, cx * 4);
 	}
 	else
 	{
-		srcPix = pSrc->GetPixmap();
+		for (int y = 0; y < cy; ++y)
+		{
+			const QRgb* s = reinterpret_cast<const QRgb*>(srcImage.constScanLine(sy + y)) + sx;
+			QRgb* d = reinterpret_cast<QRgb*>(dstImage.scanLine(dy + y)) + dx;
+			for (int x = 0; x < cx; ++x)
+			{
+				uint32_t a = qAlpha(s[x]);
+				if (a == 255)
+					d[x] = s[x];
+				else if (a != 0)
+					d[x] = BlendPixel(s[x], d[x]);
+			}
+		}
 	}
-
-	QPainter painter(&(pDst->m_pixmap));
-	painter.drawPixmap(QRect(dstRect).topLeft(), srcPix, srcRect);	
 }
 
 
@@ -168,9 +219,9 @@ void Qt_Surface::ResetColorKey()
 Qt_Surface* Qt_Surface::DisplayFormat()
 {
 	Qt_Surface* pNewSurface = new Qt_Surface(*this);
-	if (!m_image.isNull())
-		pNewSurface->pixels = pNewSurface->m_image.bits();
-	(void)pNewSurface->GetPixmap();
+	pNewSurface->m_pixmap = QPixmap();
+	pNewSurface->InitImage();
+	pNewSurface->CheckOpaque();
 	return pNewSurface;
 }
 
@@ -184,18 +235,9 @@ extern "C" TW_Surface* TW_NewSurface(int w, int h, int bTransparent)
 {
 	Qt_Surface* pSurface = new Qt_Surface();
 
-	if (bTransparent)
-	{
-		QImage image(w, h, QImage::Format_ARGB32);
-		image.fill(0);
-		pSurface->SetImage(image);
-	}
-	else
-	{
-		QPixmap pixmap(w, h);
-		pixmap.fill(Qt::black);
-		pSurface->SetPixmap(pixmap);
-	}
+	QImage image(w, h, QImage::Format_ARGB32_Premultiplied);
+	image.fill(bTransparent ? 0 : 0xFF000000);
+	pSurface->SetImage(image);
 	
 	return pSurface;
 }
@@ -298,9 +340,6 @@ extern "C" TW_Surface* TW_LoadBMP(const char* szFilename, int bSetScreenPalette)
 	if (image.isNull())
 		return nullptr;
 	
-	image = image.convertToFormat(QImage::Format_ARGB32);
-	// Doesn't seem to be necessary, but just in case...
-		
 	Qt_Surface* pSurface = new Qt_Surface();
 	pSurface->SetImage(image);
 	return pSurface;
@@ -199,14 +199,19 @@ public:
 	}
 
 private:
-	QPixmap m_pixmap;
+	// The pixels are always kept in m_image, as premultiplied ARGB, so
+	//  that blits are plain loops over rows. m_pixmap is only a copy
+	//  made for display, and is dropped whenever m_image changes.
 	QImage m_image;
+	QPixmap m_pixmap;
+	bool m_bOpaque;		// true if every pixel has full alpha
 	
 	bool m_bColorKeySet;
 	uint32_t m_nColorKey;
 	
-	void Init(const QPaintDevice& dev);
 	void InitImage();
+	void Modified();
+	void CheckOpaque();
 };
 
 #endif
@@ -89,8 +89,10 @@ typedef	struct oshwglobals
      * rectangles, one for each column. Each rectangle is altered by
      * the function as per puttext's PT_UPDATERECT behavior. row
      * points to an integer indicating the first table entry of the
-     * row to display; upon return, this value is updated to point to
-     * the first entry following the row. flags can be set to PT_DIM
+     * row to display (or the row number, if the table formats its
+     * rows on demand); upon return, this value is updated to point to
+     * the first entry following the row. If cols is NULL, the row is
+     * skipped without being drawn. flags can be set to PT_DIM
      * and/or PT_HIGHLIGHT; the values will be applied to every entry
      * in the row.
      */
@@ -68,6 +68,25 @@ static void _eventupdate(int wait)
     }
 }
 
+/* Dispatch events as they arrive until ms milliseconds have passed.
+ * SDL has no call that waits for an event with a time limit, so the
+ * queue is polled between short naps instead.
+ */
+static void _eventwait(int ms)
+{
+    Uint32	deadline;
+    int		n;
+
+    deadline = SDL_GetTicks() + ms;
+    for (;;) {
+	_eventupdate(FALSE);
+	n = (int)(deadline - SDL_GetTicks());
+	if (n <= 0)
+	    break;
+	SDL_Delay(n < 2 ? n : 2);
+    }
+}
+
 /* Alter the window decoration.
  */
 void setsubtitle(char const *subtitle)
@@ -97,6 +116,23 @@ int getreplaysecondstoskip(void)
     return -1;
 }
 
+/* Store a preview of the game state for seeking. This interface has
+ * no seek control to show previews on, so none are kept, and FALSE
+ * tells the caller not to render any more of them.
+ */
+int addseekpreview(struct gamestate const *state, int seconds)
+{
+    return FALSE;
+}
+
+/* Identify the levels in the next list of scores.
+ */
+void setlistlevels(struct gameseries const *series,
+		   int const *levellist, int count)
+{
+    /* Not implemented. */
+}
+
 void copytoclipboard(char const *text)
 {
     /* Not implemented. */
@@ -118,6 +154,7 @@ int oshwinitialize(int silence, int soundbufsize,
     SDL_Surface	       *icon;
 
     geng.eventupdatefunc = _eventupdate;
+    geng.eventwaitfunc = _eventwait;
 
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
 	errmsg(NULL, "Cannot initialize SDL system: %s\n", SDL_GetError());
@@ -148,5 +185,12 @@ int oshwinitialize(int silence, int soundbufsize,
  */
 int main(int argc, char *argv[])
 {
+    int	n;
+
+    /* Exporting frames renders to memory only.
+     */
+    for (n = 1 ; n < argc ; ++n)
+	if (!strcmp(argv[n], "-E"))
+	    putenv("SDL_VIDEODRIVER=dummy");
     return tworld(argc, argv);
 }
@@ -67,6 +67,110 @@ static SDL_Rect		locrects[8];
  */
 static int		fullredraw = TRUE;
 
+/* The separately updated parts of the information display.
+ */
+enum {
+    FIELD_TITLE,
+    FIELD_LEVEL,
+    FIELD_PASSWD,
+    FIELD_BLANK,
+    FIELD_CHIPSLABEL,
+    FIELD_TIMELABEL,
+    FIELD_CHIPS,
+    FIELD_TIME,
+    FIELD_STEPPING,
+    FIELD_BESTTIME,
+    FIELD_INFOREST,
+    FIELD_HINT,
+    FIELD_PROMPT,
+    FIELD_MESSAGE,
+    FIELD_COUNT
+};
+
+/* Structure recording what was last drawn in one field of the
+ * display, so that it is only drawn again when it changes.
+ */
+typedef	struct fieldinfo {
+    int			valid;		/* FALSE if the field must be drawn */
+    SDL_Rect		area;		/* the rectangle passed to puttext */
+    SDL_Rect		after;		/* the rectangle puttext left behind */
+    int			flags;		/* the flags passed to puttext */
+    int			len;		/* length of the text */
+    char		text[256];	/* the text that was drawn */
+} fieldinfo;
+
+static fieldinfo	fields[FIELD_COUNT];
+
+/* The tiles last drawn in the inventory, or -1 if unknown.
+ */
+static int		invtiles[8];
+
+/* The parts of the screen that were drawn in since the last update.
+ */
+static SDL_Rect		dirtyrects[FIELD_COUNT + 10];
+static int		dirtycount = 0;
+
+/*
+ * Tracking changes to the display.
+ */
+
+/* Forget what is in every field, so that all of them are drawn anew.
+ */
+static void invalidatefields(void)
+{
+    int	n;
+
+    for (n = 0 ; n < FIELD_COUNT ; ++n)
+	fields[n].valid = FALSE;
+    for (n = 0 ; n < 8 ; ++n)
+	invtiles[n] = -1;
+}
+
+/* Add a rectangle to the list of areas to update.
+ */
+static void adddirtyrect(SDL_Rect const *rect)
+{
+    if (dirtycount < (int)(sizeof dirtyrects / sizeof *dirtyrects))
+	dirtyrects[dirtycount++] = *rect;
+}
+
+/* Display text in one of the fields, as with puttext, unless the same
+ * text was already drawn there with the same flags. The return value
+ * is TRUE if the field was drawn.
+ */
+static int putfield(int field, SDL_Rect *rect, char const *text, int len,
+		    int flags)
+{
+    fieldinfo  *f = fields + field;
+    SDL_Rect	area;
+
+    if (len < 0)
+	len = text ? strlen(text) : 0;
+    if (f->valid && f->flags == flags && f->len == len
+		 && !memcmp(&f->area, rect, sizeof *rect)
+		 && (!len || !memcmp(f->text, text, len))) {
+	*rect = f->after;
+	return FALSE;
+    }
+
+    area = *rect;
+    puttext(rect, text, len, flags);
+    f->valid = len < (int)sizeof f->text;
+    f->area = area;
+    f->after = *rect;
+    f->flags = flags;
+    f->len = len;
+    if (f->valid)
+	memcpy(f->text, text, len);
+
+    if (flags & PT_UPDATERECT)
+	area.h = rect->y - area.y;
+    else if (!(flags & PT_MULTILINE) && area.h > sdlg.font.h)
+	area.h = sdlg.font.h;
+    adddirtyrect(&area);
+    return TRUE;
+}
+
 /*
  * Display initialization functions.
  */
@@ -264,6 +368,7 @@ void cleardisplay(void)
 {
     SDL_FillRect(geng.screen, NULL, bkgndcolor(sdlg.textclr));
     fullredraw = TRUE;
+    invalidatefields();
     geng.mapvieworigin = -1;
 }
 
@@ -289,8 +394,8 @@ static void displaymsg(int update)
 	if (msgdisplay.bolduntil < SDL_GetTicks())
 	    f |= PT_DIM;
     }
-    puttext(&messageloc, msgdisplay.msg, msgdisplay.msglen, f);
-    if (update)
+    if (putfield(FIELD_MESSAGE, &messageloc,
+		 msgdisplay.msg, msgdisplay.msglen, f) && update)
 	SDL_UpdateRect(geng.screen, messageloc.x, messageloc.y,
 				    messageloc.w, messageloc.h);
 }
@@ -374,44 +479,46 @@ static void displayshutter(void)
  * value and the player's best recorded time as measured in seconds.
  * The level's title, number, password, and hint, the count of chips
  * needed, and the keys and boots in possession are all used as well
- * in creating the display.
+ * in creating the display. Only the fields that have changed since
+ * they were last drawn are rendered again.
  */
 static void displayinfo(gamestate const *state, int timeleft, int besttime)
 {
     SDL_Rect	rect, rrect;
     char	buf[512];
-    int		n;
+    int		id, n;
 
-    puttext(&titleloc, state->game->name, -1, PT_CENTER);
+    rect = titleloc;
+    putfield(FIELD_TITLE, &rect, state->game->name, -1, PT_CENTER);
 
     rect = infoloc;
 
     if (state->game->number) {
 	sprintf(buf, "Level %d", state->game->number);
-	puttext(&rect, buf, -1, PT_UPDATERECT);
+	putfield(FIELD_LEVEL, &rect, buf, -1, PT_UPDATERECT);
     } else
-	puttext(&rect, "", 0, PT_UPDATERECT);
+	putfield(FIELD_LEVEL, &rect, "", 0, PT_UPDATERECT);
 
-    if (state->game->passwd && *state->game->passwd) {
+    if (*state->game->passwd) {
 	sprintf(buf, "Password: %s", state->game->passwd);
-	puttext(&rect, buf, -1, PT_UPDATERECT);
+	putfield(FIELD_PASSWD, &rect, buf, -1, PT_UPDATERECT);
     } else
-	puttext(&rect, "", 0, PT_UPDATERECT);
+	putfield(FIELD_PASSWD, &rect, "", 0, PT_UPDATERECT);
 
-    puttext(&rect, "", 0, PT_UPDATERECT);
+    putfield(FIELD_BLANK, &rect, "", 0, PT_UPDATERECT);
 
     rrect.x = rinfoloc.x;
     rrect.w = rinfoloc.w;
     rrect.y = rect.y;
     rrect.h = rect.h;
-    puttext(&rect, "Chips", 5, PT_UPDATERECT);
-    puttext(&rect, "Time", 4, PT_UPDATERECT);
-    puttext(&rrect, decimal(state->chipsneeded, 0), -1,
-		    PT_RIGHT | PT_UPDATERECT);
+    putfield(FIELD_CHIPSLABEL, &rect, "Chips", 5, PT_UPDATERECT);
+    putfield(FIELD_TIMELABEL, &rect, "Time", 4, PT_UPDATERECT);
+    putfield(FIELD_CHIPS, &rrect, decimal(state->chipsneeded, 0), -1,
+			  PT_RIGHT | PT_UPDATERECT);
     if (timeleft == TIME_NIL)
-	puttext(&rrect, "---", -1, PT_RIGHT);
+	putfield(FIELD_TIME, &rrect, "---", -1, PT_RIGHT);
     else
-	puttext(&rrect, decimal(timeleft, 0), -1, PT_RIGHT);
+	putfield(FIELD_TIME, &rrect, decimal(timeleft, 0), -1, PT_RIGHT);
     if (state->stepping) {
 	rrect.x += rrect.w;
 	rrect.w = infoloc.x + infoloc.w - rrect.x;
@@ -421,7 +528,7 @@ static void displayinfo(gamestate const *state, int timeleft, int besttime)
 	    sprintf(buf, "   (odd+%d)", state->stepping & 3);
 	else
 	    sprintf(buf, "   (odd)");
-	puttext(&rrect, buf, -1, 0);
+	putfield(FIELD_STEPPING, &rrect, buf, -1, 0);
     }
 
     if (besttime != TIME_NIL) {
@@ -430,37 +537,49 @@ static void displayinfo(gamestate const *state, int timeleft, int besttime)
 	else
 	    sprintf(buf, "Best time: %s", decimal(besttime, 0));
 	n = (state->game->sgflags & SGF_REPLACEABLE) ? PT_DIM : 0;
-	puttext(&rect, buf, -1, PT_UPDATERECT | n);
+	putfield(FIELD_BESTTIME, &rect, buf, -1, PT_UPDATERECT | n);
     }
-    fillrect(&rect);
-
-    for (n = 0 ; n < 4 ; ++n) {
-	drawfulltileid(geng.screen,
-		     invloc.x + n * geng.wtile, invloc.y,
-		     (state->keys[n] ? Key_Red + n : Empty));
-	drawfulltileid(geng.screen,
-		     invloc.x + n * geng.wtile, invloc.y + geng.htile,
-		     (state->boots[n] ? Boots_Ice + n : Empty));
+    putfield(FIELD_INFOREST, &rect, NULL, 0, PT_MULTILINE);
+
+    for (n = 0 ; n < 8 ; ++n) {
+	if (n < 4)
+	    id = state->keys[n] ? Key_Red + n : Empty;
+	else
+	    id = state->boots[n - 4] ? Boots_Ice + n - 4 : Empty;
+	if (id == invtiles[n])
+	    continue;
+	invtiles[n] = id;
+	rect.x = invloc.x + (n % 4) * geng.wtile;
+	rect.y = invloc.y + (n / 4) * geng.htile;
+	rect.w = geng.wtile;
+	rect.h = geng.htile;
+	drawfulltileid(geng.screen, rect.x, rect.y, id);
+	adddirtyrect(&rect);
     }
 
+    rect = hintloc;
     if (state->statusflags & SF_INVALID) {
-	puttext(&hintloc, "This level cannot be played.", -1, PT_MULTILINE);
+	putfield(FIELD_HINT, &rect, "This level cannot be played.", -1,
+				    PT_MULTILINE);
     } else if (state->currenttime < 0 && state->game->unsolvable) {
 	if (*state->game->unsolvable) {
 	    sprintf(buf, "This level is reported to be unsolvable: %s.",
 			 state->game->unsolvable);
-	    puttext(&hintloc, buf, -1, PT_MULTILINE);
+	    putfield(FIELD_HINT, &rect, buf, -1, PT_MULTILINE);
 	} else {
-	    puttext(&hintloc, "This level is reported to be unsolvable.", -1,
-			      PT_MULTILINE);
+	    putfield(FIELD_HINT, &rect,
+		     "This level is reported to be unsolvable.", -1,
+		     PT_MULTILINE);
 	}
     } else if (state->statusflags & SF_SHOWHINT) {
-	puttext(&hintloc, state->hinttext, -1, PT_MULTILINE | PT_CENTER);
+	putfield(FIELD_HINT, &rect, state->hinttext, -1,
+			     PT_MULTILINE | PT_CENTER);
     } else {
-	fillrect(&hintloc);
+	putfield(FIELD_HINT, &rect, NULL, 0, PT_MULTILINE);
     }
 
-    fillrect(&promptloc);
+    rect = promptloc;
+    putfield(FIELD_PROMPT, &rect, NULL, 0, PT_MULTILINE);
 }
 
 /* Display a prompt icon in the lower right-hand corner. completed is
@@ -477,6 +596,7 @@ static int displayprompticon(int completed)
     src.w = PROMPTICONW;
     src.h = PROMPTICONH;
     SDL_BlitSurface(prompticons, &src, geng.screen, &promptloc);
+    fields[FIELD_PROMPT].valid = FALSE;
     SDL_UpdateRect(geng.screen, promptloc.x, promptloc.y,
 				promptloc.w, promptloc.h);
     return TRUE;
@@ -519,6 +639,7 @@ void setcolors(long bkgnd, long text, long bold, long dim)
 			(bold >> 16) & 255, (bold >> 8) & 255, bold & 255);
 
     createprompticons();
+    invalidatefields();
 }
 
 /* Create the game's display. state is a pointer to the gamestate
@@ -526,20 +647,49 @@ void setcolors(long bkgnd, long text, long bold, long dim)
  */
 int displaygame(gamestate const *state, int timeleft, int besttime, int showinitstate)
 {
+    dirtycount = 0;
     if (state->statusflags & SF_SHUTTERED) {
 	displayshutter();
     } else {
 	displaymapview(state, displayloc);
     }
+    adddirtyrect(&displayloc);
     displayinfo(state, timeleft, besttime);
     displaymsg(FALSE);
     if (fullredraw) {
 	SDL_UpdateRect(geng.screen, 0, 0, 0, 0);
 	fullredraw = FALSE;
     } else {
-	SDL_UpdateRects(geng.screen,
-			sizeof locrects / sizeof *locrects, locrects);
+	SDL_UpdateRects(geng.screen, dirtycount, dirtyrects);
     }
+    dirtycount = 0;
+    return TRUE;
+}
+
+/* Write the display surface to a BMP file. Saving a BMP costs little
+ * more than copying the pixels, so the frames are simply written out
+ * one at a time.
+ */
+int saveframe(char const *path)
+{
+    char       *filename;
+    int		f;
+
+    filename = malloc(strlen(path) + 5);
+    if (!filename)
+	memerrexit();
+    sprintf(filename, "%s.bmp", path);
+    f = SDL_SaveBMP(geng.screen, filename) == 0;
+    if (!f)
+	warn("%s: %s", filename, SDL_GetError());
+    free(filename);
+    return f;
+}
+
+/* All frames have already been written by saveframe().
+ */
+int finishframes(void)
+{
     return TRUE;
 }
 
@@ -549,7 +699,7 @@ int displaygame(gamestate const *state, int timeleft, int besttime, int showinit
  * that will be reported to the user.
  */
 int displayendmessage(int basescore, int timescore, long totalscore,
-		      int completed)
+		      int completed, int (*prefetch)(void))
 {
     SDL_Rect	rect;
     int		fullscore;
@@ -571,8 +721,11 @@ int displayendmessage(int basescore, int timescore, long totalscore,
 	puttext(&rect, decimal(totalscore, 7), -1, PT_RIGHT | PT_UPDATERECT);
 	SDL_UpdateRect(geng.screen, hintloc.x, hintloc.y,
 				    hintloc.w, hintloc.h);
+	fields[FIELD_HINT].valid = FALSE;
     }
     displayprompticon(completed);
+    if (prefetch)
+	(*prefetch)();
     return CmdNone;
 }
 
@@ -226,6 +226,111 @@ static void *drawtextscanline32(Uint32 *scanline, int w, int y, Uint32 *clr,
     return scanline;
 }
 
+/* Render a single line of pixels of the given text, using the function
+ * appropriate to the surface depth.
+ */
+static void *drawtextscanline(void *scanline, int bpp, int w, int y,
+			      Uint32 *clr, unsigned char const *text, int len)
+{
+    switch (bpp) {
+      case 1:	return drawtextscanline8(scanline, w, y, clr, text, len);
+      case 2:	return drawtextscanline16(scanline, w, y, clr, text, len);
+      case 3:	return drawtextscanline24(scanline, w, y, clr, text, len);
+      case 4:	return drawtextscanline32(scanline, w, y, clr, text, len);
+    }
+    return scanline;
+}
+
+/*
+ * The cache of rendered text.
+ */
+
+/* The number of rendered strings that are kept, and the length of the
+ * longest string that is kept.
+ */
+#define	TEXTCACHE_SIZE		64
+#define	TEXTCACHE_MAXLEN	255
+
+/* A string of text rendered in the screen's pixel format, ready to be
+ * copied to the screen a scanline at a time.
+ */
+typedef	struct textrun {
+    unsigned long	hash;		/* hash value of the text */
+    unsigned long	lastused;	/* when the run was last drawn */
+    Uint32		clr[3];		/* the colors used to render it */
+    int			bpp;		/* bytes per pixel */
+    int			w;		/* width of the run in pixels */
+    int			len;		/* length of the text */
+    unsigned char      *pixels;		/* the rendered scanlines */
+    unsigned char	text[TEXTCACHE_MAXLEN];	/* the text */
+} textrun;
+
+static textrun		textcache[TEXTCACHE_SIZE];
+static unsigned long	textcacheclock = 0;
+
+/* Discard every rendered string.
+ */
+static void cleartextcache(void)
+{
+    int	n;
+
+    for (n = 0 ; n < TEXTCACHE_SIZE ; ++n)
+	free(textcache[n].pixels);
+    memset(textcache, 0, sizeof textcache);
+    textcacheclock = 0;
+}
+
+/* Return the given text rendered in the given colors, w pixels wide,
+ * either from the cache or freshly rendered in place of the string
+ * that was used least recently. NULL is returned if the text is not
+ * suitable for caching.
+ */
+static textrun *gettextrun(unsigned char const *text, int len, int w,
+			   Uint32 *clr, int bpp)
+{
+    textrun	       *run;
+    textrun	       *oldest;
+    unsigned char      *p;
+    unsigned long	hash;
+    int			n, y;
+
+    if (len <= 0 || len > TEXTCACHE_MAXLEN || w <= 0)
+	return NULL;
+
+    hash = 2166136261UL;
+    for (n = 0 ; n < len ; ++n)
+	hash = ((hash ^ text[n]) * 16777619UL) & 0xFFFFFFFFUL;
+
+    oldest = textcache;
+    for (run = textcache ; run < textcache + TEXTCACHE_SIZE ; ++run) {
+	if (run->pixels && run->hash == hash && run->len == len
+			&& run->bpp == bpp
+			&& !memcmp(run->clr, clr, sizeof run->clr)
+			&& !memcmp(run->text, text, len)) {
+	    run->lastused = ++textcacheclock;
+	    return run;
+	}
+	if (run->lastused < oldest->lastused)
+	    oldest = run;
+    }
+
+    run = oldest;
+    free(run->pixels);
+    if (!(run->pixels = malloc(w * sdlg.font.h * bpp)))
+	memerrexit();
+    run->hash = hash;
+    run->lastused = ++textcacheclock;
+    memcpy(run->clr, clr, sizeof run->clr);
+    run->bpp = bpp;
+    run->w = w;
+    run->len = len;
+    memcpy(run->text, text, len);
+    p = run->pixels;
+    for (y = 0 ; y < sdlg.font.h ; ++y)
+	p = drawtextscanline(p, bpp, w, y, clr, text, len);
+    return run;
+}
+
 /*
  * The main font-rendering functions.
  */
@@ -237,11 +342,12 @@ static void *drawtextscanline32(Uint32 *scanline, int w, int y, Uint32 *clr,
 static void drawtext(SDL_Rect *rect, unsigned char const *text,
 		     int len, int flags)
 {
+    textrun    *run;
     Uint32     *clr;
     void       *p;
     void       *q;
     int		l, r;
-    int		pitch, bpp, n, w, y;
+    int		pitch, bpp, n, w, fullw, y;
 
     if (len < 0)
 	len = text ? strlen((char const*)text) : 0;
@@ -254,6 +360,7 @@ static void drawtext(SDL_Rect *rect, unsigned char const *text,
 	rect->w = w;
 	return;
     }
+    fullw = w;
     if (w >= rect->w) {
 	w = rect->w;
 	l = r = 0;
@@ -277,30 +384,17 @@ static void drawtext(SDL_Rect *rect, unsigned char const *text,
 
     pitch = geng.screen->pitch;
     bpp = geng.screen->format->BytesPerPixel;
+    run = gettextrun(text, len, fullw, clr, bpp);
     p = (unsigned char*)geng.screen->pixels + rect->y * pitch + rect->x * bpp;
     for (y = 0 ; y < sdlg.font.h && y < rect->h ; ++y) {
-	switch (bpp) {
-	  case 1:
-	    q = drawtextscanline8(p, l, y, clr, NULL, 0);
-	    q = drawtextscanline8(q, w, y, clr, text, len);
-	    q = drawtextscanline8(q, r, y, clr, NULL, 0);
-	    break;
-	  case 2:
-	    q = drawtextscanline16(p, l, y, clr, NULL, 0);
-	    q = drawtextscanline16(q, w, y, clr, text, len);
-	    q = drawtextscanline16(q, r, y, clr, NULL, 0);
-	    break;
-	  case 3:
-	    q = drawtextscanline24(p, l, y, clr, NULL, 0);
-	    q = drawtextscanline24(q, w, y, clr, text, len);
-	    q = drawtextscanline24(q, r, y, clr, NULL, 0);
-	    break;
-	  case 4:
-	    q = drawtextscanline32(p, l, y, clr, NULL, 0);
-	    q = drawtextscanline32(q, w, y, clr, text, len);
-	    q = drawtextscanline32(q, r, y, clr, NULL, 0);
-	    break;
+	q = drawtextscanline(p, bpp, l, y, clr, NULL, 0);
+	if (run) {
+	    memcpy(q, run->pixels + y * run->w * bpp, w * bpp);
+	    q = (unsigned char*)q + w * bpp;
+	} else {
+	    q = drawtextscanline(q, bpp, w, y, clr, text, len);
 	}
+	drawtextscanline(q, bpp, r, y, clr, NULL, 0);
 	p = (unsigned char*)p + pitch;
     }
 
@@ -387,6 +481,25 @@ static void _puttext(SDL_Rect *rect, char const *text, int len, int flags)
 	SDL_UnlockSurface(geng.screen);
 }
 
+/* Get the cells of the table row starting at *row, and move *row on
+ * to the next row. For a table whose rows are formatted on demand,
+ * *row counts rows rather than entries.
+ */
+static char const **getcells(tablespec const *table, int *row,
+			     char const **buf)
+{
+    char const	      **cells;
+    int			i;
+
+    if (table->getrow) {
+	(*table->getrow)(table->source, (*row)++, buf);
+	return buf;
+    }
+    cells = table->items + *row;
+    for (i = 0 ; i < table->cols ; i += table->items[(*row)++][0] - '0') ;
+    return cells;
+}
+
 /* Lay out the columns of the given table so that the entire table
  * fits within area (horizontally; no attempt is made to make it fit
  * vertically). Return an array of rectangles, one per column. This
@@ -396,9 +509,11 @@ static void _puttext(SDL_Rect *rect, char const *text, int len, int flags)
 static SDL_Rect *_measuretable(SDL_Rect const *area, tablespec const *table)
 {
     SDL_Rect		       *colsizes;
+    char const		       *buf[TABLE_MAXCOLS];
+    char const		      **cells;
     unsigned char const	       *p;
     int				sep, mlindex, mlwidth, diff;
-    int				i, j, n, i0, c, w, x;
+    int				i, j, k, n, i0, c, w, x;
 
     if (!(colsizes = malloc(table->cols * sizeof *colsizes)))
 	memerrexit();
@@ -413,14 +528,15 @@ static SDL_Rect *_measuretable(SDL_Rect const *area, tablespec const *table)
     mlwidth = 0;
     n = 0;
     for (j = 0 ; j < table->rows ; ++j) {
-	for (i = 0 ; i < table->cols ; ++n) {
-	    c = table->items[n][0] - '0';
+	cells = getcells(table, &n, buf);
+	for (i = 0, k = 0 ; i < table->cols ; ++k) {
+	    c = cells[k][0] - '0';
 	    if (c == 1) {
 		w = 0;
-		p = (unsigned char const*)table->items[n];
+		p = (unsigned char const*)cells[k];
 		for (p += 2 ; *p ; ++p)
 		    w += sdlg.font.w[*p];
-		if (table->items[n][1] == '!') {
+		if (cells[k][1] == '!') {
 		    if (w > mlwidth || mlindex != i)
 			mlwidth = w;
 		    mlindex = i;
@@ -449,11 +565,12 @@ static SDL_Rect *_measuretable(SDL_Rect const *area, tablespec const *table)
     if (diff > 0) {
 	n = 0;
 	for (j = 0 ; j < table->rows && diff > 0 ; ++j) {
-	    for (i = 0 ; i < table->cols ; ++n) {
-		c = table->items[n][0] - '0';
-		if (c > 1 && table->items[n][1] != '!') {
+	    cells = getcells(table, &n, buf);
+	    for (i = 0, k = 0 ; i < table->cols ; ++k) {
+		c = cells[k][0] - '0';
+		if (c > 1 && cells[k][1] != '!') {
 		    w = sep;
-		    p = (unsigned char const*)table->items[n];
+		    p = (unsigned char const*)cells[k];
 		    for (p += 2 ; *p ; ++p)
 			w += sdlg.font.w[*p];
 		    for (i0 = i ; i0 < i + c ; ++i0)
@@ -506,21 +623,26 @@ static int _drawtablerow(tablespec const *table, SDL_Rect *cols,
 			 int *row, int flags)
 {
     SDL_Rect			rect;
+    char const		       *buf[TABLE_MAXCOLS];
+    char const		      **cells;
     unsigned char const	       *p;
-    int				c, f, n, i, y;
+    int				c, f, k, i, y;
 
     if (!cols) {
-	for (i = 0 ; i < table->cols ; i += table->items[(*row)++][0] - '0') ;
+	if (table->getrow)
+	    ++*row;
+	else
+	    getcells(table, row, buf);
 	return TRUE;
     }
+    cells = getcells(table, row, buf);
 
     if (SDL_MUSTLOCK(geng.screen))
 	SDL_LockSurface(geng.screen);
 
     y = cols[0].y;
-    n = *row;
-    for (i = 0 ; i < table->cols ; ++n) {
-	p = (unsigned char const*)table->items[n];
+    for (i = 0, k = 0 ; i < table->cols ; ++k) {
+	p = (unsigned char const*)cells[k];
 	c = p[0] - '0';
 	rect = cols[i];
 	i += c;
@@ -542,7 +664,6 @@ static int _drawtablerow(tablespec const *table, SDL_Rect *cols,
     if (SDL_MUSTLOCK(geng.screen))
 	SDL_UnlockSurface(geng.screen);
 
-    *row = n;
     for (i = 0 ; i < table->cols ; ++i) {
 	cols[i].h -= y - cols[i].y;
 	cols[i].y = y;
@@ -555,6 +676,7 @@ static int _drawtablerow(tablespec const *table, SDL_Rect *cols,
  */
 void freefont(void)
 {
+    cleartextcache();
     if (sdlg.font.h) {
 	free(sdlg.font.memory);
 	sdlg.font.memory = NULL;
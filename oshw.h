@@ -58,10 +58,20 @@ OSHW_EXTERN void settimersecond(int ms);
  */
 OSHW_EXTERN int gettickcount(void);
 
+/* Set the tick counter to the given value, as when returning to an
+ * earlier point in the game.
+ */
+OSHW_EXTERN void settickcount(int tick);
+
 /* Put the program to sleep until the next timer tick.
  */
 OSHW_EXTERN int waitfortick(void);
 
+/* Return the number of milliseconds left before the next timer tick,
+ * or zero if it is already due or the timer is not running.
+ */
+OSHW_EXTERN int ticktimeleft(void);
+
 /* Force the timer to advance to the next tick.
  */
 OSHW_EXTERN int advancetick(void);
@@ -174,16 +184,33 @@ OSHW_EXTERN void cleardisplay(void);
 OSHW_EXTERN int displaygame(struct gamestate const *state,
 			    int timeleft, int besttime, int showinitstate);
 
+/* Write an image of the game display, as last drawn by displaygame(),
+ * to a file. The name of the file is the given path with an image
+ * file extension appended. The image may be written in the
+ * background. FALSE is returned if the image could not be captured.
+ */
+OSHW_EXTERN int saveframe(char const *path);
+
+/* Wait until all images passed to saveframe() have been written.
+ * FALSE is returned if any of them could not be written.
+ */
+OSHW_EXTERN int finishframes(void);
+
 /* Display a short message appropriate to the end of a level's game
  * play. If the level was completed successfully, completed is TRUE,
  * and the other three arguments define the base score and time bonus
  * for the level, and the user's total score for the series; these
  * scores will be displayed to the user. If the return value is CmdNone,
  * the program will wait for subsequent user input, otherwise the
- * command returned will be used as the next action.
+ * command returned will be used as the next action. If prefetch is
+ * not NULL, it is called once the message is showing, so that the next
+ * level can be readied while the user reads it. It returns the number
+ * of the level it readied, or zero, so that any additional data for
+ * that level can be loaded as well.
  */
 OSHW_EXTERN int displayendmessage(int basescore, int timescore,
-			     long totalscore, int completed);
+			     long totalscore, int completed,
+			     int (*prefetch)(void));
 
 /* Display a (very short) message for the given number of
  * milliseconds. bold indicates the number of milliseconds the
@@ -383,6 +410,22 @@ OSHW_EXTERN void readextensions(struct gameseries *series);
  */
 OSHW_EXTERN int getreplaysecondstoskip(void);
 
+/* Render a small preview of the given game state, to be shown when
+ * the user seeks to the given number of seconds into the playback.
+ * The preview for second zero begins the previews of a new playback,
+ * and replaces any that were stored before. FALSE is returned if the
+ * display does not support seek previews.
+ */
+OSHW_EXTERN int addseekpreview(struct gamestate const *state, int seconds);
+
+/* Identify the levels shown in the next LIST_SCORES list, so that the
+ * display can decorate them. levellist gives the index into series of
+ * the level in each row of the list, or -1 for rows that are not
+ * levels. The list must remain valid until displaylist() returns.
+ */
+OSHW_EXTERN void setlistlevels(struct gameseries const *series,
+			       int const *levellist, int count);
+
 /* Copy text to clipboard.
  */
 OSHW_EXTERN void copytoclipboard(char const *text);
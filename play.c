@@ -6,6 +6,10 @@
 
 #include	<stdlib.h>
 #include	<string.h>
+#include	<time.h>
+#ifdef WIN32
+#include	<windows.h>
+#endif
 #include	"defs.h"
 #include	"err.h"
 #include	"state.h"
@@ -15,6 +19,7 @@
 #include	"logic.h"
 #include	"random.h"
 #include	"settings.h"
+#include	"snapshot.h"
 #include	"solution.h"
 #include	"unslist.h"
 #include	"play.h"
@@ -23,6 +28,14 @@
  */
 static gamestate	state;
 
+/* A level whose data has been expanded ahead of time, ready for the
+ * next call to initgamestate(). standbyresult is the value that
+ * expandleveldata() returned for it, or -1 if there is none.
+ */
+static gamestate	standby;
+static unsigned long	standbyhash;
+static int		standbyresult = -1;
+
 /* The current logic module.
  */
 static gamelogic       *logic = NULL;
@@ -40,6 +53,29 @@ static int		mudsucking = 1;
  */
 static int		showinitstate = FALSE;
 
+/* A saved copy of the game state. The copy of the logic module's
+ * state is freed by the module that made it.
+ */
+struct gamesnapshot {
+    int			refcount;	/* holders of the snapshot */
+    unsigned long	serial;		/* the game it was made in */
+    int			tick;		/* the timer's tick count */
+    stateregion		state;		/* the gamestate struct */
+    stateregion		moves;		/* the contents of the move list */
+    void	       *logicstate;	/* the logic module's own state */
+    void	      (*freelogicstate)(void*);
+};
+
+/* A number that changes each time a game begins or ends, so that a
+ * snapshot is never restored into a different game.
+ */
+static unsigned long	gameserial = 0;
+
+/* The snapshot most recently saved or restored in the current game,
+ * which the next snapshot is compared against to share its pages.
+ */
+static gamesnapshot    *basesnapshot = NULL;
+
 /* Turn on the pedantry.
  */
 void setpedanticmode(void)
@@ -63,6 +99,22 @@ void toggleshowinitstate(void)
     setintsetting("showinitstate", showinitstate);
 }
 
+void setmousenavigation(int on)
+{
+    mousenavigation = on;
+    setintsetting("mousenavigation", on);
+}
+
+/* Stop sharing pages with the last snapshot.
+ */
+static void dropbasesnapshot(void)
+{
+    if (basesnapshot) {
+	freegamesnapshot(basesnapshot);
+	basesnapshot = NULL;
+    }
+}
+
 /* Configure the game logic, and some of the OS/hardware layer, as
  * required for the given ruleset. Do nothing if the requested ruleset
  * is already the current ruleset.
@@ -116,6 +168,10 @@ static int setrulesetbehavior(int ruleset)
  */
 int initgamestate(gamesetup *game, int ruleset)
 {
+    int	f;
+
+    dropbasesnapshot();
+    ++gameserial;
     if (!setrulesetbehavior(ruleset))
 	die("unable to initialize the system for the requested ruleset");
 
@@ -135,12 +191,32 @@ int initgamestate(gamesetup *game, int ruleset)
     initmovelist(&state.moves);
     resetprng(&state.mainprng);
 
-    if (!expandleveldata(&state))
+    if (standbyresult >= 0 && standby.game == game
+			   && standbyhash == game->levelhash) {
+	copyleveldata(&state, &standby);
+	f = standbyresult;
+	standbyresult = -1;
+    } else {
+	f = expandleveldata(&state);
+    }
+    if (!f)
 	return FALSE;
 
     return (*logic->initgame)(logic);
 }
 
+/* Expand the data of the level that is likely to be played next, so
+ * that the next call to initgamestate() for it can skip that step.
+ */
+void prefetchgamestate(gamesetup *game)
+{
+    memset(standby.map, 0, sizeof standby.map);
+    standby.game = game;
+    standby.statusflags = 0;
+    standbyhash = game->levelhash;
+    standbyresult = expandleveldata(&standby);
+}
+
 /* Change the current state to run from the recorded solution.
  */
 int prepareplayback(void)
@@ -346,6 +422,15 @@ int doturn(int cmd)
     return n;
 }
 
+/* Have the game logic bring the game state up to date before it is
+ * read outside of the logic.
+ */
+static void updateview(void)
+{
+    if (logic->updateview)
+	(*logic->updateview)(logic);
+}
+
 /* Update the display to show the current game state (including sound
  * effects, if any). If showframe is FALSE, then nothing is actually
  * displayed.
@@ -360,6 +445,7 @@ int drawscreen(int showframe)
 
     if (!showframe)
 	return TRUE;
+    updateview();
 
     currenttime = state.currenttime + state.timeoffset;
 
@@ -380,6 +466,14 @@ int drawscreen(int showframe)
     return displaygame(&state, timeleft, besttime, showinitstate);
 }
 
+/* Hand the current game state to the display as a seek preview.
+ */
+int drawseekpreview(int seconds)
+{
+    updateview();
+    return addseekpreview(&state, seconds);
+}
+
 /* Stop game play and clean up.
  */
 int quitgamestate(void)
@@ -393,6 +487,8 @@ int quitgamestate(void)
  */
 int endgamestate(void)
 {
+    dropbasesnapshot();
+    ++gameserial;
     setsoundeffects(-1);
     return (*logic->endgame)(logic);
 }
@@ -401,6 +497,7 @@ int endgamestate(void)
  */
 void shutdowngamestate(void)
 {
+    dropbasesnapshot();
     setrulesetbehavior(Ruleset_None);
     destroymovelist(&state.moves);
 }
@@ -410,6 +507,8 @@ void shutdowngamestate(void)
  */
 void setenddisplay(void)
 {
+    dropbasesnapshot();
+    ++gameserial;
     state.replay = -1;
     state.timelimit = 0;
     state.currenttime = -1;
@@ -478,32 +577,278 @@ int deletesolution(void)
     return TRUE;
 }
 
-/* Double-checks the timing for a solution that has just been played
- * back. If the timing is off, and the cause of the discrepancy can be
- * reasonably ascertained to be benign, the timing will be corrected
- * and TRUE is returned.
+/* Compare the timing of the solution that has just been played back
+ * against its recorded time, and correct the latter. The return
+ * value indicates the cause of the discrepancy, if any (see the
+ * Timing_ values in play.h).
  */
-int checksolution(void)
+static int checktiming(void)
 {
     int	currenttime;
 
-    if (!hassolution(state.game))
-	return FALSE;
     currenttime = state.currenttime + state.timeoffset;
     if (currenttime == state.game->besttime)
-	return FALSE;
+	return Timing_OK;
     warn("saved game has solution time of %d ticks, but replay took %d ticks",
 	 state.game->besttime, currenttime);
     if (state.game->besttime == state.currenttime) {
 	warn("difference matches clock offset; fixing.");
 	state.game->besttime = currenttime;
-	return TRUE;
+	return Timing_ClockOffset;
     } else if (currenttime - state.game->besttime == 1) {
 	warn("difference matches pre-0.10.1 error; fixing.");
 	state.game->besttime = currenttime;
-	return TRUE;
+	return Timing_OffByOne;
     }
     warn("reason for difference unknown.");
     state.game->besttime = currenttime;
-    return FALSE;
+    return Timing_Unknown;
+}
+
+/* Double-checks the timing for a solution that has just been played
+ * back. If the timing is off, and the cause of the discrepancy can be
+ * reasonably ascertained to be benign, the timing will be corrected
+ * and TRUE is returned.
+ */
+int checksolution(void)
+{
+    int	n;
+
+    if (!hassolution(state.game))
+	return FALSE;
+    n = checktiming();
+    return n == Timing_ClockOffset || n == Timing_OffByOne;
+}
+
+/* Return the time in seconds from a clock that runs steadily, unlike
+ * the wall clock, which can be adjusted while a playback is timed.
+ */
+#ifdef WIN32
+static double getelapsedtime(void)
+{
+    LARGE_INTEGER	frequency, count;
+
+    if (!QueryPerformanceFrequency(&frequency)
+			|| !QueryPerformanceCounter(&count))
+	return 0.0;
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+}
+#else
+static double getelapsedtime(void)
+{
+    struct timespec	ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts))
+	return 0.0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+#endif
+
+/* Play back the solution for the given level from start to finish
+ * without rendering anything, and correct its timing as
+ * checksolution() does. The return value is positive if the solution
+ * completes the level, zero if it does not, and negative if there is
+ * no solution that can be played back. If info is not NULL, it
+ * receives the details of the playback, and its ontick callback, if
+ * set, is called after every turn.
+ */
+int verifysolution(gamesetup *game, int ruleset, verifyinfo *info)
+{
+    double	starttime;
+    int		besttime = game->besttime;
+    int		f = -1;
+
+    if (!hassolution(game))
+	return -1;
+    starttime = getelapsedtime();
+    if (initgamestate(game, ruleset) && prepareplayback()) {
+	setgameplaymode(NonrenderPlay);
+	for (;;) {
+	    f = doturn(CmdNone);
+	    if (info && info->ontick && !(*info->ontick)(info->tickdata))
+		f = -1;
+	    if (f)
+		break;
+	    advancetick();
+	}
+	setgameplaymode(EndPlay);
+	if (info) {
+	    info->besttime = besttime;
+	    info->ticks = state.currenttime + state.timeoffset;
+	    info->timing = Timing_OK;
+	}
+	if (f > 0) {
+	    f = checktiming();
+	    if (info)
+		info->timing = f;
+	    f = 1;
+	} else {
+	    f = 0;
+	}
+    }
+    endgamestate();
+    if (info)
+	info->seconds = getelapsedtime() - starttime;
+    return f;
+}
+
+/* Play back the given moves on the given level without rendering
+ * anything, leaving the level's own solution untouched. The return
+ * value is the number of ticks that the moves take to complete the
+ * level, or -1 if they do not complete it in fewer than limit ticks.
+ */
+int timesolution(gamesetup *game, int ruleset, solutioninfo const *solution,
+		 int limit)
+{
+    int	f = -1;
+
+    if (initgamestate(game, ruleset) && solution->moves.count) {
+	copymovelist(&state.moves, &solution->moves);
+	restartprng(&state.mainprng, solution->rndseed);
+	state.initrndslidedir = solution->rndslidedir;
+	state.stepping = solution->stepping;
+	state.replay = 0;
+	setgameplaymode(NonrenderPlay);
+	for (;;) {
+	    f = doturn(CmdNone);
+	    if (f)
+		break;
+	    if (state.currenttime + state.timeoffset + 1 >= limit) {
+		f = -1;
+		break;
+	    }
+	    advancetick();
+	}
+	setgameplaymode(EndPlay);
+	f = f > 0 ? state.currenttime + state.timeoffset : -1;
+    }
+    endgamestate();
+    return f;
+}
+
+/* Hash the parts of the current game state that the logic modules
+ * share with the rest of the program. FNV-1a is used, truncated to
+ * 32 bits so that traces agree between platforms. Each field is fed
+ * in at a fixed width, least significant byte first, so that the
+ * hash does not depend on the host's byte order or integer sizes.
+ */
+static unsigned long hashfield(unsigned long hash, long value, int size)
+{
+    unsigned long	bits = (unsigned long)value;
+
+    while (size--) {
+	hash = ((hash ^ (bits & 0xFF)) * 16777619UL) & 0xFFFFFFFFUL;
+	bits >>= 8;
+    }
+    return hash;
+}
+
+/* Return a hash of the current game state.
+ */
+unsigned long getstatehash(void)
+{
+    creature const     *cr;
+    unsigned long	hash = 2166136261UL;
+    int			n;
+
+    updateview();
+    hash = hashfield(hash, state.currenttime, 4);
+    hash = hashfield(hash, state.chipsneeded, 2);
+    for (n = 0 ; n < 4 ; ++n)
+	hash = hashfield(hash, state.keys[n], 2);
+    for (n = 0 ; n < 4 ; ++n)
+	hash = hashfield(hash, state.boots[n], 2);
+    hash = hashfield(hash, state.statusflags, 2);
+    for (n = 0 ; n < CXGRID * CYGRID ; ++n) {
+	hash = hashfield(hash, state.map[n].top.id, 1);
+	hash = hashfield(hash, state.map[n].top.state, 1);
+	hash = hashfield(hash, state.map[n].bot.id, 1);
+	hash = hashfield(hash, state.map[n].bot.state, 1);
+    }
+    for (cr = state.creatures ; cr && cr->id ; ++cr) {
+	hash = hashfield(hash, cr->pos, 2);
+	hash = hashfield(hash, cr->id, 1);
+	hash = hashfield(hash, cr->dir, 1);
+	hash = hashfield(hash, cr->moving, 1);
+	hash = hashfield(hash, cr->hidden, 1);
+    }
+    return hash;
+}
+
+/*
+ * Snapshot functions.
+ */
+
+/* Save a copy of the current game state. Each part of it is compared
+ * with the last snapshot, and the pages that have not changed since
+ * are shared instead of copied.
+ */
+gamesnapshot *savegamestate(void)
+{
+    gamesnapshot       *snapshot;
+    gamesnapshot const *base = basesnapshot;
+
+    snapshot = malloc(sizeof *snapshot);
+    if (!snapshot)
+	memerrexit();
+    snapshot->refcount = 1;
+    snapshot->serial = gameserial;
+    snapshot->tick = gettickcount();
+    savestateregion(&snapshot->state, &state, sizeof state,
+		    base ? &base->state : NULL);
+    savestateregion(&snapshot->moves, state.moves.list,
+		    state.moves.count * sizeof *state.moves.list,
+		    base ? &base->moves : NULL);
+    snapshot->logicstate = (*logic->savestate)(logic,
+					       base ? base->logicstate : NULL);
+    snapshot->freelogicstate = logic->freestate;
+
+    dropbasesnapshot();
+    ++snapshot->refcount;
+    basesnapshot = snapshot;
+    return snapshot;
+}
+
+/* Return the game to the state saved in snapshot. The move list keeps
+ * its own allocation, and is grown if the saved moves do not fit.
+ */
+int restoregamestate(gamesnapshot *snapshot)
+{
+    actlist	moves;
+
+    if (snapshot->serial != gameserial)
+	return FALSE;
+
+    moves = state.moves;
+    restorestateregion(&snapshot->state, &state);
+    moves.count = snapshot->moves.size / sizeof *moves.list;
+    if (moves.count > moves.allocated) {
+	moves.allocated = moves.count;
+	x_alloc(moves.list, moves.allocated * sizeof *moves.list);
+    }
+    state.moves = moves;
+    restorestateregion(&snapshot->moves, state.moves.list);
+    resumeprng(&state.mainprng);
+    (*logic->restorestate)(logic, snapshot->logicstate);
+    settickcount(snapshot->tick);
+
+    if (snapshot != basesnapshot) {
+	dropbasesnapshot();
+	++snapshot->refcount;
+	basesnapshot = snapshot;
+    }
+    return TRUE;
+}
+
+/* Release a snapshot. Its memory is freed once nothing else is using
+ * it.
+ */
+void freegamesnapshot(gamesnapshot *snapshot)
+{
+    if (!snapshot || --snapshot->refcount)
+	return;
+    freestateregion(&snapshot->state);
+    freestateregion(&snapshot->moves);
+    (*snapshot->freelogicstate)(snapshot->logicstate);
+    free(snapshot);
 }
@@ -9,6 +9,8 @@
 
 #include	"defs.h"
 
+struct solutioninfo;
+
 /* The different modes of the program with respect to gameplay.
  */
 enum {
@@ -36,6 +38,13 @@ extern void setgameplaymode(int mode);
  */
 extern int initgamestate(gamesetup *game, int ruleset);
 
+/* Decode the given level ahead of time into a standby state, which
+ * initgamestate() then takes over instead of decoding it again. This
+ * is meant to be done while the player is looking at the end of the
+ * previous level.
+ */
+extern void prefetchgamestate(gamesetup *game);
+
 /* Set up the current state to play from its prerecorded solution.
  * FALSE is returned if no solution is available for playback.
  */
@@ -67,6 +76,12 @@ extern int doturn(int cmd);
  */
 extern int drawscreen(int showframe);
 
+/* Hand the current game state to the display as the preview for the
+ * given number of seconds into a playback. FALSE is returned if the
+ * display does not keep seek previews.
+ */
+extern int drawseekpreview(int seconds);
+
 /* Quit game play early.
  */
 extern int quitgamestate(void);
@@ -106,6 +121,71 @@ extern int deletesolution(void);
  */
 extern int checksolution(void);
 
+/* How the recorded time of a verified solution compared with the
+ * time its playback took.
+ */
+enum {
+    Timing_OK,			/* the times agreed */
+    Timing_ClockOffset,		/* the recorded time omitted the offset */
+    Timing_OffByOne,		/* the recorded time was one tick short */
+    Timing_Unknown		/* the times differed for no known reason */
+};
+
+/* The details of a solution's playback, as reported by
+ * verifysolution().
+ */
+typedef	struct verifyinfo {
+    int	      (*ontick)(void*);	/* if set, called after each turn */
+    void       *tickdata;	/* argument passed to ontick */
+    int		besttime;	/* the solution's time before playback */
+    int		ticks;		/* the length of the playback */
+    int		timing;		/* how the two times compared */
+    double	seconds;	/* real duration of the playback */
+} verifyinfo;
+
+/* Play back the given level's solution without rendering, and correct
+ * its timing as checksolution() does. The return value is positive if
+ * the solution is valid, zero if it is not, and negative if there is
+ * no solution to play back. info receives the playback's details. The
+ * caller sets its first two fields: if ontick returns FALSE, the
+ * playback is stopped and treated as a failure.
+ */
+extern int verifysolution(gamesetup *game, int ruleset, verifyinfo *info);
+
+/* Play back the moves in solution on the given level without
+ * rendering anything, and return the number of ticks they take to
+ * complete it. The level's own solution is not used or changed. -1 is
+ * returned if the moves do not complete the level in fewer than limit
+ * ticks.
+ */
+extern int timesolution(gamesetup *game, int ruleset,
+			struct solutioninfo const *solution, int limit);
+
+/* Return a hash of the current game state, for comparing playbacks
+ * tick by tick.
+ */
+extern unsigned long getstatehash(void);
+
+/* A saved copy of the game state, from which play can be resumed.
+ */
+typedef	struct gamesnapshot gamesnapshot;
+
+/* Save a copy of the current game state. Successive snapshots of the
+ * same game share whatever memory is unchanged between them, so that
+ * taking one at every tick is cheap.
+ */
+extern gamesnapshot *savegamestate(void);
+
+/* Return the current game to the state saved in snapshot, which can
+ * be used again afterwards. FALSE is returned if the snapshot was
+ * made in a different game.
+ */
+extern int restoregamestate(gamesnapshot *snapshot);
+
+/* Discard a snapshot.
+ */
+extern void freegamesnapshot(gamesnapshot *snapshot);
+
 /* Turn pedantic mode on. The ruleset will be slightly changed to be
  * as faithful as possible to the original source material.
  */
@@ -121,6 +201,11 @@ extern int setmudsuckingfactor(int mud);
  */
 extern void toggleshowinitstate(void);
 
+/* Turn shortest-path mouse navigation in the MS ruleset on or off,
+ * and remember the choice in the settings.
+ */
+extern void setmousenavigation(int on);
+
 #ifdef __cplusplus
 }
 #endif
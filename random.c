@@ -73,6 +73,14 @@ void restartprng(prng *gen, unsigned long seed)
     gen->shared = FALSE;
 }
 
+/* Make the shared sequence continue from the PRNG's value.
+ */
+void resumeprng(prng const *gen)
+{
+    if (gen->shared)
+	lastvalue = gen->value;
+}
+
 /* Use the top two bits to get a random number between 0 and 3.
  */
 int random4(prng *gen)
@@ -21,6 +21,11 @@ extern void resetprng(prng *gen);
  */
 extern void restartprng(prng *gen, unsigned long initial);
 
+/* Continue a shared PRNG's sequence from its current value, as after
+ * it has been returned to an earlier state.
+ */
+extern void resumeprng(prng const *gen);
+
 /* Retrieve the original seed value of the current sequence.
  */
 #define	getinitialseed(gen)	((gen)->initial)
@@ -4,6 +4,7 @@
  * General Public License. No warranty. See COPYING for details.
  */
 
+#include	<cstdarg>
 #include	<cstdio>
 #include	<cstdlib>
 #include	<cstring>
@@ -100,129 +101,217 @@ int getscoresforlevel(gameseries const *series, int level,
     return TRUE;
 }
 
+/* The data from which the rows of a score or time table are
+ * formatted when they are displayed.
+ */
+struct scoretable {
+    gameseries const   *series;		/* the series being listed */
+    int		       *levels;		/* the level shown in each row */
+    int			count;		/* the number of level rows */
+    long		total;		/* the total score */
+    int			showpartial;	/* precision of fractional times */
+    int			usepasswds;	/* TRUE if passwords are honored */
+    char		zchar;		/* the character for zero digits */
+};
+
+/* Format the text of one cell of a row. The text remains valid until
+ * the same cell is formatted again.
+ */
+static char const *cell(int n, char const *fmt, ...)
+{
+    static char	buf[TABLE_MAXCOLS][272];
+    va_list	args;
+
+    va_start(args, fmt);
+    vsnprintf(buf[n], sizeof buf[n], fmt, args);
+    va_end(args);
+    return buf[n];
+}
+
+/* Supply the cells of one row of a score table.
+ */
+static int getscorerow(void const *source, int row, char const **cells)
+{
+    scoretable const   *t = (scoretable const*)source;
+    gamesetup const    *game;
+    int			levelscore, timescore;
+
+    if (row == 0) {
+	cells[0] = "1+Level";
+	cells[1] = "1-Name";
+	cells[2] = "1+Base";
+	cells[3] = "1+Bonus";
+	cells[4] = "1+Score";
+	return 5;
+    }
+    if (row > t->count) {
+	cells[0] = "2-Total Score";
+	cells[1] = cell(1, "3+%s", cdecimal(t->total, t->zchar));
+	return 2;
+    }
+
+    game = t->series->games + t->levels[row - 1];
+    cells[0] = cell(0, "1+%s", decimal(game->number, t->zchar));
+    if (!hassolution(game)) {
+	if (!t->usepasswds || (game->sgflags & SGF_HASPASSWD))
+	    cells[1] = cell(1, "4-%s", game->name);
+	else
+	    cells[1] = "4- ";
+	return 2;
+    }
+    cells[1] = cell(1, "1-%.64s", game->name);
+    if (game->sgflags & SGF_REPLACEABLE) {
+	cells[2] = "3.*BAD*";
+	return 3;
+    }
+    levelscore = 500 * game->number;
+    cells[2] = cell(2, "1+%s", cdecimal(levelscore, t->zchar));
+    if (game->time) {
+	timescore = 10 * (game->time - game->besttime / TICKS_PER_SECOND);
+	cells[3] = cell(3, "1+%s", cdecimal(timescore, t->zchar));
+    } else {
+	timescore = 0;
+	cells[3] = "1+---";
+    }
+    cells[4] = cell(4, "1+%s", cdecimal(levelscore + timescore, t->zchar));
+    return 5;
+}
+
+/* Supply the cells of one row of a time table.
+ */
+static int gettimerow(void const *source, int row, char const **cells)
+{
+    scoretable const   *t = (scoretable const*)source;
+    gamesetup const    *game;
+    char		secs[32];
+    double		f, i;
+    long		leveltime;
+    int			n;
+
+    if (row == 0) {
+	cells[0] = "1+Level";
+	cells[1] = "1-Name";
+	cells[2] = "1+Time";
+	cells[3] = "1+Solution";
+	return 4;
+    }
+
+    game = t->series->games + t->levels[row - 1];
+    cells[0] = cell(0, "1+%s", decimal(game->number, t->zchar));
+    cells[1] = cell(1, "1-%.64s", game->name);
+    if (game->time) {
+	leveltime = game->time * TICKS_PER_SECOND - game->besttime;
+	cells[2] = cell(2, "1+%s", decimal(game->time, t->zchar));
+    } else {
+	leveltime = 999 * TICKS_PER_SECOND - game->besttime;
+	cells[2] = "1+---";
+    }
+    if (game->sgflags & SGF_REPLACEABLE) {
+	cells[3] = "1.*BAD*";
+	return 4;
+    }
+
+    if (leveltime < 0)
+	n = -(-leveltime / TICKS_PER_SECOND);
+    else
+	n = (leveltime + TICKS_PER_SECOND - 1) / TICKS_PER_SECOND;
+    if (!t->showpartial) {
+	cells[3] = cell(3, "1+%s", decimal(n, t->zchar));
+	return 4;
+    }
+    strcpy(secs, decimal(n, t->zchar));
+    f = modf((double)leveltime / TICKS_PER_SECOND, &i);
+    f = f <= 0 ? -f : 1.0 - f;
+    n = (int)(f * t->showpartial + 0.49);
+    cells[3] = cell(3, "1+%s - .%s", secs,
+		    decimal(t->showpartial + n, t->zchar) + 1);
+    return 4;
+}
+
+/* Allocate the data for a table with room for a row for every level
+ * in the series.
+ */
+static scoretable *newscoretable(gameseries const *series, char zchar)
+{
+    scoretable *t;
+
+    t = (scoretable*)malloc(sizeof *t);
+    if (!t)
+	memerrexit();
+    t->levels = (int*)malloc((series->count + 1) * sizeof *t->levels);
+    if (!t->levels)
+	memerrexit();
+    t->series = series;
+    t->count = 0;
+    t->total = 0;
+    t->showpartial = 0;
+    t->usepasswds = FALSE;
+    t->zchar = zchar;
+    return t;
+}
+
 /* Produce a table that displays the user's score, broken down by
  * levels with a grand total at the end. If usepasswds is FALSE, all
  * levels are displayed. Otherwise, levels after the last level for
  * which the user knows the password are left out. Other levels for
  * which the user doesn't know the password are in the table, but
- * without any information besides the level's number.
+ * without any information besides the level's number. Only the total
+ * is calculated here; the rows are formatted as they are displayed.
  */
 int createscorelist(gameseries const *series, int usepasswds, char zchar,
 		    int **plevellist, int *pcount, tablespec *table)
 {
-    gamesetup  *game;
-    char const **ptrs;
-    char       *textheap;
-    char       *blank;
-    int	       *levellist = nullptr;
-    int		levelscore, timescore;
-    long	totalscore;
-    int		count;
-    int		used, j, n;
-
-    if (plevellist) {
-	    levellist = (int*)malloc((series->count + 2) * sizeof *levellist);
-	if (!levellist)
-	    memerrexit();
-    }
-    ptrs = (char const **)malloc((series->count + 2) * 5 * sizeof *ptrs);
-    textheap = (char*)malloc((series->count + 2) * 128);
-    if (!ptrs || !textheap)
-	memerrexit();
-    totalscore = 0;
-
-    n = 0;
-    used = 0;
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Level");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1-Name");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Base");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Bonus");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Score");
-
-    blank = textheap + used;
-    used += 1 + sprintf(textheap + used, "4- ");
+    gamesetup const    *game;
+    scoretable	       *t;
+    int		       *levellist = nullptr;
+    int			count, j;
 
+    t = newscoretable(series, zchar);
+    t->usepasswds = usepasswds;
     count = 0;
     for (j = 0, game = series->games ; j < series->count ; ++j, ++game) {
 	if (j >= series->allocated)
 	    break;
-
-	ptrs[n++] = textheap + used;
-	used += 1 + sprintf(textheap + used, "1+%s",
-			    decimal(game->number, zchar));
+	t->levels[t->count++] = j;
 	if (hassolution(game)) {
-	    ptrs[n++] = textheap + used;
-	    used += 1 + sprintf(textheap + used, "1-%.64s", game->name);
-	    if (game->sgflags & SGF_REPLACEABLE) {
-		ptrs[n++] = textheap + used;
-		used += 1 + sprintf(textheap + used, "3.*BAD*");
-	    } else {
-		levelscore = 500 * game->number;
-		ptrs[n++] = textheap + used;
-		used += 1 + sprintf(textheap + used, "1+%s",
-				    cdecimal(levelscore, zchar));
-		ptrs[n++] = textheap + used;
-		if (game->time) {
-		    timescore = 10 * (game->time
+	    if (!(game->sgflags & SGF_REPLACEABLE)) {
+		t->total += 500 * game->number;
+		if (game->time)
+		    t->total += 10 * (game->time
 					- game->besttime / TICKS_PER_SECOND);
-		    used += 1 + sprintf(textheap + used, "1+%s",
-					cdecimal(timescore, zchar));
-		} else {
-		    timescore = 0;
-		    strcpy(textheap + used, "1+---");
-		    used += 6;
-		}
-		ptrs[n++] = textheap + used;
-		used += 1 + sprintf(textheap + used, "1+%s",
-				    cdecimal(levelscore + timescore, zchar));
-		totalscore += levelscore + timescore;
-	    }
-	    if (plevellist)
-		levellist[count] = j;
-	    ++count;
-	} else {
-	    if (!usepasswds || (game->sgflags & SGF_HASPASSWD)) {
-		ptrs[n++] = textheap + used;
-		used += 1 + sprintf(textheap + used, "4-%s", game->name);
-		if (plevellist)
-		    levellist[count] = j;
-	    } else {
-		ptrs[n++] = blank;
-		if (plevellist)
-		    levellist[count] = -1;
 	    }
-	    ++count;
+	} else if (usepasswds && !(game->sgflags & SGF_HASPASSWD)) {
+	    continue;
 	}
+	count = t->count;
     }
+    t->count = count;
 
-    while (ptrs[n - 1] == blank) {
-	n -= 2;
-	--count;
-    }
-
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "2-Total Score");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "3+%s", cdecimal(totalscore, zchar));
-    if (plevellist)
+    if (plevellist) {
+	levellist = (int*)malloc((count + 1) * sizeof *levellist);
+	if (!levellist)
+	    memerrexit();
+	for (j = 0 ; j < count ; ++j) {
+	    game = series->games + t->levels[j];
+	    if (usepasswds && !hassolution(game)
+			   && !(game->sgflags & SGF_HASPASSWD))
+		levellist[j] = -1;
+	    else
+		levellist[j] = t->levels[j];
+	}
 	levellist[count] = -1;
-    ++count;
-
-    if (plevellist)
 	*plevellist = levellist;
+    }
     if (pcount)
-	*pcount = count;
+	*pcount = count + 1;
 
-    table->rows = count + 1;
+    table->rows = count + 2;
     table->cols = 5;
     table->sep = 2;
     table->collapse = 1;
-    table->items = ptrs;
+    table->items = nullptr;
+    table->getrow = getscorerow;
+    table->source = t;
 
     return TRUE;
 }
@@ -230,99 +319,42 @@ int createscorelist(gameseries const *series, int usepasswds, char zchar,
 /* Produce a table that displays the user's best times for each level
  * that has a solution. If showpartial is zero, times are rounded down
  * to second precision, otherwise fractional values will be
- * calculated.
+ * calculated. The rows are formatted as they are displayed.
  */
 int createtimelist(gameseries const *series, int showpartial, char zchar,
 		   int **plevellist, int *pcount, tablespec *table)
 {
-    gamesetup	       *game;
-    char const	      **ptrs;
-    char	       *textheap;
-    char	       *untimed;
-    int		       *levellist = nullptr;
-    long		leveltime;
-    int			count;
-    int			used, secs, j, n;
+    gamesetup const    *game;
+    scoretable	       *t;
+    int		       *levellist;
+    int			j;
 
-    if (plevellist) {
-	levellist = (int*)malloc((series->count + 1) * sizeof *levellist);
-	if (!levellist)
-	    memerrexit();
-    }
-    ptrs = (char const **)malloc((series->count + 1) * 4 * sizeof *ptrs);
-    textheap = (char *)malloc((series->count + 1) * 128);
-    if (!ptrs || !textheap)
-	memerrexit();
-
-    n = 0;
-    used = 0;
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Level");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1-Name");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Time");
-    ptrs[n++] = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+Solution");
-
-    untimed = textheap + used;
-    used += 1 + sprintf(textheap + used, "1+---");
-
-    count = 0;
+    t = newscoretable(series, zchar);
+    t->showpartial = showpartial;
     for (j = 0, game = series->games ; j < series->count ; ++j, ++game) {
 	if (j >= series->allocated)
 	    break;
-	if (!hassolution(game))
-	    continue;
-	ptrs[n++] = textheap + used;
-	used += 1 + sprintf(textheap + used, "1+%s",
-			    decimal(game->number, zchar));
-	ptrs[n++] = textheap + used;
-	used += 1 + sprintf(textheap + used, "1-%.64s", game->name);
-	if (game->time) {
-	    leveltime = game->time * TICKS_PER_SECOND - game->besttime;
-	    ptrs[n++] = textheap + used;
-	    used += 1 + sprintf(textheap + used, "1+%s",
-				decimal(game->time, zchar));
-	} else {
-	    leveltime = 999 * TICKS_PER_SECOND - game->besttime;
-	    ptrs[n++] = untimed;
-	}
-	if (game->sgflags & SGF_REPLACEABLE) {
-	    ptrs[n++] = textheap + used;
-	    used += 1 + sprintf(textheap + used, "1.*BAD*");
-	} else {
-	    if (leveltime < 0)
-		secs = -(-leveltime / TICKS_PER_SECOND);
-	    else
-		secs = (leveltime + TICKS_PER_SECOND - 1) / TICKS_PER_SECOND;
-	    ptrs[n++] = textheap + used;
-	    used += 1 + sprintf(textheap + used, "1+%s", decimal(secs, zchar));
-	    if (showpartial) {
-		double f, i;
-		f = modf((double)leveltime / TICKS_PER_SECOND, &i);
-		f = f <= 0 ? -f : 1.0 - f;
-		secs = (int)(f * showpartial + 0.49);
-		--used;
-		used += 1 + sprintf(textheap + used, " - .%s",
-				    decimal(showpartial + secs, zchar) + 1);
-	    }
-	}
-	if (plevellist)
-	    levellist[count] = j;
-	++count;
+	if (hassolution(game))
+	    t->levels[t->count++] = j;
     }
 
-    if (plevellist)
+    if (plevellist) {
+	levellist = (int*)malloc((t->count + 1) * sizeof *levellist);
+	if (!levellist)
+	    memerrexit();
+	memcpy(levellist, t->levels, t->count * sizeof *levellist);
 	*plevellist = levellist;
+    }
     if (pcount)
-	*pcount = count;
+	*pcount = t->count;
 
-    table->rows = count + 1;
+    table->rows = t->count + 1;
     table->cols = 4;
     table->sep = 2;
     table->collapse = 1;
-    table->items = ptrs;
+    table->items = nullptr;
+    table->getrow = gettimerow;
+    table->source = t;
 
     return TRUE;
 }
@@ -331,10 +363,14 @@ int createtimelist(gameseries const *series, int showpartial, char zchar,
  */
 void freescorelist(int *levellist, tablespec *table)
 {
+    scoretable *t;
+
     free(levellist);
-    if (table) {
-	free((void*)table->items[0]);
-	free(table->items);
+    if (table && table->source) {
+	t = (scoretable*)table->source;
+	free(t->levels);
+	free(t);
+	table->source = nullptr;
     }
 }
 
@@ -161,6 +161,110 @@ static unsigned long hashvalue(unsigned char const *data, unsigned int size)
     return accum ^ 0xFFFFFFFFUL;
 }
 
+/*
+ * Storing the level names.
+ */
+
+/* The size of each block of text in a name pool. A level's name can
+ * be no longer than 255 bytes, so one always fits in a fresh block.
+ */
+#define	NAMECHUNK_SIZE		8192
+
+/* A block of text holding some of the level names.
+ */
+typedef	struct namechunk {
+    struct namechunk   *next;		/* the previously filled block */
+    int			used;		/* amount of text in this block */
+    char		text[NAMECHUNK_SIZE];
+} namechunk;
+
+/* The level names of one series. Each distinct name is stored once,
+ * and the blocks are never moved, so the levels can point directly
+ * into them. A hash table indexes the names that have been stored.
+ */
+struct namepool {
+    namechunk	       *chunks;		/* the most recent block of text */
+    char const	      **index;		/* open-addressed table of names */
+    int			indexsize;	/* size of index (a power of two) */
+    int			count;		/* number of names stored */
+};
+
+/* Return a stored copy of the given name, adding it to the series'
+ * pool if it is not already there.
+ */
+static char const *internname(gameseries *series, char const *name, int size)
+{
+    struct namepool    *pool;
+    namechunk	       *chunk;
+    char const	      **index;
+    char	       *text;
+    int			i, n;
+
+    if (!size)
+	return "";
+    if (!series->names) {
+	if (!(series->names = calloc(1, sizeof *series->names)))
+	    memerrexit();
+    }
+    pool = series->names;
+
+    if (pool->count * 2 >= pool->indexsize) {
+	index = pool->index;
+	n = pool->indexsize;
+	pool->indexsize = n ? n * 2 : 256;
+	pool->index = NULL;
+	x_alloc(pool->index, pool->indexsize * sizeof *pool->index);
+	memset(pool->index, 0, pool->indexsize * sizeof *pool->index);
+	while (n--) {
+	    if (!index[n])
+		continue;
+	    i = hashvalue((unsigned char const*)index[n], strlen(index[n]));
+	    for (i &= pool->indexsize - 1 ; pool->index[i] ;
+					    i = (i + 1) & (pool->indexsize - 1)) ;
+	    pool->index[i] = index[n];
+	}
+	free(index);
+    }
+
+    i = hashvalue((unsigned char const*)name, size) & (pool->indexsize - 1);
+    for ( ; pool->index[i] ; i = (i + 1) & (pool->indexsize - 1))
+	if (!strncmp(pool->index[i], name, size) && !pool->index[i][size])
+	    return pool->index[i];
+
+    chunk = pool->chunks;
+    if (!chunk || chunk->used + size + 1 > NAMECHUNK_SIZE) {
+	if (!(chunk = malloc(sizeof *chunk)))
+	    memerrexit();
+	chunk->next = pool->chunks;
+	chunk->used = 0;
+	pool->chunks = chunk;
+    }
+    text = chunk->text + chunk->used;
+    memcpy(text, name, size);
+    text[size] = '\0';
+    chunk->used += size + 1;
+    pool->index[i] = text;
+    ++pool->count;
+    return text;
+}
+
+/* Free the series' level names.
+ */
+static void freenames(gameseries *series)
+{
+    namechunk  *chunk;
+
+    if (!series->names)
+	return;
+    while ((chunk = series->names->chunks)) {
+	series->names->chunks = chunk->next;
+	free(chunk);
+    }
+    free(series->names->index);
+    free(series->names);
+    series->names = NULL;
+}
+
 /*
  * Reading the data file.
  */
@@ -200,9 +304,10 @@ static int readseriesheader(gameseries *series)
 }
 
 /* Read a single level out of the given data file. The level's name,
- * password, and time limit are extracted from the data.
+ * password, and time limit are extracted from the data, and the name
+ * is added to the series' pool.
  */
-static int readleveldata(fileinfo *file, gamesetup *game)
+static int readleveldata(fileinfo *file, gameseries *series, gamesetup *game)
 {
     unsigned char	       *data;
     unsigned char const	       *dataend;
@@ -228,6 +333,7 @@ static int readleveldata(fileinfo *file, gamesetup *game)
 	goto badlevel;
     game->time = data[2] | (data[3] << 8);
     game->besttime = TIME_NIL;
+    game->name = "";
     game->passwd[0] = '\0';
     data += data[8] | (data[9] << 8);
     data += 10;
@@ -252,8 +358,9 @@ static int readleveldata(fileinfo *file, gamesetup *game)
 		game->time = data[0] | (data[1] << 8);
 	    break;
 	  case 3:
-	    memcpy(game->name, data, size);
-	    game->name[size] = '\0';
+	    n = memchr(data, '\0', size) ? (int)strlen((char const*)data)
+					 : size;
+	    game->name = internname(series, (char const*)data, n);
 	    break;
 	  case 6:
 	    for (n = 0 ; n < size && n < 15 && data[n] ; ++n)
@@ -371,7 +478,7 @@ int readseriesfile(gameseries *series)
     series->allocated = series->count;
     n = 0;
     while (n < series->count && !filetestend(&series->mapfile)) {
-	if (readleveldata(&series->mapfile, series->games + n))
+	if (readleveldata(&series->mapfile, series, series->games + n))
 	    ++n;
 	else
 	    --series->count;
@@ -413,6 +520,7 @@ void freeseriesdata(gameseries *series)
     series->games = NULL;
     series->allocated = 0;
     series->count = 0;
+    freenames(series);
 
     series->ruleset = Ruleset_None;
     series->gsflags = 0;
@@ -551,6 +659,7 @@ static int getseriesfile(char const *filename, void *data)
     series->final = 0;
     series->ruleset = Ruleset_None;
     series->games = NULL;
+    series->names = NULL;
     sprintf(series->filebase, "%.*s", (int)(sizeof series->filebase - 1),
                                       filename);
     sprintf(series->name, "%.*s", (int)(sizeof series->name - 1),
@@ -742,6 +851,7 @@ static gameseries* createnewseries
     series->final = 0;
     series->ruleset = ruleset;
     series->games = NULL;
+    series->names = NULL;
     sprintf(series->filebase, "%.*s", (int)(sizeof series->filebase - 1),
 				      newdacname);
     sprintf(series->name, "%.*s", (int)(sizeof series->name - 1),
@@ -980,6 +1090,7 @@ int createserieslist(char const *preferredfile, gameseries **pserieslist,
     table->sep = 2;
     table->collapse = 0;
     table->items = ptrs;
+    table->getrow = NULL;
     return TRUE;
 }
 
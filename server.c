@@ -0,0 +1,533 @@
+/* server.c: A long-running server for verifying solutions.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<stdarg.h>
+#include	<string.h>
+#include	"defs.h"
+#include	"err.h"
+#include	"fileio.h"
+#include	"series.h"
+#include	"solution.h"
+#include	"play.h"
+#include	"server.h"
+
+#ifdef WIN32
+
+int runverifyserver(char const *path, gameseries *list, int count)
+{
+    (void)list;
+    (void)count;
+    errmsg(path, "the verification server is not available on this system");
+    return FALSE;
+}
+
+#else
+
+#include	<errno.h>
+#include	<signal.h>
+#include	<poll.h>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/types.h>
+#include	<sys/socket.h>
+#include	<sys/un.h>
+#include	<sys/wait.h>
+
+/* The largest solution file that a client may send.
+ */
+#define	MAX_REQUEST_SIZE	(16 * 1024 * 1024)
+
+/* The most output that may wait for a client before it is assumed to
+ * have stopped reading.
+ */
+#define	MAX_PENDING_OUTPUT	(4 * 1024 * 1024)
+
+/* The input received so far from one connected client, and the output
+ * that has yet to be sent to it.
+ */
+typedef	struct client {
+    int			fd;		/* the client's socket */
+    char	       *buf;		/* data not yet handled */
+    int			used;		/* amount of data in buf */
+    int			allocated;	/* size of buf */
+    char	       *out;		/* data not yet sent */
+    int			outused;	/* amount of data in out */
+    int			outallocated;	/* size of out */
+    int			closing;	/* TRUE once no more input is wanted */
+    int			waiting;	/* TRUE if a request awaits a worker */
+    pid_t		worker;		/* the process verifying a request */
+    int			results;	/* the pipe from the worker, or -1 */
+} client;
+
+/* The connected clients. The array is parallel to the poll list,
+ * which has the listening socket in front.
+ */
+static client	       *clients = NULL;
+static struct pollfd   *pollfds = NULL;
+static int		clientcount = 0;
+static int		clientsallocated = 0;
+
+/* The number of worker processes running, and the most that may run
+ * at once.
+ */
+static int		workercount = 0;
+static int		maxworkers = 1;
+
+/* Write as much of the client's pending output as its socket will
+ * take without blocking. FALSE is returned if the client has gone
+ * away.
+ */
+static int flushclient(client *c)
+{
+    int	n, done = 0;
+
+    while (done < c->outused) {
+	n = (int)write(c->fd, c->out + done, c->outused - done);
+	if (n < 0) {
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    return FALSE;
+	}
+	done += n;
+    }
+    c->outused -= done;
+    memmove(c->out, c->out + done, c->outused);
+    return TRUE;
+}
+
+/* Add text to the client's pending output. FALSE is returned if the
+ * client has let too much output pile up.
+ */
+static int sendtext(client *c, char const *text, int size)
+{
+    if (c->outused + size > MAX_PENDING_OUTPUT)
+	return FALSE;
+    if (c->outallocated < c->outused + size) {
+	c->outallocated = c->outused + size + 4096;
+	x_alloc(c->out, c->outallocated);
+    }
+    memcpy(c->out + c->outused, text, size);
+    c->outused += size;
+    return TRUE;
+}
+
+/* Format a line of text and send it to the client.
+ */
+static int sendline(client *c, char const *fmt, ...)
+{
+    char	buf[256];
+    va_list	args;
+    int		n;
+
+    va_start(args, fmt);
+    n = vsnprintf(buf, sizeof buf - 1, fmt, args);
+    va_end(args);
+    if (n < 0 || n > (int)sizeof buf - 2)
+	n = sizeof buf - 2;
+    buf[n++] = '\n';
+    return sendtext(c, buf, n);
+}
+
+/* Find the named series. NULL is returned if there is no such series.
+ */
+static gameseries *findseries(gameseries *list, int count, char const *name)
+{
+    int	i;
+
+    for (i = 0 ; i < count ; ++i)
+	if (!strcmp(list[i].name, name) || !strcmp(list[i].filebase, name))
+	    return list + i;
+    return NULL;
+}
+
+/* Verify every solution in the given solution file data, and send the
+ * results to the client. The levels' own solutions are discarded
+ * beforehand, so nothing from earlier requests can leak into the
+ * results.
+ */
+static int verifyrequest(client *c, gameseries *series,
+			 char *data, int size)
+{
+    fileinfo	file;
+    gamesetup  *game;
+    verifyinfo	info;
+    int		valid = 0, invalid = 0;
+    int		i, f;
+
+    info.ontick = NULL;
+    clearsolutions(series);
+    series->gsflags &= ~GSF_NOSAVING;
+    clearfileinfo(&file);
+    file.name = series->name;
+    file.fp = fmemopen(data, size, "rb");
+    if (!file.fp)
+	return sendline(c, "ERROR %s", strerror(errno));
+    f = readsolutionsfromfile(series, &file);
+    fclose(file.fp);
+    if (!f) {
+	clearsolutions(series);
+	return sendline(c, "ERROR invalid solution file");
+    }
+
+    for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
+	f = verifysolution(game, series->ruleset, &info);
+	if (f < 0)
+	    continue;
+	if (f)
+	    ++valid;
+	else
+	    ++invalid;
+	if (!sendline(c, "%d %s %d", game->number,
+				      f ? "valid" : "invalid", info.ticks)) {
+	    clearsolutions(series);
+	    return FALSE;
+	}
+    }
+    clearsolutions(series);
+    return sendline(c, "OK %d %d", valid, invalid);
+}
+
+/* Write all of the given data to a descriptor. FALSE is returned if
+ * the data could not be written.
+ */
+static int writeall(int fd, char const *data, int size)
+{
+    int	n;
+
+    while (size > 0) {
+	n = (int)write(fd, data, size);
+	if (n < 0) {
+	    if (errno == EINTR)
+		continue;
+	    return FALSE;
+	}
+	data += n;
+	size -= n;
+    }
+    return TRUE;
+}
+
+/* Verify a request in a separate process, which sends its results
+ * back through a pipe. The worker starts with the server's copy of
+ * the level set, so the set is only read once and nothing the worker
+ * does can affect later requests. If no process can be started, the
+ * request is verified here instead. FALSE is returned if the
+ * connection should be closed.
+ */
+static int startworker(client *c, gameseries *series, char *data, int size)
+{
+    pid_t	pid;
+    int		fds[2];
+    int		i, f;
+
+    if (pipe(fds) < 0)
+	return verifyrequest(c, series, data, size);
+    pid = fork();
+    if (pid < 0) {
+	close(fds[0]);
+	close(fds[1]);
+	return verifyrequest(c, series, data, size);
+    }
+    if (pid == 0) {
+	close(fds[0]);
+	for (i = 0 ; i < clientcount ; ++i) {
+	    close(clients[i].fd);
+	    if (clients[i].results >= 0)
+		close(clients[i].results);
+	}
+	c->outused = 0;
+	f = verifyrequest(c, series, data, size);
+	_exit(f && writeall(fds[1], c->out, c->outused) ? EXIT_SUCCESS
+						       : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    c->worker = pid;
+    c->results = fds[0];
+    ++workercount;
+    return TRUE;
+}
+
+/* Wait for a client's worker to exit, first killing it if abandon is
+ * TRUE. FALSE is returned if the worker did not finish its request.
+ */
+static int endworker(client *c, int abandon)
+{
+    int	status = 0;
+
+    if (abandon)
+	kill(c->worker, SIGKILL);
+    close(c->results);
+    while (waitpid(c->worker, &status, 0) < 0 && errno == EINTR) ;
+    c->worker = 0;
+    c->results = -1;
+    --workercount;
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/* Carry out every complete request in the client's buffer, stopping
+ * when a request has been handed to a worker. FALSE is returned if
+ * the connection should be closed.
+ */
+static int handleinput(client *c, gameseries *list, int count)
+{
+    gameseries *series;
+    char       *eol;
+    char	name[256];
+    int		size, n;
+
+    c->waiting = FALSE;
+    for (;;) {
+	if (c->worker)
+	    return TRUE;
+	eol = memchr(c->buf, '\n', c->used);
+	if (!eol) {
+	    if (c->used < 1024)
+		return TRUE;
+	    sendline(c, "ERROR line too long");
+	    return FALSE;
+	}
+	*eol = '\0';
+	n = eol + 1 - c->buf;
+	if (sscanf(c->buf, "VERIFY %255s %d", name, &size) != 2
+				|| size < 0 || size > MAX_REQUEST_SIZE) {
+	    sendline(c, "ERROR bad request");
+	    return FALSE;
+	}
+	if (c->used - n < size) {
+	    *eol = '\n';
+	    if (c->allocated < n + size) {
+		c->allocated = n + size;
+		x_alloc(c->buf, c->allocated);
+	    }
+	    return TRUE;
+	}
+	series = findseries(list, count, name);
+	if (!series) {
+	    if (!sendline(c, "ERROR unknown level set %s", name))
+		return FALSE;
+	} else if (!readseriesfile(series)) {
+	    if (!sendline(c, "ERROR cannot read level set %s", name))
+		return FALSE;
+	} else if (workercount >= maxworkers) {
+	    *eol = '\n';
+	    c->waiting = TRUE;
+	    return TRUE;
+	} else if (!startworker(c, series, eol + 1, size)) {
+	    return FALSE;
+	}
+	n += size;
+	c->used -= n;
+	memmove(c->buf, c->buf + n, c->used);
+    }
+}
+
+/* Add a newly connected client to the list. Its socket is made
+ * non-blocking, so that a client that does not read its results
+ * cannot stall the server.
+ */
+static void addclient(int fd)
+{
+    int	flags;
+
+    flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+	close(fd);
+	return;
+    }
+    if (clientcount >= clientsallocated) {
+	clientsallocated = clientsallocated ? clientsallocated * 2 : 16;
+	x_alloc(clients, clientsallocated * sizeof *clients);
+	x_alloc(pollfds, (2 * clientsallocated + 1) * sizeof *pollfds);
+    }
+    clients[clientcount].fd = fd;
+    clients[clientcount].buf = NULL;
+    clients[clientcount].used = 0;
+    clients[clientcount].allocated = 0;
+    clients[clientcount].out = NULL;
+    clients[clientcount].outused = 0;
+    clients[clientcount].outallocated = 0;
+    clients[clientcount].closing = FALSE;
+    clients[clientcount].waiting = FALSE;
+    clients[clientcount].worker = 0;
+    clients[clientcount].results = -1;
+    ++clientcount;
+}
+
+/* Disconnect a client and remove it from the list.
+ */
+static void removeclient(int i)
+{
+    if (clients[i].worker)
+	endworker(clients + i, TRUE);
+    close(clients[i].fd);
+    free(clients[i].buf);
+    free(clients[i].out);
+    --clientcount;
+    clients[i] = clients[clientcount];
+}
+
+/* Read whatever the client has sent. FALSE is returned if the client
+ * has disconnected. After an invalid request, the client is marked as
+ * closing, so that it can be sent the error before it is dropped.
+ */
+static int readclient(client *c, gameseries *list, int count)
+{
+    int	n;
+
+    if (c->allocated - c->used < 4096) {
+	c->allocated = c->used + 65536;
+	x_alloc(c->buf, c->allocated);
+    }
+    n = (int)read(c->fd, c->buf + c->used, c->allocated - c->used);
+    if (n < 0)
+	return errno == EINTR || errno == EAGAIN;
+    if (n == 0)
+	return FALSE;
+    c->used += n;
+    if (!handleinput(c, list, count))
+	c->closing = TRUE;
+    return TRUE;
+}
+
+/* Pass on the output of a client's worker. Once the worker is done,
+ * the client's remaining requests are taken up again. FALSE is
+ * returned if the connection should be closed.
+ */
+static int readresults(client *c, gameseries *list, int count)
+{
+    char	buf[4096];
+    int		n;
+
+    for (;;) {
+	n = (int)read(c->results, buf, sizeof buf);
+	if (n > 0) {
+	    if (!sendtext(c, buf, n))
+		return FALSE;
+	    continue;
+	}
+	if (n < 0 && errno == EINTR)
+	    continue;
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	    return TRUE;
+	break;
+    }
+    if (!endworker(c, FALSE)) {
+	sendline(c, "ERROR verification failed");
+	return FALSE;
+    }
+    return handleinput(c, list, count);
+}
+
+/* Handle the events that poll() reported for a client and for its
+ * worker. FALSE is returned if the client should be removed.
+ */
+static int serviceclient(client *c, int revents, int resultevents,
+			 gameseries *list, int count)
+{
+    if (resultevents && c->worker && !c->closing)
+	if (!readresults(c, list, count))
+	    c->closing = TRUE;
+    if ((revents & POLLIN) && !c->closing)
+	if (!readclient(c, list, count))
+	    return FALSE;
+    if (revents & (POLLERR | POLLNVAL))
+	return FALSE;
+    if ((revents & POLLHUP) && !(revents & POLLIN))
+	return FALSE;
+    if (!flushclient(c))
+	return FALSE;
+    return !c->closing || c->outused > 0;
+}
+
+/* Listen on the given socket path, and answer requests for as long as
+ * the program runs. Input and output for every client is handled
+ * here, so a slow client cannot hold up the others, while the
+ * solutions themselves are played back in worker processes, up to
+ * one per processor. Requests that arrive when every worker is busy
+ * wait for one to finish. A client's next request is not read until
+ * the results of the previous ones have been sent.
+ */
+int runverifyserver(char const *path, gameseries *list, int count)
+{
+    struct sockaddr_un	addr;
+    int			sock, fd, i, n;
+
+    if (strlen(path) >= sizeof addr.sun_path) {
+	errmsg(path, "socket path is too long");
+	return FALSE;
+    }
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+	errmsg(path, "cannot create socket: %s", strerror(errno));
+	return FALSE;
+    }
+    unlink(path);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof addr) < 0
+			|| listen(sock, 64) < 0) {
+	errmsg(path, "cannot listen on socket: %s", strerror(errno));
+	close(sock);
+	return FALSE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    batchmode = TRUE;
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    maxworkers = n > 0 ? n : 1;
+
+    x_alloc(pollfds, sizeof *pollfds);
+    for (;;) {
+	for (i = 0 ; i < clientcount && workercount < maxworkers ; ++i)
+	    if (clients[i].waiting && !clients[i].closing)
+		if (!handleinput(clients + i, list, count))
+		    clients[i].closing = TRUE;
+	pollfds[0].fd = sock;
+	pollfds[0].events = POLLIN;
+	for (i = 0 ; i < clientcount ; ++i) {
+	    pollfds[2 * i + 1].fd = clients[i].fd;
+	    if (clients[i].outused)
+		pollfds[2 * i + 1].events = POLLOUT;
+	    else if (clients[i].worker || clients[i].waiting)
+		pollfds[2 * i + 1].events = 0;
+	    else
+		pollfds[2 * i + 1].events = POLLIN;
+	    pollfds[2 * i + 2].fd = clients[i].results;
+	    pollfds[2 * i + 2].events = POLLIN;
+	}
+	n = poll(pollfds, 2 * clientcount + 1, -1);
+	if (n < 0) {
+	    if (errno == EINTR)
+		continue;
+	    errmsg(path, "poll failed: %s", strerror(errno));
+	    break;
+	}
+	for (i = clientcount - 1 ; i >= 0 ; --i)
+	    if (pollfds[2 * i + 1].revents || pollfds[2 * i + 2].revents)
+		if (!serviceclient(clients + i, pollfds[2 * i + 1].revents,
+				   pollfds[2 * i + 2].revents, list, count))
+		    removeclient(i);
+	if (pollfds[0].revents & POLLIN) {
+	    fd = accept(sock, NULL, NULL);
+	    if (fd >= 0)
+		addclient(fd);
+	}
+    }
+
+    while (clientcount)
+	removeclient(clientcount - 1);
+    close(sock);
+    unlink(path);
+    return FALSE;
+}
+
+#endif
@@ -0,0 +1,35 @@
+/* server.h: A long-running server for verifying solutions.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef	HEADER_server_h_
+#define	HEADER_server_h_
+
+#include	"defs.h"
+
+/* Listen on the Unix domain socket at path, and verify the solution
+ * files that clients send for any of the count series in list. Each
+ * request is a line of the form
+ *
+ *	VERIFY <set name> <size>
+ *
+ * followed by size bytes of solution file data. The reply is a line
+ * per level that has a solution,
+ *
+ *	<level number> valid|invalid <ticks>
+ *
+ * followed by a line "OK <valid count> <invalid count>", or a single
+ * line "ERROR <reason>" if the request could not be carried out. A
+ * client may send any number of requests over one connection, which
+ * are answered in order. Requests from different clients are verified
+ * concurrently, each in a worker process of its own, with up to one
+ * worker per processor. Level sets are read the first time they are
+ * named, and then kept in memory, where every worker shares them. The
+ * function only returns if the server cannot be started, in which
+ * case the return value is FALSE.
+ */
+extern int runverifyserver(char const *path, gameseries *list, int count);
+
+#endif
@@ -0,0 +1,89 @@
+/* snapshot.c: Saving copies of game state that share unchanged pages.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#include	<stdlib.h>
+#include	<string.h>
+#include	"err.h"
+#include	"snapshot.h"
+
+/* One page of saved memory. Only the last page of a region can be
+ * partly used.
+ */
+struct statepage {
+    int			refcount;		/* saved regions using it */
+    unsigned char	data[STATEPAGESIZE];	/* the saved bytes */
+};
+
+/* The number of pages needed to hold size bytes.
+ */
+#define	pagecount(size)		(((size) + STATEPAGESIZE - 1) / STATEPAGESIZE)
+
+/* Save a copy of a region, sharing the pages that still match base.
+ * The comparison only looks at the bytes that the new copy needs, so
+ * a base of a different size can still share its leading pages.
+ */
+void savestateregion(stateregion *copy, void const *data, int size,
+		     stateregion const *base)
+{
+    unsigned char const	       *p = data;
+    statepage		       *page;
+    int				basecount, count, len, i;
+
+    count = pagecount(size);
+    basecount = base ? pagecount(base->size) : 0;
+    copy->size = size;
+    copy->pages = NULL;
+    if (!count)
+	return;
+    x_alloc(copy->pages, count * sizeof *copy->pages);
+    for (i = 0 ; i < count ; ++i, p += STATEPAGESIZE) {
+	len = size - i * STATEPAGESIZE;
+	if (len > STATEPAGESIZE)
+	    len = STATEPAGESIZE;
+	if (i < basecount && !memcmp(base->pages[i]->data, p, len)) {
+	    page = base->pages[i];
+	} else {
+	    page = malloc(sizeof *page);
+	    if (!page)
+		memerrexit();
+	    page->refcount = 0;
+	    memcpy(page->data, p, len);
+	}
+	++page->refcount;
+	copy->pages[i] = page;
+    }
+}
+
+/* Copy each page of a saved region back into place.
+ */
+void restorestateregion(stateregion const *copy, void *data)
+{
+    unsigned char      *p = data;
+    int			count, len, i;
+
+    count = pagecount(copy->size);
+    for (i = 0 ; i < count ; ++i, p += STATEPAGESIZE) {
+	len = copy->size - i * STATEPAGESIZE;
+	if (len > STATEPAGESIZE)
+	    len = STATEPAGESIZE;
+	memcpy(p, copy->pages[i]->data, len);
+    }
+}
+
+/* Release each page of a saved region.
+ */
+void freestateregion(stateregion *copy)
+{
+    int	count, i;
+
+    count = pagecount(copy->size);
+    for (i = 0 ; i < count ; ++i)
+	if (!--copy->pages[i]->refcount)
+	    free(copy->pages[i]);
+    free(copy->pages);
+    copy->pages = NULL;
+    copy->size = 0;
+}
@@ -0,0 +1,45 @@
+/* snapshot.h: Saving copies of game state that share unchanged pages.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef	HEADER_snapshot_h_
+#define	HEADER_snapshot_h_
+
+/* The number of bytes in one page of a saved region.
+ */
+#define	STATEPAGESIZE	256
+
+/* One page of saved memory. A page can belong to any number of saved
+ * regions, and is freed when the last of them is.
+ */
+typedef	struct statepage statepage;
+
+/* A saved copy of one region of memory, divided into pages.
+ */
+typedef	struct stateregion {
+    int			size;		/* size of the region in bytes */
+    statepage	      **pages;		/* the pages of the copy */
+} stateregion;
+
+/* Save a copy of the size bytes at data in copy. If base is not NULL,
+ * it should be an earlier copy of the same region. Each page that is
+ * unchanged since base was made is shared with base instead of being
+ * copied, so that the cost in memory of the new copy is proportional
+ * to what has changed.
+ */
+extern void savestateregion(stateregion *copy, void const *data, int size,
+			    stateregion const *base);
+
+/* Copy a saved region back into the memory at data, which must have
+ * room for the whole of it.
+ */
+extern void restorestateregion(stateregion const *copy, void *data);
+
+/* Discard a saved region, freeing any pages that no other saved
+ * region is using.
+ */
+extern void freestateregion(stateregion *copy);
+
+#endif
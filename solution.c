@@ -273,14 +273,14 @@ static int writesolutionsetname(fileinfo *file, char const *setname)
 
 /* Expand a level's solution data into an actual list of moves.
  */
-int expandsolution(solutioninfo *solution, gamesetup const *game)
+int expandsolution(solutioninfo *solution, gamesetup *game)
 {
     unsigned char const	       *dataend;
     unsigned char const	       *p;
     action			act;
     int				n;
 
-    if (game->solutionsize <= 16)
+    if (game->solutionsize <= 16 || !loadsolution(game))
 	return FALSE;
 
     solution->flags = game->solutiondata[6];
@@ -355,6 +355,24 @@ int expandsolution(solutioninfo *solution, gamesetup const *game)
     return FALSE;
 }
 
+/* Return the best time stored in the header of a level's solution
+ * data.
+ */
+int getsolutiontime(unsigned char const *data)
+{
+    return data[12] | (data[13] << 8) | (data[14] << 16) | (data[15] << 24);
+}
+
+/* Store a best time in the header of a level's solution data.
+ */
+static void putsolutiontime(unsigned char *data, int besttime)
+{
+    data[12] = besttime & 0xFF;
+    data[13] = (besttime >> 8) & 0xFF;
+    data[14] = (besttime >> 16) & 0xFF;
+    data[15] = (besttime >> 24) & 0xFF;
+}
+
 /* Take the given solution and compress it, storing the compressed
  * data as part of the level's setup.
  */
@@ -395,10 +413,7 @@ int contractsolution(solutioninfo const *solution, gamesetup *game)
     data[9] = (solution->rndseed >> 8) & 0xFF;
     data[10] = (solution->rndseed >> 16) & 0xFF;
     data[11] = (solution->rndseed >> 24) & 0xFF;
-    data[12] = game->besttime & 0xFF;
-    data[13] = (game->besttime >> 8) & 0xFF;
-    data[14] = (game->besttime >> 16) & 0xFF;
-    data[15] = (game->besttime >> 24) & 0xFF;
+    putsolutiontime(data, game->besttime);
 
     when = -1;
     size = 16;
@@ -470,17 +485,26 @@ int contractsolution(solutioninfo const *solution, gamesetup *game)
  */
 
 /* Read the data of a one complete solution from the given file into
- * the appropriate fields of game.
+ * the appropriate fields of game. A set name record leaves the name in
+ * a static buffer, which is overwritten by the next such record. If
+ * fileend is not zero, it gives the size of the file, and the moves of
+ * the solution are skipped over instead of being read, leaving the
+ * game pointing to where they can be found.
  */
-static int readsolution(fileinfo *file, gamesetup *game)
+static int readsolution(fileinfo *file, gamesetup *game, long fileend)
 {
-    unsigned long	size;
+    static char		setname[256];
+    unsigned char	header[16];
+    unsigned char const *data;
+    unsigned long	size, n;
+    long		offset = 0;
 
     game->number = 0;
     game->sgflags = 0;
     game->besttime = TIME_NIL;
     game->solutionsize = 0;
     game->solutiondata = NULL;
+    game->solutionfile = NULL;
     if (!file->fp)
 	return TRUE;
 
@@ -489,38 +513,57 @@ static int readsolution(fileinfo *file, gamesetup *game)
     if (!size)
 	return TRUE;
     game->solutionsize = size;
-    game->solutiondata = filereadbuf(file, size, "unexpected EOF");
-    if (!game->solutiondata || (size <= 16 && size != 6))
-	return fileerr(file, "invalid data in solution file");
-    game->number = (game->solutiondata[1] << 8) | game->solutiondata[0];
-    memcpy(game->passwd, game->solutiondata + 2, 4);
+    if (fileend && size > 16) {
+	offset = filetell(file, "unexpected EOF");
+	if (offset < 0 || !fileread(file, header, 16, "unexpected EOF"))
+	    return FALSE;
+	if (size > (unsigned long)(fileend - offset))
+	    return fileerr(file, "unexpected EOF");
+	data = header;
+    } else {
+	game->solutiondata = filereadbuf(file, size, "unexpected EOF");
+	if (!game->solutiondata || (size <= 16 && size != 6))
+	    return fileerr(file, "invalid data in solution file");
+	data = game->solutiondata;
+    }
+    game->number = (data[1] << 8) | data[0];
+    memcpy(game->passwd, data + 2, 4);
     game->passwd[5] = '\0';
     game->sgflags |= SGF_HASPASSWD;
     if (size == 6)
 	return TRUE;
 
-    game->besttime = game->solutiondata[12] | (game->solutiondata[13] << 8)
-					    | (game->solutiondata[14] << 16)
-					    | (game->solutiondata[15] << 24);
+    game->besttime = getsolutiontime(data);
     size -= 16;
     if (!game->number && !*game->passwd) {
 	game->sgflags |= SGF_SETNAME;
-	if (size > 255)
-	    size = 255;
-	memcpy(game->name, game->solutiondata + 16, size);
-	game->name[size] = '\0';
+	n = size > sizeof setname - 1 ? sizeof setname - 1 : size;
+	if (game->solutiondata)
+	    memcpy(setname, game->solutiondata + 16, n);
+	else if (!fileread(file, setname, n, "unexpected EOF")
+			|| !fileskip(file, size - n, "unexpected EOF"))
+	    return FALSE;
+	setname[n] = '\0';
+	game->name = setname;
 	free(game->solutiondata);
 	game->solutionsize = 0;
 	game->solutiondata = NULL;
+	return TRUE;
     }
 
+    if (!game->solutiondata) {
+	if (!fileskip(file, size, "unexpected EOF"))
+	    return FALSE;
+	game->solutionfile = file;
+	game->solutionoffset = offset;
+    }
     return TRUE;
 }
 
 /* Write the data of one complete solution from the appropriate fields
  * of game to the given file.
  */
-static int writesolution(fileinfo *file, gamesetup const *game)
+int writesolution(fileinfo *file, gamesetup const *game)
 {
     if (game->solutionsize) {
 	if (!filewriteint32(file, game->solutionsize, "write error")
@@ -585,36 +628,28 @@ static int opensolutionfile(fileinfo *file, char const *datname, int writable)
     return n;
 }
 
-/* Read the saved solution data for the given series into memory.
+/* Read the solution data for the given series from an open file. If
+ * fileend is not zero, only the solutions' headers are read.
  */
-int readsolutions(gameseries *series)
+static int readsolutionrecords(gameseries *series, fileinfo *file,
+			       long fileend)
 {
     gamesetup	gametmp = {0};
     int		n;
 
-    if (!series->savefile.name)
-	series->savefile.name = series->savefilename;
-    if ((!series->savefile.name && (series->gsflags & GSF_NODEFAULTSAVE))
-		|| !opensolutionfile(&series->savefile,
-				     series->filebase, FALSE)) {
-	series->solheaderflags = 0;
-	series->solheadersize = 0;
-	return TRUE;
-    }
-
-    if (!readsolutionheader(&series->savefile, series->ruleset,
+    if (!readsolutionheader(file, series->ruleset,
 			    &series->solheaderflags,
 			    &series->solheadersize, series->solheader))
 	return FALSE;
 
     for (;;) {
-	if (!readsolution(&series->savefile, &gametmp))
+	if (!readsolution(file, &gametmp, fileend))
 	    break;
 	if (gametmp.sgflags & SGF_SETNAME) {
 	    if (strcmp(gametmp.name, series->name)) {
 		errmsg(series->name, "ignoring solution file %s as it was"
 				     " recorded for a different level set: %s",
-		       series->savefile.name, gametmp.name);
+		       file->name, gametmp.name);
 		series->gsflags |= GSF_NOSAVING;
 		return FALSE;
 	    }
@@ -624,8 +659,7 @@ int readsolutions(gameseries *series)
 	if (n < 0) {
 	    n = findlevelinseries(series, 0, gametmp.passwd);
 	    if (n < 0) {
-		fileerr(&series->savefile,
-			"unmatched password in solution file");
+		fileerr(file, "unmatched password in solution file");
 		continue;
 	    }
 	    warn("level %d has been moved to level %d",
@@ -635,12 +669,135 @@ int readsolutions(gameseries *series)
 	series->games[n].sgflags = gametmp.sgflags;
 	series->games[n].solutionsize = gametmp.solutionsize;
 	series->games[n].solutiondata = gametmp.solutiondata;
+	series->games[n].solutionfile = gametmp.solutionfile;
+	series->games[n].solutionoffset = gametmp.solutionoffset;
     }
 
-    fileclose(&series->savefile, NULL);
     return TRUE;
 }
 
+/* Close the file holding the solutions that have not been read in
+ * yet. Any such solutions are lost, so this should only be done after
+ * calling loadsolution() on each one, or when discarding them all.
+ */
+static void closesolutionfile(gameseries *series)
+{
+    fileinfo   *file = NULL;
+    gamesetup  *game;
+    int		n;
+
+    for (n = 0, game = series->games ; n < series->count ; ++n, ++game) {
+	if (game->solutionfile) {
+	    file = game->solutionfile;
+	    game->solutionfile = NULL;
+	}
+    }
+    if (file) {
+	fileclose(file, NULL);
+	free(file);
+    }
+}
+
+/* Read the headers of the saved solutions for the given series. The
+ * file is left open if any solutions remain to be read from it, with
+ * its own copy of the filename, since the series' filename can be
+ * changed out from under it.
+ */
+int readsolutions(gameseries *series)
+{
+    fileinfo   *file = NULL;
+    long	fileend;
+    int		f, n;
+
+    if (!series->savefile.name)
+	series->savefile.name = series->savefilename;
+    if ((!series->savefile.name && (series->gsflags & GSF_NODEFAULTSAVE))
+		|| !opensolutionfile(&series->savefile,
+				     series->filebase, FALSE)) {
+	series->solheaderflags = 0;
+	series->solheadersize = 0;
+	return TRUE;
+    }
+
+    x_alloc(file, sizeof *file);
+    clearfileinfo(file);
+    file->fp = series->savefile.fp;
+    series->savefile.fp = NULL;
+    if (series->savefile.name) {
+	n = strlen(series->savefile.name) + 1;
+	x_alloc(file->name, n);
+	memcpy(file->name, series->savefile.name, n);
+	file->alloc = TRUE;
+    }
+    fileend = fileseek(file, 0, SEEK_END, NULL) ? filetell(file, NULL) : 0;
+    if (fileend < 0)
+	fileend = 0;
+    filerewind(file, NULL);
+
+    f = readsolutionrecords(series, file, fileend);
+    if (f)
+	fileclose(&series->savefile, NULL);
+    for (n = 0 ; n < series->count ; ++n)
+	if (series->games[n].solutionfile == file)
+	    break;
+    if (n == series->count) {
+	fileclose(file, NULL);
+	free(file);
+    }
+    return f;
+}
+
+/* Read the solution data for the given series from an open file.
+ */
+int readsolutionsfromfile(gameseries *series, fileinfo *file)
+{
+    return readsolutionrecords(series, file, 0);
+}
+
+/* Read a level's solution data into memory, if it has not been read
+ * already.
+ */
+int loadsolution(gamesetup *game)
+{
+    unsigned char      *data;
+
+    if (game->solutiondata || !game->solutionsize)
+	return TRUE;
+    if (!game->solutionfile)
+	return FALSE;
+    if (!fileseek(game->solutionfile, game->solutionoffset, SEEK_SET,
+		  "unexpected EOF"))
+	return FALSE;
+    data = filereadbuf(game->solutionfile, game->solutionsize,
+		       "unexpected EOF");
+    if (!data)
+	return FALSE;
+    game->solutiondata = data;
+    return TRUE;
+}
+
+/* Change the best time recorded with a level's solution, both in the
+ * level's setup and in its saved solution data.
+ */
+int setsolutiontime(gamesetup *game, int besttime)
+{
+    if (game->solutionsize <= 16 || !loadsolution(game))
+	return FALSE;
+    game->besttime = besttime;
+    putsolutiontime(game->solutiondata, besttime);
+    return TRUE;
+}
+
+/* Write the header of a solution file for the given series, followed
+ * by the name of the level set.
+ */
+int writesolutionfileheader(fileinfo *file, gameseries const *series)
+{
+    return writesolutionheader(file, series->ruleset, series->solheaderflags,
+			       series->solheadersize, series->solheader)
+	&& writesolutionsetname(file, series->name);
+}
+
 /* Write out all the solutions for the given series.
  */
 int savesolutions(gameseries *series)
@@ -651,6 +808,10 @@ int savesolutions(gameseries *series)
     if (readonly || (series->gsflags & GSF_NOSAVING))
 	return TRUE;
 
+    for (i = 0, game = series->games ; i < series->count ; ++i, ++game)
+	if (!loadsolution(game))
+	    return FALSE;
+    closesolutionfile(series);
     if (series->savefile.fp)
 	fileclose(&series->savefile, NULL);
     if (!series->savefile.name)
@@ -660,12 +821,7 @@ int savesolutions(gameseries *series)
     if (!opensolutionfile(&series->savefile, series->filebase, TRUE))
 	return FALSE;
 
-    if (!writesolutionheader(&series->savefile, series->ruleset,
-			     series->solheaderflags,
-			     series->solheadersize, series->solheader))
-	return fileerr(&series->savefile,
-		       "saved-game file has become corrupted!");
-    if (!writesolutionsetname(&series->savefile, series->name))
+    if (!writesolutionfileheader(&series->savefile, series))
 	return fileerr(&series->savefile,
 		       "saved-game file has become corrupted!");
     for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
@@ -686,6 +842,7 @@ void clearsolutions(gameseries *series)
     gamesetup  *game;
     int		n;
 
+    closesolutionfile(series);
     for (n = 0, game = series->games ; n < series->count ; ++n, ++game) {
 	free(game->solutiondata);
 	game->besttime = TIME_NIL;
@@ -819,6 +976,7 @@ int createsolutionfilelist(gameseries const *series, int morethanone,
     table->cols = 2;
     table->sep = 4;
     table->collapse = 1;
+    table->getrow = NULL;
     table->items[0] = "2-Select a solution file";
     offset = 0;
     for (i = 0 ; i < s.count ; ++i) {
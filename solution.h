@@ -48,7 +48,7 @@ extern void destroymovelist(actlist *list);
  * the full list of moves. FALSE is returned if the solution is
  * invalid or absent.
  */
-extern int expandsolution(solutioninfo *solution, gamesetup const *game);
+extern int expandsolution(solutioninfo *solution, gamesetup *game);
 
 /* Take the given solution and compress it, storing the compressed
  * data as part of the level's setup. FALSE is returned if an error
@@ -56,12 +56,36 @@ extern int expandsolution(solutioninfo *solution, gamesetup const *game);
  */
 extern int contractsolution(solutioninfo const *solution, gamesetup *game);
 
-/* Read all the solutions for the given series into memory. FALSE is
- * returned if an error occurs. Note that it is not an error for the
- * solution file to not exist.
+/* Read the solutions for the given series. Only the number, password
+ * and best time of each solution are read at first, and the file is
+ * kept open so that the moves can be read in by loadsolution() when
+ * they are needed. FALSE is returned if an error occurs. Note that it
+ * is not an error for the solution file to not exist.
  */
 extern int readsolutions(gameseries *series);
 
+/* Read the moves of a level's solution into memory, if readsolutions()
+ * left them in the file. FALSE is returned if they could not be read.
+ */
+extern int loadsolution(gamesetup *game);
+
+/* Return the best time stored in the 16-byte header that begins a
+ * level's solution data.
+ */
+extern int getsolutiontime(unsigned char const *data);
+
+/* Change the best time recorded with a level's solution. FALSE is
+ * returned if the level has no solution or it could not be read.
+ */
+extern int setsolutiontime(gamesetup *game, int besttime);
+
+/* Read the solutions for the given series from file, which has
+ * already been opened, instead of from the series' own solution file.
+ * FALSE is returned if the data is not a valid solution file for the
+ * series.
+ */
+extern int readsolutionsfromfile(gameseries *series, fileinfo *file);
+
 /* Write out all the solutions for the given series. The solution file
  * is created if it does not currently exist. The solution file's
  * directory is also created if it does not currently exist. (Nothing
@@ -70,6 +94,19 @@ extern int readsolutions(gameseries *series);
  */
 extern int savesolutions(gameseries *series);
 
+/* Write the header of a solution file for the given series, using
+ * the series' solution header fields and name. FALSE is returned if
+ * an error occurs.
+ */
+extern int writesolutionfileheader(fileinfo *file, gameseries const *series);
+
+/* Write one level's solution to file as a solution file record. A
+ * level with a known password but no solution is written as a record
+ * of just its number and password, and a level with neither is not
+ * written at all. FALSE is returned if an error occurs.
+ */
+extern int writesolution(fileinfo *file, gamesetup const *game);
+
 /* Free all memory allocated for storing the game's solutions, and mark
  * the levels as being unsolved.
  */
@@ -148,6 +148,31 @@ typedef	struct xyconn {
     short		to;		/* location of the trap/cloner */
 } xyconn;
 
+/* A bitplane holds one bit for each location on the map, with one
+ * word for each row of the map. Whole rows can be tested or combined
+ * at once, and empty rows skipped. (CXGRID must not be larger than the
+ * number of bits in a long.)
+ */
+typedef	unsigned long	bitplane[CYGRID];
+
+/* Macros for getting at the bit for a location in a bitplane.
+ */
+#define	planebit(pos)		(1UL << ((pos) % CXGRID))
+#define	setplanebit(bp, pos)	((bp)[(pos) / CXGRID] |= planebit(pos))
+#define	clearplanebit(bp, pos)	((bp)[(pos) / CXGRID] &= ~planebit(pos))
+
+/* The wiring at one map location, gathered from the trap and cloner
+ * lists so that it can be looked up without searching them. Each
+ * field is -1 if there is nothing to find.
+ */
+typedef	struct cellwiring {
+    short		trap;		/* trap wired to a button here */
+    short		cloner;		/* cloner wired to a button here */
+    short		trapwire;	/* first trap wiring that ends here */
+    short		nexttrap;	/* the next trap in map order */
+    short		nextcloner;	/* the next cloner in map order */
+} cellwiring;
+
 /* A tile on the map.
  */
 typedef struct maptile {
@@ -174,6 +199,7 @@ typedef	struct creature {
     signed int		moving: 5;	/* positional offset of creature */
     signed int		frame : 5;	/* explicit animation index */
     signed int		tdir  : 5;	/* internal state value */
+    signed int		slip  : 16;	/* index on the slip list (MS only) */
 } creature;
 #else
 typedef struct creature {
@@ -185,6 +211,7 @@ typedef struct creature {
     unsigned char	hidden;		/* TRUE if creature is invisible */
     unsigned char	state;		/* internal state value */
     unsigned char	tdir;		/* internal state value */
+    short		slip;		/* index on the slip list (MS only) */
 } creature;
 #endif
 
@@ -199,13 +226,14 @@ struct msstate_ {
     short		goalpos;	/* mouse spot to move Chip towards */
     signed char		xviewoffset;	/* offset of map view center */
     signed char		yviewoffset;	/*   position from position of Chip */
+    bitplane		buttonsdown;	/* locations of deferred presses */
 };
 
 /* Status information specific to the Lynx game logic.
  */
 struct lxstate_ {
-    creature	       *chiptocr;	/* is Chip colliding with a creature */
-    creature	       *crend;		/* near the end of the creature list */
+    short		chiptocr;	/* is Chip colliding with a creature */
+    short		crend;		/* near the end of the creature list */
     short		chiptopos;	/*   just starting to move itself? */
     short		putwall;	/* location to put a wall */
     unsigned char	prng1;		/* the values used to make the */
@@ -253,9 +281,14 @@ typedef struct gamestate {
     short		trapcount;		/* number of trap buttons */
     short		clonercount;		/* number of cloner buttons */
     short		crlistcount;		/* number of creatures */
+    short		teleportcount;		/* number of teleports */
     xyconn		traps[256];		/* list of trap wirings */
     xyconn		cloners[256];		/* list of cloner wirings */
     short		crlist[256];		/* list of creatures */
+    short		trapwirenext[256];	/* next wiring to same trap */
+    cellwiring		wiring[CXGRID * CYGRID]; /* wiring by location */
+    bitplane		switchwalls;		/* toggle wall locations */
+    short		teleports[CXGRID * CYGRID]; /* teleports, in order */
     char		hinttext[256];		/* text of the hint */
     mapcell		map[CXGRID * CYGRID];	/* the game's map */
 
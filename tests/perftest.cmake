@@ -0,0 +1,37 @@
+# Speed test for Tile World 2
+#
+# Copyright (C) 2026 by the Tile World developers, under the GNU General
+# Public License. No warranty. See COPYING for details.
+#
+# Run with cmake -P, with TWORLD, TW_ARGS, SET, TRACE, SAVEDIR and
+# TOLERANCE defined. The solutions for SET are played back and checked
+# against a baseline trace kept in SAVEDIR, failing if the playbacks
+# are more than TOLERANCE percent slower than when the baseline was
+# written. The baseline is written by the first run on each machine,
+# and again whenever the golden trace TRACE changes. Delete it to take
+# a new measurement.
+
+file(MD5 "${TRACE}" TW_TRACE_MD5)
+set(TW_BASELINE "${SAVEDIR}/baseline-${TW_TRACE_MD5}.trace")
+
+if(NOT EXISTS "${TW_BASELINE}")
+    file(GLOB TW_OLD_BASELINES "${SAVEDIR}/baseline-*.trace")
+    if(TW_OLD_BASELINES)
+        file(REMOVE ${TW_OLD_BASELINES})
+    endif()
+    execute_process(COMMAND "${TWORLD}" ${TW_ARGS}
+                            --trace-write "${TW_BASELINE}" ${SET}
+                    RESULT_VARIABLE TW_RESULT)
+    if(NOT TW_RESULT EQUAL 0)
+        file(REMOVE "${TW_BASELINE}")
+        message(FATAL_ERROR "Cannot write the baseline ${TW_BASELINE}")
+    endif()
+endif()
+
+execute_process(COMMAND "${TWORLD}" ${TW_ARGS}
+                        --trace-check "${TW_BASELINE}"
+                        --speed-tolerance ${TOLERANCE} ${SET}
+                RESULT_VARIABLE TW_RESULT)
+if(NOT TW_RESULT EQUAL 0)
+    message(FATAL_ERROR "Playback of ${SET} fails against the baseline")
+endif()
@@ -0,0 +1,282 @@
+/* trace.c: Recording and checking tick-by-tick traces of playbacks.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<ctype.h>
+#include	"defs.h"
+#include	"err.h"
+#include	"fileio.h"
+#include	"play.h"
+#include	"trace.h"
+
+/* The number of hashes written on each line of a trace file.
+ */
+#define	HASHES_PER_LINE		8
+
+/* Traces record level hash values as 32 bits, but a level's hash
+ * value can be wider on some platforms.
+ */
+#define	tracehash(h)	((h) & 0xFFFFFFFFUL)
+
+/* The trace of one level's playback.
+ */
+typedef	struct leveltrace {
+    int			number;		/* the level's number */
+    unsigned long	levelhash;	/* the hash of the level's data */
+    int			count;		/* number of ticks in the trace */
+    int			allocated;	/* size of the hashes array */
+    unsigned long      *hashes;		/* state hash after each tick */
+} leveltrace;
+
+/* The progress of a playback being compared against its trace. A
+ * third of the way through, a snapshot of the game is saved, and two
+ * thirds of the way through, the game is rewound to it once, so that
+ * the ticks in between are checked a second time.
+ */
+typedef	struct tracecheck {
+    leveltrace const   *trace;		/* the trace being followed */
+    int			tick;		/* the number of ticks so far */
+    unsigned long	hash;		/* the state hash at the last tick */
+    int			diverged;	/* TRUE if the hashes differed */
+    gamesnapshot       *snapshot;	/* the game a third of the way in */
+    int			rewound;	/* ticks played again, or -1 */
+} tracecheck;
+
+/* Add the hash of the current game state to a trace being recorded.
+ */
+static int recordtick(void *data)
+{
+    leveltrace	       *trace = data;
+
+    if (trace->count >= trace->allocated) {
+	trace->allocated = trace->allocated ? trace->allocated * 2 : 1024;
+	x_alloc(trace->hashes, trace->allocated * sizeof *trace->hashes);
+    }
+    trace->hashes[trace->count++] = getstatehash();
+    return TRUE;
+}
+
+/* Compare the hash of the current game state with the trace, and stop
+ * the playback at the first difference.
+ */
+static int checktick(void *data)
+{
+    tracecheck	       *check = data;
+
+    check->hash = getstatehash();
+    if (check->tick >= check->trace->count
+		|| check->hash != check->trace->hashes[check->tick]) {
+	check->diverged = TRUE;
+	return FALSE;
+    }
+    ++check->tick;
+
+    if (check->trace->count < 3 || check->rewound)
+	return TRUE;
+    if (check->tick == check->trace->count / 3) {
+	check->snapshot = savegamestate();
+    } else if (check->snapshot && check->tick == check->trace->count * 2 / 3) {
+	if (!restoregamestate(check->snapshot)) {
+	    check->rewound = -1;
+	    return FALSE;
+	}
+	check->rewound = check->tick - check->trace->count / 3;
+	check->tick = check->trace->count / 3;
+    }
+    return TRUE;
+}
+
+/* Play back every solution in the series, and record the state of the
+ * game after every tick.
+ */
+int writetrace(gameseries *series, char const *filename)
+{
+    fileinfo	file;
+    leveltrace	trace;
+    verifyinfo	info;
+    gamesetup  *game;
+    double	seconds = 0.0;
+    long	ticks = 0;
+    int		f, i, n;
+
+    clearfileinfo(&file);
+    if (!fileopen(&file, filename, "w", "cannot create trace file"))
+	return FALSE;
+    batchmode = TRUE;
+
+    fprintf(file.fp, "# tworld trace of %s\n", series->filebase);
+    memset(&trace, 0, sizeof trace);
+    info.ontick = recordtick;
+    info.tickdata = &trace;
+    for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
+	trace.count = 0;
+	f = verifysolution(game, series->ruleset, &info);
+	if (f < 0)
+	    continue;
+	ticks += trace.count;
+	seconds += info.seconds;
+	fprintf(file.fp, "level %d %08lX %d\n",
+		game->number, tracehash(game->levelhash), trace.count);
+	for (n = 0 ; n < trace.count ; ++n)
+	    fprintf(file.fp, "%08lX%c", trace.hashes[n],
+		    n % HASHES_PER_LINE == HASHES_PER_LINE - 1
+				|| n == trace.count - 1 ? '\n' : ' ');
+    }
+    fprintf(file.fp, "speed %.0f\n", seconds > 0.0 ? ticks / seconds : 0.0);
+    free(trace.hashes);
+
+    if (ferror(file.fp)) {
+	errmsg(filename, "cannot write trace file");
+	fileclose(&file, NULL);
+	return FALSE;
+    }
+    fileclose(&file, "cannot write trace file");
+    return TRUE;
+}
+
+/* Read all the level traces from a trace file. FALSE is returned if
+ * the file cannot be read or is malformed.
+ */
+static int readtrace(fileinfo *file, leveltrace **traces, int *count,
+		     double *speed)
+{
+    leveltrace	       *trace = NULL;
+    char		buf[256];
+    char	       *p;
+    int			lineno, n;
+
+    *traces = NULL;
+    *count = 0;
+    *speed = 0.0;
+    for (lineno = 1 ; ; ++lineno) {
+	n = sizeof buf - 1;
+	if (!filegetline(file, buf, &n, NULL))
+	    break;
+	for (p = buf ; isspace(*p) ; ++p) ;
+	if (!*p || *p == '#')
+	    continue;
+	if (!strncmp(p, "level ", 6)) {
+	    x_alloc(*traces, (*count + 1) * sizeof **traces);
+	    trace = *traces + *count;
+	    ++*count;
+	    memset(trace, 0, sizeof *trace);
+	    if (sscanf(p + 6, "%d %lX %d", &trace->number, &trace->levelhash,
+					   &trace->allocated) != 3
+				|| trace->allocated < 0)
+		break;
+	    x_alloc(trace->hashes, (trace->allocated + 1)
+					* sizeof *trace->hashes);
+	} else if (!strncmp(p, "speed ", 6)) {
+	    *speed = atof(p + 6);
+	} else if (trace && isxdigit(*p)) {
+	    while (*p) {
+		if (trace->count >= trace->allocated)
+		    goto badline;
+		trace->hashes[trace->count++] = strtoul(p, &p, 16);
+		while (isspace(*p))
+		    ++p;
+	    }
+	} else {
+	    break;
+	}
+    }
+    if (filetestend(file))
+	return TRUE;
+
+  badline:
+    errmsg(file->name, "line %d: invalid trace data", lineno);
+    return FALSE;
+}
+
+/* Play back every solution in the series and compare it against the
+ * stored trace.
+ */
+int checktrace(gameseries *series, char const *filename, int tolerance)
+{
+    fileinfo		file;
+    leveltrace	       *traces;
+    tracecheck		check;
+    verifyinfo		info;
+    gamesetup	       *game;
+    double		seconds = 0.0, speed, baseline;
+    long		ticks = 0;
+    int			failures = 0;
+    int			count, f, i, n;
+
+    clearfileinfo(&file);
+    if (!fileopen(&file, filename, "r", "cannot open trace file"))
+	return -1;
+    f = readtrace(&file, &traces, &count, &baseline);
+    fileclose(&file, NULL);
+    if (!f) {
+	for (i = 0 ; i < count ; ++i)
+	    free(traces[i].hashes);
+	free(traces);
+	return -1;
+    }
+    batchmode = TRUE;
+
+    info.ontick = checktick;
+    info.tickdata = &check;
+    for (n = 0 ; n < count ; ++n) {
+	for (i = 0, game = series->games ; i < series->count ; ++i, ++game)
+	    if (game->number == traces[n].number)
+		break;
+	if (i == series->count
+		|| tracehash(game->levelhash) != tracehash(traces[n].levelhash)) {
+	    printf("Level %d is missing or has changed\n", traces[n].number);
+	    ++failures;
+	    continue;
+	}
+	check.trace = traces + n;
+	check.tick = 0;
+	check.diverged = FALSE;
+	check.snapshot = NULL;
+	check.rewound = 0;
+	f = verifysolution(game, series->ruleset, &info);
+	freegamesnapshot(check.snapshot);
+	if (f < 0) {
+	    printf("Level %d has no solution to play back\n", game->number);
+	    ++failures;
+	} else if (check.rewound < 0) {
+	    printf("Level %d could not be rewound to a snapshot\n",
+		   game->number);
+	    ++failures;
+	} else if (check.diverged || check.tick != traces[n].count) {
+	    if (check.tick < traces[n].count)
+		printf("Level %d diverges from the trace at tick %d:"
+		       " expected %08lX, got %08lX\n",
+		       game->number, check.tick,
+		       traces[n].hashes[check.tick], check.hash);
+	    else
+		printf("Level %d runs past the end of the trace at tick %d\n",
+		       game->number, check.tick);
+	    ++failures;
+	} else {
+	    ticks += check.tick + check.rewound;
+	    seconds += info.seconds;
+	}
+    }
+
+    speed = seconds > 0.0 ? ticks / seconds : 0.0;
+    printf("Levels checked:%5d\n", count);
+    printf("Failures:%11d\n", failures);
+    if (baseline > 0.0)
+	printf("Speed: %.0f ticks per second (%+.1f%% against the trace)\n",
+	       speed, (speed / baseline - 1.0) * 100.0);
+    if (tolerance >= 0 && baseline > 0.0 && ticks > 0
+		       && speed < baseline * (100 - tolerance) / 100.0) {
+	printf("Speed is more than %d%% below the trace\n", tolerance);
+	++failures;
+    }
+
+    for (i = 0 ; i < count ; ++i)
+	free(traces[i].hashes);
+    free(traces);
+    return failures;
+}
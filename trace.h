@@ -0,0 +1,32 @@
+/* trace.h: Recording and checking tick-by-tick traces of playbacks.
+ *
+ * Copyright (C) 2026 by the Tile World developers, under the GNU General
+ * Public License. No warranty. See COPYING for details.
+ */
+
+#ifndef	HEADER_trace_h_
+#define	HEADER_trace_h_
+
+#include	"defs.h"
+
+/* Play back every solution in the series, and write to filename the
+ * hash of the game state after every tick of each playback, together
+ * with the overall speed of the playbacks in ticks per second. FALSE
+ * is returned if the file could not be written.
+ */
+extern int writetrace(gameseries *series, char const *filename);
+
+/* Play back every solution in the series, and compare the state of
+ * the game after every tick against the trace stored in filename.
+ * Each level that departs from the trace is reported on stdout, with
+ * the first tick at which it differs. Partway through each playback,
+ * the game is also rewound to a snapshot saved earlier in it, and the
+ * ticks in between must match the trace again. If tolerance is not negative,
+ * the overall speed of the playbacks must also be within tolerance
+ * percent of the speed recorded in the trace. The return value is the
+ * number of failures, or -1 if the trace could not be read.
+ */
+extern int checktrace(gameseries *series, char const *filename,
+		      int tolerance);
+
+#endif
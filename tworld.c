@@ -8,6 +8,10 @@
 #include	<stdlib.h>
 #include	<string.h>
 #include	<ctype.h>
+#ifdef WIN32
+#include	<io.h>
+#include	<fcntl.h>
+#endif
 #include	"defs.h"
 #include	"err.h"
 #include	"series.h"
@@ -19,6 +23,10 @@
 #include	"unslist.h"
 #include	"help.h"
 #include	"oshw.h"
+#include	"server.h"
+#include	"trace.h"
+#include	"optimize.h"
+#include	"archive.h"
 #include	"cmdline.h"
 #include	"ver.h"
 
@@ -51,8 +59,30 @@ typedef	struct startupdata {
     int		listscores;	/* TRUE if the scores should be listed */
     int		listtimes;	/* TRUE if the times should be listed */
     int		batchverify;	/* TRUE to enter batch verification */
+    char const *exportdir;	/* where to write the frames of a playback */
+    int		shardindex;	/* which shard of the levels to verify */
+    int		shardcount;	/* number of shards, or zero for all levels */
+    char const **mergefiles;	/* shard results to merge into the series */
+    int		mergecount;	/* size of mergefiles */
+    char const *servepath;	/* socket to serve verification requests on */
+    int		report;		/* format of the per-level verification report */
+    char const *tracewrite;	/* where to record a trace of the playbacks */
+    char const *tracecheck;	/* a trace to compare the playbacks against */
+    int		speedtolerance;	/* allowed slowdown against the trace, or -1 */
+    int		optimize;	/* seconds to spend shortening each solution */
+    char const *archive;	/* a bulk archive of users' solutions */
+    int		archiveop;	/* what to do with the archive */
+    char const *archiveuser;	/* whose solutions in the archive to use */
 } startupdata;
 
+/* The formats in which batchverify() can describe each level.
+ */
+enum { Report_None, Report_JSON, Report_CSV };
+
+/* The things that can be done with a solution archive.
+ */
+enum { Archive_None, Archive_Add, Archive_Extract, Archive_Verify };
+
 /* History of levelsets in order of last used date/time.
  */
 static history *historylist = NULL;
@@ -155,6 +185,26 @@ static char *findstrbreak(char const **str, int maxlen, int *breakpos)
     return (char*)start;
 }
 
+/* Return the cells of the row of a table that begins with the entry
+ * at *pos, and advance *pos to the following row. If the table
+ * formats its rows on demand, *pos is simply the row number, and the
+ * cells are stored in buf.
+ */
+static char const **tablecells(tablespec const *table, int *pos,
+			       char const **buf)
+{
+    char const	      **cells;
+    int			i;
+
+    if (table->getrow) {
+	(*table->getrow)(table->source, (*pos)++, buf);
+	return buf;
+    }
+    cells = table->items + *pos;
+    for (i = 0 ; i < table->cols ; i += table->items[(*pos)++][0] - '0') ;
+    return cells;
+}
+
 /* Render a table to the given file. This function encapsulates both
  * the process of determining the necessary widths for each column of
  * the table, and then sequentially rendering the table's contents to
@@ -170,12 +220,14 @@ static char *findstrbreak(char const **str, int maxlen, int *breakpos)
 void printtable(FILE *out, tablespec const *table)
 {
     int const	maxwidth = 79;
+    char const *buf[TABLE_MAXCOLS];
+    char const **cells;
     char const *mlstr;
     char const *p;
     int	       *colsizes;
     int		mlindex, mlwidth, mlpos;
     int		diff, pos;
-    int		i, j, n, i0, c, w, z;
+    int		i, j, k, n, i0, c, w, z;
 
     if (!(colsizes = malloc(table->cols * sizeof *colsizes)))
 	return;
@@ -185,11 +237,12 @@ void printtable(FILE *out, tablespec const *table)
     mlwidth = 0;
     n = 0;
     for (j = 0 ; j < table->rows ; ++j) {
-	for (i = 0 ; i < table->cols ; ++n) {
-	    c = table->items[n][0] - '0';
+	cells = tablecells(table, &n, buf);
+	for (i = 0, k = 0 ; i < table->cols ; ++k) {
+	    c = cells[k][0] - '0';
 	    if (c == 1) {
-		w = strlen(table->items[n] + 2);
-		if (table->items[n][1] == '!') {
+		w = strlen(cells[k] + 2);
+		if (cells[k][1] == '!') {
 		    if (w > mlwidth || mlindex != i)
 			mlwidth = w;
 		    mlindex = i;
@@ -218,10 +271,11 @@ void printtable(FILE *out, tablespec const *table)
     if (diff > 0) {
 	n = 0;
 	for (j = 0 ; j < table->rows && diff > 0 ; ++j) {
-	    for (i = 0 ; i < table->cols ; ++n) {
-		c = table->items[n][0] - '0';
-		if (c > 1 && table->items[n][1] != '!') {
-		    w = table->sep + strlen(table->items[n] + 2);
+	    cells = tablecells(table, &n, buf);
+	    for (i = 0, k = 0 ; i < table->cols ; ++k) {
+		c = cells[k][0] - '0';
+		if (c > 1 && cells[k][1] != '!') {
+		    w = table->sep + strlen(cells[k] + 2);
 		    for (i0 = i ; i0 < i + c ; ++i0)
 			w -= colsizes[i0] + table->sep;
 		    if (w > 0) {
@@ -255,27 +309,28 @@ void printtable(FILE *out, tablespec const *table)
 	mlstr = NULL;
 	mlwidth = mlpos = 0;
 	pos = 0;
-	for (i = 0 ; i < table->cols ; ++n) {
+	cells = tablecells(table, &n, buf);
+	for (i = 0, k = 0 ; i < table->cols ; ++k) {
 	    if (i)
 		pos += fprintf(out, "%*s", table->sep, "");
-	    c = table->items[n][0] - '0';
+	    c = cells[k][0] - '0';
 	    w = -table->sep;
 	    while (c--)
 		w += colsizes[i++] + table->sep;
-	    if (table->items[n][1] == '-')
-		fprintf(out, "%-*.*s", w, w, table->items[n] + 2);
-	    else if (table->items[n][1] == '+')
-		fprintf(out, "%*.*s", w, w, table->items[n] + 2);
-	    else if (table->items[n][1] == '.') {
-		z = (w - strlen(table->items[n] + 2)) / 2;
+	    if (cells[k][1] == '-')
+		fprintf(out, "%-*.*s", w, w, cells[k] + 2);
+	    else if (cells[k][1] == '+')
+		fprintf(out, "%*.*s", w, w, cells[k] + 2);
+	    else if (cells[k][1] == '.') {
+		z = (w - strlen(cells[k] + 2)) / 2;
 		if (z < 0)
 		    z = w;
 		fprintf(out, "%*.*s%*s",
-			     w - z, w - z, table->items[n] + 2, z, "");
-	    } else if (table->items[n][1] == '!') {
+			     w - z, w - z, cells[k] + 2, z, "");
+	    } else if (cells[k][1] == '!') {
 		mlwidth = w;
 		mlpos = pos;
-		mlstr = table->items[n] + 2;
+		mlstr = cells[k] + 2;
 		p = findstrbreak(&mlstr, w, &z);
 		fprintf(out, "%.*s%*s", z, p, w - z, "");
 	    }
@@ -470,16 +525,16 @@ static int setcurrentgame(gamespec *gs, int n)
     return TRUE;
 }
 
-/* Change the current level by a delta value. If the user cannot go to
- * that level, the "nearest" level in that direction is chosen
- * instead. FALSE is returned if the current level remained unchanged.
+/* Find the level that is a delta value away from the current level.
+ * If the user cannot go to that level, the "nearest" level in that
+ * direction is chosen instead.
  */
-static int changecurrentgame(gamespec *gs, int offset)
+static int findrelativegame(gamespec const *gs, int offset)
 {
     int	sign, m, n;
 
     if (offset == 0)
-	return FALSE;
+	return gs->currentgame;
 
     m = gs->currentgame;
     n = m + offset;
@@ -509,7 +564,17 @@ static int changecurrentgame(gamespec *gs, int offset)
 	    }
 	}
     }
+    return n;
+}
 
+/* Change the current level by a delta value, as per the previous
+ * function. FALSE is returned if the current level remained unchanged.
+ */
+static int changecurrentgame(gamespec *gs, int offset)
+{
+    int	n;
+
+    n = findrelativegame(gs, offset);
     if (n == gs->currentgame)
 	return FALSE;
 
@@ -697,6 +762,7 @@ static int showscores(gamespec *gs)
 	    break;
     pushsubtitle(gs->series.name);
     for (;;) {
+	setlistlevels(&gs->series, levellist, count);
 	f = displaylist(gs->series.filebase, &table, &n,
 			LIST_SCORES, scorescrollinputcallback);
 	if (f == CmdProceed) {
@@ -975,6 +1041,26 @@ static int startinput(gamespec *gs)
     }
 }
 
+/* The level to get ready while the end-of-level message is showing.
+ */
+static gamesetup *prefetchsetup = NULL;
+
+/* Get the level in prefetchsetup ready to be played ahead of time.
+ * The level's number is returned, so that the user interface can load
+ * any extra data that it shows when the level starts.
+ */
+static int prefetchcallback(void)
+{
+    gamesetup  *game;
+
+    game = prefetchsetup;
+    prefetchsetup = NULL;
+    if (!game)
+	return 0;
+    prefetchgamestate(game);
+    return game->number;
+}
+
 /* Get a key command from the user at the completion of the current
  * level.
  */
@@ -1008,7 +1094,12 @@ static int endinput(gamespec *gs)
 			  &bscore, &tscore, &gscore);
     }
 
-    cmd = displayendmessage(bscore, tscore, gscore, gs->status);
+    n = gs->status > 0 ? findrelativegame(gs, +1) : gs->currentgame;
+    prefetchsetup = n >= 0 && n < gs->series.count ? gs->series.games + n
+						    : NULL;
+    cmd = displayendmessage(bscore, tscore, gscore, gs->status,
+			    prefetchcallback);
+    prefetchsetup = NULL;
 
     for (;;) {
 	if (cmd == CmdNone)
@@ -1198,11 +1289,12 @@ static int playgame(gamespec *gs, int firstcmd)
     return FALSE;
 }
 
-/* Skip past secondstoskip seconds from the beginning of the solution.
+/* Return the current level to the start of its playback. FALSE is
+ * returned if the level has no solution to play back.
  */
-static int hideandseek(gamespec *gs, int secondstoskip)
+static int restartplayback(gamespec *gs)
 {
-    int n = 0;
+    int	f;
 
     quitgamestate();
     setgameplaymode(EndPlay);
@@ -1210,9 +1302,132 @@ static int hideandseek(gamespec *gs, int secondstoskip)
     endgamestate();
     initgamestate(gs->series.games + gs->currentgame,
 		  gs->series.ruleset);
-    prepareplayback();
+    f = prepareplayback();
     gs->playmode = Play_Back;
     gs->status = 0;
+    return f;
+}
+
+/* The most ticks that the seek run is taken ahead each time the
+ * playback waits for a tick.
+ */
+#define	SEEKAHEAD_TICKS		(4 * TICKS_PER_SECOND)
+
+/* Snapshots and previews for seeking within the playback in progress.
+ * A second copy of the playback runs ahead of it a few seconds at a
+ * time, while the playback is waiting for its next tick. At each new
+ * second the run hands the display a preview and saves a snapshot, so
+ * that seeking can resume from the nearest snapshot instead of playing
+ * the solution again from the start.
+ */
+static struct {
+    gamesnapshot       *ahead;		/* where the run has got to */
+    gamesnapshot      **seconds;	/* a snapshot at each second */
+    int			count;		/* number of entries in seconds */
+    int			allocated;	/* size of the seconds array */
+    int			previews;	/* FALSE if the display has none */
+} seek = { NULL, NULL, 0, 0, FALSE };
+
+/* Discard the seek snapshots.
+ */
+static void clearseek(void)
+{
+    int	n;
+
+    for (n = 0 ; n < seek.count ; ++n)
+	freegamesnapshot(seek.seconds[n]);
+    freegamesnapshot(seek.ahead);
+    seek.ahead = NULL;
+    seek.count = 0;
+}
+
+/* Save a snapshot of the current game state for the second of play
+ * that it has just reached.
+ */
+static void addseeksnapshot(void)
+{
+    int	second;
+
+    second = secondsplayed();
+    if (second >= seek.allocated) {
+	seek.allocated = second + 64;
+	seek.seconds = realloc(seek.seconds,
+			       seek.allocated * sizeof *seek.seconds);
+	if (!seek.seconds)
+	    memerrexit();
+    }
+    while (seek.count <= second)
+	seek.seconds[seek.count++] = NULL;
+    freegamesnapshot(seek.seconds[second]);
+    seek.seconds[second] = savegamestate();
+}
+
+/* Begin a new seek run from the current game state, which should be
+ * the start of the playback.
+ */
+static void startseek(void)
+{
+    clearseek();
+    addseeksnapshot();
+    seek.ahead = savegamestate();
+    seek.previews = drawseekpreview(secondsplayed());
+}
+
+/* Take the seek run up to SEEKAHEAD_TICKS further, and then return to
+ * the playback where it was. The run only uses half of the time left
+ * before the next tick, so that the playback keeps to its timer on a
+ * slow machine, and it stops for good once the solution ends.
+ */
+static void runseekahead(void)
+{
+    gamesnapshot       *live;
+    int			seconds, idle, n = 0, i;
+
+    if (!seek.ahead)
+	return;
+    idle = ticktimeleft();
+    if (idle < 2)
+	return;
+    live = savegamestate();
+    if (!restoregamestate(seek.ahead)) {
+	freegamesnapshot(live);
+	clearseek();
+	return;
+    }
+    for (i = 0 ; i < SEEKAHEAD_TICKS && ticktimeleft() > idle / 2 ; ++i) {
+	seconds = secondsplayed();
+	n = doturn(CmdNone);
+	if (seek.previews && secondsplayed() > seconds)
+	    seek.previews = drawseekpreview(secondsplayed());
+	if (n)
+	    break;
+	advancetick();
+	if (secondsplayed() > seconds)
+	    addseeksnapshot();
+    }
+    freegamesnapshot(seek.ahead);
+    seek.ahead = n ? NULL : savegamestate();
+    restoregamestate(live);
+    freegamesnapshot(live);
+}
+
+/* Skip past secondstoskip seconds from the beginning of the solution,
+ * starting from the latest seek snapshot that is not past that point.
+ */
+static int hideandseek(gamespec *gs, int secondstoskip)
+{
+    int n = 0, i;
+
+    i = secondstoskip < seek.count ? secondstoskip : seek.count - 1;
+    if (i < 0)
+	i = 0;
+    while (i > 0 && !seek.seconds[i])
+	--i;
+    if (i >= seek.count || !seek.seconds[i]
+			|| !restoregamestate(seek.seconds[i])) {
+	restartplayback(gs);
+	startseek();
+    }
     setgameplaymode(NonrenderPlay);
 
     while (secondsplayed() < secondstoskip) {
@@ -1269,6 +1484,7 @@ static int playbackgame(gamespec *gs, int initcmd)
     int secondstoskip;
     int gamepaused = FALSE;
 
+    startseek();
     secondstoskip = getreplaysecondstoskip();
     if (secondstoskip > 0) {
 	n = hideandseek(gs, secondstoskip);
@@ -1295,6 +1511,7 @@ static int playbackgame(gamespec *gs, int initcmd)
 	    lastrendered = render;
 	    if (n)
 	        break;
+	    runseekahead();
 	    render = waitfortick() || noframeskip;
 	    cmd = input(FALSE);
 	}
@@ -1340,6 +1557,7 @@ static int playbackgame(gamespec *gs, int initcmd)
 	    break;
 	}
     }
+    clearseek();
     setdisplaymsg(NULL, 0, 0);
     if (!lastrendered)
 	drawscreen(TRUE);
@@ -1355,6 +1573,7 @@ static int playbackgame(gamespec *gs, int initcmd)
     return TRUE;
 
   quitloop:
+    clearseek();
     setdisplaymsg(NULL, 0, 0);
     if (!lastrendered)
 	drawscreen(TRUE);
@@ -1441,7 +1660,7 @@ static int runcurrentlevel(gamespec *gs)
 	changesubtitle(NULL);
 	setenddisplay();
 	drawscreen(TRUE);
-	displayendmessage(0, 0, 0, 0);
+	displayendmessage(0, 0, 0, 0, NULL);
 	endgamestate();
 	return finalinput(gs);
     }
@@ -1478,33 +1697,31 @@ static int runcurrentlevel(gamespec *gs)
     return ret;
 }
 
-static int batchverify(gameseries *series, int display)
+/* Verification results give level hash values as 32 bits, so that
+ * they agree between platforms where a level's hash value is wider.
+ */
+#define	resulthash(game)	((game)->levelhash & 0xFFFFFFFFUL)
+
+/* Print the results of a batch verification. status holds, for each
+ * level in the series, 0 if it has no solution that could be played
+ * back, 1 if its solution is valid, and -1 if it is invalid. The
+ * number of invalid solutions is returned.
+ */
+static int reportverify(gameseries const *series, signed char const *status,
+			int display)
 {
-    gamesetup  *game;
     int		valid = 0, invalid = 0;
-    int		i, f;
-
-    batchmode = TRUE;
+    int		i;
 
-    for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
-	if (!hassolution(game))
-	    continue;
-	if (initgamestate(game, series->ruleset) && prepareplayback()) {
-	    setgameplaymode(NonrenderPlay);
-	    while (!(f = doturn(CmdNone)))
-		advancetick();
-	    setgameplaymode(EndPlay);
-	    if (f > 0) {
-		++valid;
-		checksolution();
-	    } else {
-		++invalid;
-		game->sgflags |= SGF_REPLACEABLE;
-		if (display)
-		    printf("Solution for level %d is invalid\n", game->number);
-	    }
+    for (i = 0 ; i < series->count ; ++i) {
+	if (status[i] > 0) {
+	    ++valid;
+	} else if (status[i] < 0) {
+	    ++invalid;
+	    if (display)
+		printf("Solution for level %d is invalid\n",
+		       series->games[i].number);
 	}
-	endgamestate();
     }
 
     if (display) {
@@ -1518,6 +1735,175 @@ static int batchverify(gameseries *series, int display)
     return invalid;
 }
 
+/* Write a record of one level's verification to stdout in the given
+ * report format. A header precedes the first CSV record.
+ */
+static void writereportrecord(int report, gameseries const *series,
+			      gamesetup const *game, int valid,
+			      verifyinfo const *info)
+{
+    static char const *timingnames[] = {
+	"none", "clock-offset", "off-by-one", "unknown"
+    };
+    static int	headerwritten = FALSE;
+    char	recorded[16];
+    double	rate;
+
+    rate = info->seconds > 0.0 ? info->ticks / info->seconds : 0.0;
+    if (report == Report_JSON) {
+	if (info->besttime == TIME_NIL)
+	    strcpy(recorded, "null");
+	else
+	    sprintf(recorded, "%d", info->besttime);
+	printf("{\"level\":%d,\"hash\":\"%08lX\",\"ruleset\":\"%s\","
+	       "\"recorded\":%s,\"replayed\":%d,\"result\":\"%s\","
+	       "\"fix\":\"%s\",\"seconds\":%.6f,\"ticks_per_second\":%.0f}\n",
+	       game->number, resulthash(game),
+	       series->ruleset == Ruleset_MS ? "ms" : "lynx",
+	       recorded, info->ticks, valid ? "valid" : "invalid",
+	       timingnames[info->timing], info->seconds, rate);
+    } else if (report == Report_CSV) {
+	if (!headerwritten) {
+	    puts("level,hash,ruleset,recorded,replayed,result,fix,"
+		 "seconds,ticks_per_second");
+	    headerwritten = TRUE;
+	}
+	if (info->besttime == TIME_NIL)
+	    *recorded = '\0';
+	else
+	    sprintf(recorded, "%d", info->besttime);
+	printf("%d,%08lX,%s,%s,%d,%s,%s,%.6f,%.0f\n",
+	       game->number, resulthash(game),
+	       series->ruleset == Ruleset_MS ? "ms" : "lynx",
+	       recorded, info->ticks, valid ? "valid" : "invalid",
+	       timingnames[info->timing], info->seconds, rate);
+    }
+}
+
+/* Play back every solution in the series, noting which are invalid
+ * and correcting the times of the valid ones. If shardcount is
+ * nonzero, only the levels whose hash values fall into the given
+ * shard are checked, and the results are written to stdout in the
+ * form read by mergeverify(), instead of the usual summary. If report
+ * is not Report_None, a record for each level is written to stdout in
+ * that format, likewise in place of the summary.
+ */
+static int batchverify(gameseries *series, int display,
+		       int shardindex, int shardcount, int report)
+{
+    gamesetup	       *game;
+    signed char	       *status;
+    verifyinfo		info;
+    int			invalid = 0;
+    int			i, f;
+
+    batchmode = TRUE;
+
+    info.ontick = NULL;
+    status = calloc(series->count + 1, sizeof *status);
+    if (!status)
+	memerrexit();
+    if (shardcount)
+	printf("# shard %d/%d of %s\n", shardindex, shardcount,
+	       series->filebase);
+
+    for (i = 0, game = series->games ; i < series->count ; ++i, ++game) {
+	if (shardcount && (int)(resulthash(game) % shardcount) != shardindex - 1)
+	    continue;
+	f = verifysolution(game, series->ruleset, &info);
+	if (f >= 0 && report != Report_None)
+	    writereportrecord(report, series, game, f, &info);
+	if (f > 0) {
+	    status[i] = 1;
+	    if (shardcount)
+		printf("%d: %08lX: valid %d\n",
+		       game->number, resulthash(game), game->besttime);
+	} else if (f == 0) {
+	    status[i] = -1;
+	    game->sgflags |= SGF_REPLACEABLE;
+	    if (shardcount)
+		printf("%d: %08lX: invalid\n", game->number, resulthash(game));
+	}
+    }
+
+    if (shardcount || report != Report_None) {
+	for (i = 0 ; i < series->count ; ++i)
+	    if (status[i] < 0)
+		++invalid;
+    } else {
+	invalid = reportverify(series, status, display);
+    }
+    free(status);
+    return invalid;
+}
+
+/* Fold the results written by sharded runs of batchverify() back into
+ * the series, and save the corrected solutions. A result is applied
+ * only if the level's data still has the hash value that was
+ * verified. The return value is the number of invalid solutions, or
+ * -1 if a results file could not be read.
+ */
+static int mergeverify(gameseries *series, char const * const *files,
+		       int filecount, int display)
+{
+    fileinfo		file;
+    gamesetup	       *game;
+    char		buf[256], token[256];
+    char const	       *p;
+    signed char	       *status;
+    unsigned long	hashval;
+    int			besttime, levelnum, lineno, i, n;
+
+    status = calloc(series->count + 1, sizeof *status);
+    if (!status)
+	memerrexit();
+
+    for (i = 0 ; i < filecount ; ++i) {
+	clearfileinfo(&file);
+	if (!fileopen(&file, files[i], "r", "cannot open results file")) {
+	    free(status);
+	    return -1;
+	}
+	for (lineno = 1 ; ; ++lineno) {
+	    n = sizeof buf - 1;
+	    if (!filegetline(&file, buf, &n, NULL))
+		break;
+	    for (p = buf ; isspace(*p) ; ++p) ;
+	    if (!*p || *p == '#')
+		continue;
+	    besttime = TIME_NIL;
+	    if (sscanf(p, "%d: %lX: %255s %d",
+			  &levelnum, &hashval, token, &besttime) < 3
+			|| (strcmp(token, "valid") && strcmp(token, "invalid"))) {
+		warn("%s:%d: syntax error", file.name, lineno);
+		continue;
+	    }
+	    hashval &= 0xFFFFFFFFUL;
+	    n = findlevelinseries(series, levelnum, NULL);
+	    if (n < 0 || resulthash(series->games + n) != hashval) {
+		warn("%s:%d: level %d has changed since it was verified",
+		     file.name, lineno, levelnum);
+		continue;
+	    }
+	    game = series->games + n;
+	    if (!strcmp(token, "valid")) {
+		status[n] = 1;
+		if (besttime != TIME_NIL)
+		    setsolutiontime(game, besttime);
+	    } else {
+		status[n] = -1;
+		game->sgflags |= SGF_REPLACEABLE;
+	    }
+	}
+	fileclose(&file, NULL);
+    }
+
+    n = reportverify(series, status, display);
+    free(status);
+    savesolutions(series);
+    return n;
+}
+
 /*
  * Game selection functions
  */
@@ -1571,6 +1957,7 @@ static void findlevelfromhistory(gamespec *gs, char const *name)
     (table).sep = 0; \
     (table).collapse = 0; \
     (table).items = _ptrs; \
+    (table).getrow = NULL; \
 } while (0)
 
 #ifdef TWPLUSPLUS
@@ -1866,6 +2253,38 @@ static void initdirs(char const *series, char const *seriesdat,
     }
 }
 
+/* Return the value of the current cmdline option if it is the long
+ * option --name, given either as --name=value or as --name followed
+ * by the value. NULL is returned if the option is something else.
+ */
+static char const *getlongoption(cmdlineinfo *opts, char const *name)
+{
+    size_t	n = strlen(name);
+
+    if (strncmp(opts->val + 2, name, n))
+	return NULL;
+    if (opts->val[2 + n] == '=')
+	return opts->val + 3 + n;
+    if (!opts->val[2 + n] && !skipoption(opts))
+	return opts->val;
+    return NULL;
+}
+
+/* Record which archive operation was requested, and for whom. Only
+ * one can be given.
+ */
+static int setarchiveop(startupdata *start, int op, char const *user)
+{
+    if (start->archiveop != Archive_None) {
+	fprintf(stderr, "only one of --archive-add, --archive-extract and"
+			" --archive-verify can be used\n");
+	return FALSE;
+    }
+    start->archiveop = op;
+    start->archiveuser = user;
+    return TRUE;
+}
+
 /* Parse the command-line options and arguments, and initialize the
  * user-controlled options.
  */
@@ -1879,6 +2298,7 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
     char	buf[256];
     int		listdirs, pedantic;
     int		ch, n;
+    char const *optval;
     char       *p;
 
     start->filename = getpathbuffer();
@@ -1889,13 +2309,29 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
     start->listscores = FALSE;
     start->listtimes = FALSE;
     start->batchverify = FALSE;
+    start->exportdir = NULL;
+    start->shardindex = 0;
+    start->shardcount = 0;
+    start->mergefiles = malloc(argc * sizeof *start->mergefiles);
+    if (!start->mergefiles)
+	memerrexit();
+    start->mergecount = 0;
+    start->servepath = NULL;
+    start->report = Report_None;
+    start->tracewrite = NULL;
+    start->tracecheck = NULL;
+    start->speedtolerance = -1;
+    start->optimize = 0;
+    start->archive = NULL;
+    start->archiveop = Archive_None;
+    start->archiveuser = NULL;
     listdirs = FALSE;
     pedantic = FALSE;
     mudsucking = 1;
     soundbufsize = 0;
     volumelevel = -1;
 
-    initoptions(&opts, argc - 1, argv + 1, "abD:dFfHhL:lm:n:PpqR:rS:stVv");
+    initoptions(&opts, argc - 1, argv + 1, "abD:dE:FfHhL:lm:n:PpqR:rS:stVv");
     while ((ch = readoption(&opts)) >= 0) {
 	switch (ch) {
 	  case 0:
@@ -1916,6 +2352,7 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
 	    }
 	    break;
 	  case 'D':	optseriesdatdir = opts.val;			break;
+	  case 'E':	start->exportdir = opts.val;			break;
 	  case 'L':	optseriesdir = opts.val;			break;
 	  case 'R':	optresdir = opts.val;				break;
 	  case 'S':	optsavedir = opts.val;				break;
@@ -1937,6 +2374,69 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
 	  case 'h':	printtable(stdout, yowzitch); 	   exit(EXIT_SUCCESS);
 	  case 'v':	puts(VERSION);		 	   exit(EXIT_SUCCESS);
 	  case 'V':	printtable(stdout, vourzhon); 	   exit(EXIT_SUCCESS);
+	  case '-':
+	    if ((optval = getlongoption(&opts, "shard"))) {
+		if (sscanf(optval, "%d/%d%c", &start->shardindex,
+				   &start->shardcount, buf) != 2
+				|| start->shardindex < 1
+				|| start->shardindex > start->shardcount) {
+		    fprintf(stderr, "invalid shard: %s\n", optval);
+		    return FALSE;
+		}
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "merge"))) {
+		start->mergefiles[start->mergecount++] = optval;
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "serve"))) {
+		start->servepath = optval;
+	    } else if ((optval = getlongoption(&opts, "report"))) {
+		if (!strcmp(optval, "json")) {
+		    start->report = Report_JSON;
+		} else if (!strcmp(optval, "csv")) {
+		    start->report = Report_CSV;
+		} else {
+		    fprintf(stderr, "invalid report format: %s\n", optval);
+		    return FALSE;
+		}
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "trace-write"))) {
+		start->tracewrite = optval;
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "trace-check"))) {
+		start->tracecheck = optval;
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "speed-tolerance"))) {
+		if (sscanf(optval, "%d%c", &start->speedtolerance, buf) != 1
+				|| start->speedtolerance < 0
+				|| start->speedtolerance > 100) {
+		    fprintf(stderr, "invalid speed tolerance: %s\n", optval);
+		    return FALSE;
+		}
+	    } else if ((optval = getlongoption(&opts, "optimize"))) {
+		if (sscanf(optval, "%d%c", &start->optimize, buf) != 1
+				|| start->optimize <= 0) {
+		    fprintf(stderr, "invalid time limit: %s\n", optval);
+		    return FALSE;
+		}
+		start->batchverify = TRUE;
+	    } else if ((optval = getlongoption(&opts, "archive"))) {
+		start->archive = optval;
+	    } else if ((optval = getlongoption(&opts, "archive-add"))) {
+		if (!setarchiveop(start, Archive_Add, optval))
+		    return FALSE;
+	    } else if ((optval = getlongoption(&opts, "archive-extract"))) {
+		if (!setarchiveop(start, Archive_Extract, optval))
+		    return FALSE;
+	    } else if ((optval = getlongoption(&opts, "archive-verify"))) {
+		if (!setarchiveop(start, Archive_Verify, optval))
+		    return FALSE;
+		start->batchverify = TRUE;
+	    } else {
+		fprintf(stderr, "unrecognized option: %s\n", opts.val);
+		printtable(stderr, yowzitch);
+		return FALSE;
+	    }
+	    break;
 	  case ':':
 	    fprintf(stderr, "option requires an argument: -%c\n", opts.opt);
 	    printtable(stderr, yowzitch);
@@ -1951,8 +2451,62 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
 	}
     }
 
+    if (start->shardcount && start->mergecount) {
+	fprintf(stderr, "--shard and --merge cannot be used together\n");
+	return FALSE;
+    }
+    if (start->report != Report_None
+			&& (start->shardcount || start->mergecount)) {
+	fprintf(stderr, "--report cannot be used with --shard or --merge\n");
+	return FALSE;
+    }
+    if ((start->tracewrite || start->tracecheck)
+			&& (start->shardcount || start->mergecount
+						|| start->report != Report_None)) {
+	fprintf(stderr, "--trace-write and --trace-check cannot be used"
+			" with --shard, --merge or --report\n");
+	return FALSE;
+    }
+    if (start->tracewrite && start->tracecheck) {
+	fprintf(stderr, "--trace-write and --trace-check cannot be used"
+			" together\n");
+	return FALSE;
+    }
+    if (start->optimize && (start->shardcount || start->mergecount
+					   || start->report != Report_None
+					   || start->tracewrite
+					   || start->tracecheck)) {
+	fprintf(stderr, "--optimize cannot be used with --shard, --merge,"
+			" --report or a trace\n");
+	return FALSE;
+    }
+    if (start->speedtolerance >= 0 && !start->tracecheck) {
+	fprintf(stderr, "--speed-tolerance requires --trace-check\n");
+	return FALSE;
+    }
+    if (!start->archive != (start->archiveop == Archive_None)) {
+	fprintf(stderr, "--archive must be used with one of --archive-add,"
+			" --archive-extract or --archive-verify\n");
+	return FALSE;
+    }
+    if ((start->archiveop == Archive_Add
+			|| start->archiveop == Archive_Extract)
+		&& start->batchverify) {
+	fprintf(stderr, "--archive-add and --archive-extract cannot be used"
+			" with -b\n");
+	return FALSE;
+    }
+    if (start->archiveop == Archive_Verify
+			&& (start->mergecount || start->optimize)) {
+	fprintf(stderr, "--archive-verify cannot be used with --merge"
+			" or --optimize\n");
+	return FALSE;
+    }
+
     if (pedantic)
 	setpedanticmode();
+    if (start->exportdir)
+	silence = TRUE;
 
     initdirs(optseriesdir, optseriesdatdir, optresdir, optsavedir);
     if (listdirs) {
@@ -1969,13 +2523,67 @@ static int initoptionswithcmdline(int argc, char *argv[], startupdata *start)
     }
 
     if (start->listscores || start->listtimes || start->batchverify
-					      || start->levelnum)
+			  || start->exportdir || start->levelnum
+			  || start->archive)
 	if (!*start->filename)
 	    strcpy(start->filename, "chips.dat");
 
     return TRUE;
 }
 
+/* Play back the solution for the given level as fast as possible,
+ * rendering every tick and writing each frame to an image file in
+ * the directory dir. FALSE is returned if the level has no solution,
+ * or if any frame could not be written.
+ */
+static int exportframes(gameseries *series, int levelnum, char const *dir)
+{
+    char	name[16];
+    char       *path;
+    int		frame, n, f;
+
+    if (!levelnum) {
+	errmsg(NULL, "a level must be named to export frames");
+	return FALSE;
+    }
+    n = findlevelinseries(series, levelnum, NULL);
+    if (n < 0) {
+	errmsg(series->filebase, "no level %d to export", levelnum);
+	return FALSE;
+    }
+    if (!initgamestate(series->games + n, series->ruleset)
+				|| !prepareplayback()) {
+	errmsg(series->filebase, "level %d has no solution to export",
+				 levelnum);
+	return FALSE;
+    }
+
+    path = getpathbuffer();
+    setgameplaymode(NonrenderPlay);
+    f = TRUE;
+    for (frame = 0 ; ; ++frame) {
+	n = doturn(CmdNone);
+	drawscreen(TRUE);
+	sprintf(name, "%06d", frame);
+	if (!combinepath(path, dir, name) || !saveframe(path)) {
+	    errmsg(path, "cannot write frame");
+	    f = FALSE;
+	    break;
+	}
+	if (n)
+	    break;
+	advancetick();
+    }
+    if (!finishframes()) {
+	errmsg(dir, "some frames could not be written");
+	f = FALSE;
+    }
+    setgameplaymode(EndPlay);
+    endgamestate();
+    free(path);
+    return f;
+}
+
 /* Run the initialization routines of oshw and the resource module.
  */
 static int initializesystem(void)
@@ -2028,7 +2636,8 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
 {
     seriesdata	series;
     tablespec	table;
-    int		n;
+    fileinfo	file;
+    int		f, n;
 
     if (!createserieslist(start->filename,
 			  &series.list, &series.count,
@@ -2043,6 +2652,10 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
 	return -1;
     }
 
+    if (start->servepath)
+	return runverifyserver(start->servepath, series.list, series.count)
+			? 0 : -1;
+
     if (start->listseries) {
 	printtable(stdout, &series.table);
 	if (!series.count)
@@ -2057,10 +2670,44 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
 	    errmsg(series.list[0].filebase, "cannot read level set");
 	    return -1;
 	}
+	if (start->archiveop == Archive_Add)
+	    return addtoarchive(start->archive, series.list,
+				start->archiveuser) ? 0 : -1;
+	if (start->archiveop == Archive_Extract) {
+	    clearfileinfo(&file);
+	    file.name = "stdout";
+	    file.fp = stdout;
+#ifdef WIN32
+	    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+	    return extractfromarchive(start->archive, series.list,
+				      start->archiveuser, &file) ? 0 : -1;
+	}
+	if (start->archiveop == Archive_Verify
+			&& !loadfromarchive(start->archive, series.list,
+					    start->archiveuser))
+	    return -1;
 	if (start->batchverify) {
-	    n = batchverify(series.list, !silence && !start->listtimes
-						  && !start->listscores);
-	    if (silence)
+	    f = !silence && !start->listtimes && !start->listscores;
+	    if (start->optimize)
+		n = optimizesolutions(series.list, start->optimize) < 0 ? -1 : 0;
+	    else if (start->tracewrite)
+		n = writetrace(series.list, start->tracewrite) ? 0 : -1;
+	    else if (start->tracecheck)
+		n = checktrace(series.list, start->tracecheck,
+			       start->speedtolerance);
+	    else if (start->mergecount)
+		n = mergeverify(series.list, start->mergefiles,
+				start->mergecount, f);
+	    else
+		n = batchverify(series.list, f,
+				start->shardindex, start->shardcount,
+				start->report);
+	    if (n < 0)
+		return -1;
+	    if (silence || start->shardcount || start->report != Report_None
+			|| start->tracewrite || start->tracecheck
+			|| start->optimize)
 		exit(n > 100 ? 100 : n);
 	    else if (!start->listtimes && !start->listscores)
 		return 0;
@@ -2069,10 +2716,10 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
 	    if (!createscorelist(series.list, usepasswds, '0',
 				 NULL, NULL, &table))
 		return -1;
-	    freeserieslist(series.list, series.count,
-		series.mflist, series.mfcount, &series.table);
 	    printtable(stdout, &table);
 	    freescorelist(NULL, &table);
+	    freeserieslist(series.list, series.count,
+		series.mflist, series.mfcount, &series.table);
 	    return 0;
 	}
 	if (start->listtimes) {
@@ -2080,14 +2727,19 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
 				series.list->ruleset == Ruleset_MS ? 10 : 100,
 				'0', NULL, NULL, &table))
 		return -1;
-	    freeserieslist(series.list, series.count,
-		series.mflist, series.mfcount, &series.table);
 	    printtable(stdout, &table);
 	    freetimelist(NULL, &table);
+	    freeserieslist(series.list, series.count,
+		series.mflist, series.mfcount, &series.table);
 	    return 0;
 	}
     }
 
+    if (start->archive) {
+	errmsg(NULL, "a single level set must be named to use an archive");
+	return -1;
+    }
+
     if (!initializesystem()) {
 	errmsg(NULL, "cannot initialize program due to previous errors");
 	return -1;
@@ -2097,6 +2749,15 @@ static int choosegameatstartup(gamespec *gs, char const *lastseries,
     if (series.count == 1)
     	readextensions(series.list);
 
+    if (start->exportdir) {
+	if (series.count != 1) {
+	    errmsg(NULL, "a single level set must be named to export frames");
+	    return -1;
+	}
+	return exportframes(series.list, start->levelnum, start->exportdir)
+			? 0 : -1;
+    }
+
     return selectseriesandlevel(gs, &series, TRUE, lastseries, start->levelnum);
 }
 
@@ -2127,8 +2788,11 @@ int tworld(int argc, char *argv[])
 
     if (getintsetting("showinitstate") > 0)
 	toggleshowinitstate();
+    if (getintsetting("mousenavigation") > 0)
+	setmousenavigation(TRUE);
 
     f = choosegameatstartup(&spec, lastseries, &start);
+    free(start.mergefiles);
     if (f < 0)
 	return EXIT_FAILURE;
     else if (f == 0)
@@ -26,6 +26,12 @@ typedef	struct unslistentry {
     int			note;		/* the entry's annotation ID, if any */
 } unslistentry;
 
+/* The list file records hash values as 32 bits, but a level's hash
+ * value can be wider on some platforms, so only the low 32 bits of
+ * it are compared.
+ */
+#define	listhash(h)	((h) & 0xFFFFFFFFUL)
+
 /* The pool of strings. In here are stored the level set names and the
  * annotations. The string IDs are simple offsets from the strings
  * pointer.
@@ -42,12 +48,64 @@ static int		namescount = 0;
 static int		namesallocated = 0;
 static int	       *names = NULL;
 
+/* A hash table of the level set names. Each slot holds an index into
+ * names, or -1 if it is empty. The size is always a power of two.
+ */
+static int		namesindexsize = 0;
+static int	       *namesindex = NULL;
+
 /* The list of unsolvable levels proper.
  */
 static int		listcount = 0;
 static int		listallocated = 0;
 static unslistentry    *unslist = NULL;
 
+/* A hash table of the list entries, keyed on the level number, size,
+ * and hash value. Each slot holds an index into unslist, or -1 if it
+ * is empty, and the size is always a power of two. The table is only
+ * rebuilt when it is next needed after the list has changed.
+ */
+static int		listindexsize = 0;
+static int	       *listindex = NULL;
+static int		listindexstale = TRUE;
+
+/*
+ * Hashing functions.
+ */
+
+/* Return the hash value of a string.
+ */
+static unsigned long hashstring(char const *str)
+{
+    unsigned long	h = 5381;
+
+    while (*str)
+	h = (h * 33) ^ (unsigned char)*str++;
+    return h;
+}
+
+/* Return the hash value of the key identifying a level.
+ */
+static unsigned long hashlevel(int levelnum, int size, unsigned long hashval)
+{
+    unsigned long	h;
+
+    h = hashval ^ ((unsigned long)levelnum * 2654435761UL)
+		^ ((unsigned long)size << 16);
+    return h ^ (h >> 16);
+}
+
+/* Return the size for a hash table holding count items, which keeps
+ * the table no more than half full.
+ */
+static int indexsizefor(int count)
+{
+    int	n;
+
+    for (n = 16 ; n < count * 2 ; n *= 2) ;
+    return n;
+}
+
 /*
  * Managing the pool of strings.
  */
@@ -89,11 +147,15 @@ static int storestring(char const *str)
  */
 static int lookupsetname(char const *name, int add)
 {
-    int	i;
+    int	mask, slot, i;
 
-    for (i = 0 ; i < namescount ; ++i)
-	if (!strcmp(getstring(names[i]), name))
-	    return names[i];
+    mask = namesindexsize - 1;
+    if (namesindexsize) {
+	for (slot = hashstring(name) & mask ; namesindex[slot] >= 0
+					     ; slot = (slot + 1) & mask)
+	    if (!strcmp(getstring(names[namesindex[slot]]), name))
+		return names[namesindex[slot]];
+    }
     if (!add)
 	return 0;
 
@@ -101,8 +163,25 @@ static int lookupsetname(char const *name, int add)
 	namesallocated = namesallocated ? 2 * namesallocated : 8;
 	x_alloc(names, namesallocated * sizeof *names);
     }
-    names[namescount] = storestring(name);
-    return names[namescount++];
+    names[namescount++] = storestring(name);
+
+    if (indexsizefor(namescount) > namesindexsize) {
+	namesindexsize = indexsizefor(namescount);
+	x_alloc(namesindex, namesindexsize * sizeof *namesindex);
+	for (i = 0 ; i < namesindexsize ; ++i)
+	    namesindex[i] = -1;
+	i = 0;
+    } else {
+	i = namescount - 1;
+    }
+    mask = namesindexsize - 1;
+    for ( ; i < namescount ; ++i) {
+	slot = hashstring(getstring(names[i])) & mask;
+	while (namesindex[slot] >= 0)
+	    slot = (slot + 1) & mask;
+	namesindex[slot] = i;
+    }
+    return names[namescount - 1];
 }
 
 /*
@@ -121,9 +200,10 @@ static int addtounslist(int setid, int levelnum,
     unslist[listcount].setid = setid;
     unslist[listcount].levelnum = levelnum;
     unslist[listcount].size = size;
-    unslist[listcount].hashval = hashval;
+    unslist[listcount].hashval = listhash(hashval);
     unslist[listcount].note = note;
     ++listcount;
+    listindexstale = TRUE;
     return TRUE;
 }
 
@@ -138,12 +218,65 @@ static int removefromunslist(int setid, int levelnum)
 	if (unslist[i].setid == setid && unslist[i].levelnum == levelnum) {
 	    --listcount;
 	    unslist[i] = unslist[listcount];
+	    --i;
 	    f = TRUE;
 	}
     }
+    if (f)
+	listindexstale = TRUE;
     return f;
 }
 
+/* Rebuild the hash table of list entries. Entries with the same key
+ * are inserted in list order, so a probe meets them in that order.
+ */
+static void buildlistindex(void)
+{
+    int	mask, slot, i;
+
+    if (indexsizefor(listcount) != listindexsize) {
+	listindexsize = indexsizefor(listcount);
+	x_alloc(listindex, listindexsize * sizeof *listindex);
+    }
+    for (i = 0 ; i < listindexsize ; ++i)
+	listindex[i] = -1;
+    mask = listindexsize - 1;
+    for (i = 0 ; i < listcount ; ++i) {
+	slot = hashlevel(unslist[i].levelnum, unslist[i].size,
+			 unslist[i].hashval) & mask;
+	while (listindex[slot] >= 0)
+	    slot = (slot + 1) & mask;
+	listindex[slot] = i;
+    }
+    listindexstale = FALSE;
+}
+
+/* Return the first entry in the list for the given level, or NULL if
+ * there is none. If setid is zero, entries for any level set match.
+ */
+static unslistentry const *findinunslist(int setid, gamesetup const *game)
+{
+    unslistentry const *entry;
+    int			mask, slot;
+
+    if (!listcount)
+	return NULL;
+    if (listindexstale)
+	buildlistindex();
+    mask = listindexsize - 1;
+    slot = hashlevel(game->number, game->levelsize,
+		     listhash(game->levelhash)) & mask;
+    for ( ; listindex[slot] >= 0 ; slot = (slot + 1) & mask) {
+	entry = unslist + listindex[slot];
+	if (entry->levelnum == game->number
+			&& entry->size == game->levelsize
+			&& entry->hashval == listhash(game->levelhash)
+			&& (!setid || entry->setid == setid))
+	    return entry;
+    }
+    return NULL;
+}
+
 /* Add the information in the given file to the list of unsolvable
  * levels. Errors in the file are flagged but do not prevent the
  * function from reading the rest of the file.
@@ -199,18 +332,14 @@ static int readunslist(fileinfo *file)
  */
 int islevelunsolvable(gamesetup const *game, char *note)
 {
-    int		i;
+    unslistentry const *entry;
 
-    for (i = 0 ; i < listcount ; ++i) {
-	if (unslist[i].levelnum == game->number
-		      && unslist[i].size == game->levelsize
-		      && unslist[i].hashval == game->levelhash) {
-	    if (note)
-		strcpy(note, getstring(unslist[i].note));
-	    return TRUE;
-	}
-    }
-    return FALSE;
+    entry = findinunslist(0, game);
+    if (!entry)
+	return FALSE;
+    if (note)
+	strcpy(note, getstring(entry->note));
+    return TRUE;
 }
 
 /* Look up the levels that constitute the given series and find which
@@ -219,8 +348,9 @@ int islevelunsolvable(gamesetup const *game, char *note)
  */
 int markunsolvablelevels(gameseries *series)
 {
-    int		count = 0;
-    int		setid, i, j;
+    unslistentry const *entry;
+    int			count = 0;
+    int			setid, j;
 
     for (j = 0 ; j < series->count ; ++j)
 	series->games[j].unsolvable = NULL;
@@ -229,17 +359,11 @@ int markunsolvablelevels(gameseries *series)
     if (!setid)
 	return 0;
 
-    for (i = 0 ; i < listcount ; ++i) {
-	if (unslist[i].setid != setid)
-	    continue;
-	for (j = 0 ; j < series->count ; ++j) {
-	    if (series->games[j].number == unslist[i].levelnum
-			&& series->games[j].levelsize == unslist[i].size
-			&& series->games[j].levelhash == unslist[i].hashval) {
-		series->games[j].unsolvable = getstring(unslist[i].note);
-		++count;
-		break;
-	    }
+    for (j = 0 ; j < series->count ; ++j) {
+	entry = findinunslist(setid, series->games + j);
+	if (entry) {
+	    series->games[j].unsolvable = getstring(entry->note);
+	    ++count;
 	}
     }
     return count;
@@ -276,11 +400,20 @@ void clearunslist(void)
     listallocated = 0;
     unslist = NULL;
 
+    free(listindex);
+    listindexsize = 0;
+    listindex = NULL;
+    listindexstale = TRUE;
+
     free(names);
     namescount = 0;
     namesallocated = 0;
     names = NULL;
 
+    free(namesindex);
+    namesindexsize = 0;
+    namesindex = NULL;
+
     free(strings);
     stringsused = 0;
     stringsallocated = 0;